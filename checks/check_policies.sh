@@ -0,0 +1,51 @@
+#!/bin/bash
+#
+#  Memory Simulator policy check
+#  Replays checks/policies.txt (96 references over 24 blocks of 4 bytes) through the simulator's CSV
+#  output on several cache geometries and compares the hit counts of LRU, FIFO and OPT, and the OPT
+#  bound of --optimal, with counts worked out independently of the simulator.
+#
+#  Run:		checks/check_policies.sh ./Lab7.out
+#
+
+simulator=${1:?"Usage: $0 <simulator binary>"}
+trace="$(dirname "$0")/policies.txt"
+failures=0
+
+# Prints the value of a named column of the simulator's CSV result
+column() {
+	awk -F, -v name="$1" 'NR == 1 {for(i = 1; i <= NF; i++) if($i == name) field = i} NR == 2 {print $field}'
+}
+
+# cache size, ways, then the expected LRU, FIFO and OPT hits
+while read cache ways lru fifo opt; do
+	for policy in LRU FIFO OPT; do
+		case $policy in
+			LRU) expected=$lru ;;
+			FIFO) expected=$fifo ;;
+			OPT) expected=$opt ;;
+		esac
+		result=$("$simulator" --trace "$trace" --memory 256 --cache "$cache" --block 4 --ways "$ways" \
+				 --policy "$policy" --format csv --optimal)
+		hits=$(column hits <<< "$result")
+		optimal=$(column optimal_hits <<< "$result")
+		if [ "$hits" != "$expected" ] || [ "$optimal" != "$opt" ]; then
+			echo "FAILED: $cache byte cache, $ways-way, $policy: $hits hits (expected $expected)," \
+				 "OPT bound $optimal (expected $opt)"
+			failures=$((failures + 1))
+		fi
+	done
+done <<CASES
+32 1 44 44 44
+32 2 47 45 55
+32 8 46 44 62
+16 4 24 22 44
+64 4 69 63 72
+CASES
+
+if [ $failures -eq 0 ]; then
+	echo "Policy check passed"
+	exit 0
+fi
+echo "Policy check failed: $failures of 15 runs"
+exit 1
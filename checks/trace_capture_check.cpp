@@ -0,0 +1,295 @@
+/*
+  Memory Simulator trace capture check
+  Captures known references through trace_capture.h, decodes the traces written and checks that
+  every reference arrived in order with the right counts: a single thread through a tiny ring (so it
+  keeps waiting for the flusher), with fetches, raw records and sampling, the highest addresses and
+  largest deltas records allow, then 70 short-lived threads and a thread outliving the first of two
+  captures in one process.
+
+  Build:	g++ -std=c++11 -O1 -g -pthread -I. checks/trace_capture_check.cpp trace_capture.cpp -o check
+  			(add -fsanitize=thread or -fsanitize=address to check the rings for races or leaks)
+  Run:		./check [directory for the traces, default /tmp]
+*/
+
+#include "trace_capture.h"
+
+#include <atomic>									// Imported for stopping the long-lived thread
+#include <cstdio>									// Imported for reading traces and reporting
+#include <cstring>									// Imported for raw memory operations (memcpy)
+#include <string>									// Imported for file names and errors
+#include <thread>									// Imported for the capturing threads (thread)
+#include <vector>									// Imported for references and threads (vector)
+
+using namespace std;
+
+const int SHORT_THREADS = 70;						// More threads than the trace has cores
+const int SHORT_THREAD_REFERENCES = 20000;
+const uint64_t THREAD_STRIDE = (uint64_t)1 << 32;	// Each short thread's addresses start here apart
+
+/*****************************************************************************
+Struct name:      Reference
+Purpose:          One reference decoded from a trace
+******************************************************************************/
+struct Reference {
+	uint64_t address;								// The byte address referenced
+	int operation;									// TRACE_CAPTURE_READ, _WRITE or _FETCH
+	int core;										// The core stored with it, or 0
+};
+
+static int failures = 0;
+
+/*****************************************************************************
+Function name:    check
+Purpose:          Reports a failed condition
+Input parameters: condition - bool - whether the check passed
+                  description - const string& - what was checked
+Return value:     none
+******************************************************************************/
+static void check(bool condition, const string& description) {
+	if(!condition) {
+		printf("FAILED: %s\n",description.c_str());
+		failures++;
+	}
+	return;
+}
+
+/*****************************************************************************
+Function name:    readTrace
+Purpose:          Decodes a binary trace in the simulator's format
+Input parameters: file - const string& - the trace file
+                  references - vector<Reference>& - set to its references
+Return value:     bool - true if the header's count matches the records and
+                         the file ends with the last record
+******************************************************************************/
+static bool readTrace(const string& file, vector<Reference>& references) {
+	references.clear();
+	FILE* input = fopen(file.c_str(),"rb");
+	if(!input) return false;
+	vector<unsigned char> data;
+	unsigned char buffer[65536];
+	size_t length;
+	while((length = fread(buffer,1,sizeof(buffer),input)) > 0) data.insert(data.end(),buffer,buffer + length);
+	fclose(input);
+	if(data.size() < 16 || memcmp(data.data(),"MSTR",4) != 0) return false;
+	uint16_t flags;
+	uint64_t count;
+	memcpy(&flags,&data[6],sizeof(flags));
+	memcpy(&count,&data[8],sizeof(count));
+	int operationBits = (flags & 2) ? 2 : 1;
+	uint64_t previousAddress = 0;
+	size_t position = 16;
+	while(position < data.size()) {
+		Reference reference;
+		reference.core = 0;
+		if(flags & 4) reference.core = data[position++];
+		uint64_t value = 0;
+		if(flags & 1) {								// LEB128 varint of the zigzag encoded delta
+			int shift = 0;
+			do {
+				if(position == data.size() || shift > 63) return false;
+				value |= (uint64_t)(data[position] & 0x7f) << shift;
+				shift += 7;
+			} while(data[position++] & 0x80);
+		}
+		else {
+			if(data.size() - position < 8) return false;
+			memcpy(&value,&data[position],sizeof(value));
+			position += 8;
+		}
+		reference.operation = (int)(value & ((1 << operationBits) - 1));
+		value >>= operationBits;
+		if(flags & 1) value = previousAddress += (uint64_t)((int64_t)(value >> 1) ^ -(int64_t)(value & 1));
+		reference.address = value;
+		references.push_back(reference);
+	}
+	return references.size() == count;
+}
+
+/*****************************************************************************
+Function name:    checkSingleThread
+Purpose:          Captures a known sequence from one thread through an 8 entry
+                  ring and compares the decoded trace with it
+Input parameters: file - const string& - where to write the trace
+                  deltaEncoded - bool - whether to delta/varint encode
+                  fetches - bool - whether to keep fetches apart from reads
+                  sampling - bool - whether to record 5 of every 12
+Return value:     none
+******************************************************************************/
+static void checkSingleThread(const string& file, bool deltaEncoded, bool fetches, bool sampling) {
+	string name = string(deltaEncoded ? "delta" : "raw") + (fetches ? " with fetches" : "")
+				  + (sampling ? " sampled" : "");
+	TraceCaptureOptions options;
+	options.file = file.c_str();
+	options.deltaEncoded = deltaEncoded;
+	options.fetches = fetches;
+	options.threadIds = false;
+	options.ringEntries = 8;
+	if(sampling) {
+		options.sampleOn = 5;
+		options.sampleOff = 7;
+	}
+	string error;
+	if(!traceCaptureStart(options,error)) {
+		check(false,name + ": " + error);
+		return;
+	}
+	vector<Reference> expected;
+	uint64_t state = 88172645463325252ULL;			// xorshift64, for repeatable references
+	for(int i = 0; i < 50000; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		// Three distant regions, so the deltas need varints of every length
+		uint64_t address = (state % 4096)*8 + ((uint64_t)1 << 40)*(i % 3);
+		int operation = (int)((state >> 40) % 3);
+		if(operation == TRACE_CAPTURE_READ) TRACE_LOAD(address);
+		else if(operation == TRACE_CAPTURE_WRITE) TRACE_STORE(address);
+		else TRACE_FETCH(address);
+		if(sampling && i % 12 >= 5) continue;
+		Reference reference = {address,(operation == TRACE_CAPTURE_FETCH && !fetches) ? TRACE_CAPTURE_READ : operation,0};
+		expected.push_back(reference);
+	}
+	TraceCaptureStatistics statistics;
+	check(traceCaptureStop(&statistics),name + ": the trace was not written");
+	check(statistics.written == expected.size() && statistics.captured == expected.size()
+		  && statistics.dropped == 0 && statistics.late == 0,name + ": wrong counts");
+	vector<Reference> references;
+	check(readTrace(file,references),name + ": the trace does not decode");
+	bool same = references.size() == expected.size();
+	for(size_t i = 0; same && i < references.size(); i++) {
+		same = references[i].address == expected[i].address && references[i].operation == expected[i].operation;
+	}
+	check(same,name + ": the references differ from those captured");
+	return;
+}
+
+/*****************************************************************************
+Function name:    checkAddressLimits
+Purpose:          Captures the highest addresses and largest deltas a trace
+                  allows (below 2^62, or 2^61 with fetches kept), and a
+                  pointer with its top bits set, and checks they decode to
+                  the same addresses, with the top bits dropped
+Input parameters: file - const string& - where to write the traces
+Return value:     none
+******************************************************************************/
+static void checkAddressLimits(const string& file) {
+	for(int format = 0; format < 4; format++) {
+		bool deltaEncoded = (format & 1) != 0;
+		bool fetches = (format & 2) != 0;
+		uint64_t highest = ((uint64_t)1 << (fetches ? 61 : 62)) - 1;
+		const uint64_t ADDRESSES[7] = {0,highest,0,highest,highest - 1,highest/2,~(uint64_t)0};
+		string name = string(deltaEncoded ? "delta" : "raw") + (fetches ? " with fetches" : "") + " at the limit";
+		TraceCaptureOptions options;
+		options.file = file.c_str();
+		options.deltaEncoded = deltaEncoded;
+		options.fetches = fetches;
+		options.threadIds = false;
+		string error;
+		if(!traceCaptureStart(options,error)) {
+			check(false,name + ": " + error);
+			continue;
+		}
+		for(int i = 0; i < 7; i++) {
+			if(i % 2) TRACE_FETCH(ADDRESSES[i]);
+			else TRACE_STORE(ADDRESSES[i]);
+		}
+		check(traceCaptureStop(NULL),name + ": the trace was not written");
+		vector<Reference> references;
+		bool same = readTrace(file,references) && references.size() == 7;
+		for(int i = 0; same && i < 7; i++) {
+			same = references[i].address == (ADDRESSES[i] & highest)
+				   && references[i].operation == (i % 2 ? (fetches ? TRACE_CAPTURE_FETCH : TRACE_CAPTURE_READ)
+												  : TRACE_CAPTURE_WRITE);
+		}
+		check(same,name + ": the addresses differ from those captured");
+	}
+	return;
+}
+
+/*****************************************************************************
+Function name:    checkThreads
+Purpose:          Captures from many short-lived threads twice, with a thread
+                  outliving the first capture, and checks each thread's
+                  references arrived complete and in order
+Input parameters: directory - const string& - where to write the traces
+Return value:     none
+******************************************************************************/
+static void checkThreads(const string& directory) {
+	static long data[1 << 16];						// Referenced by the long-lived thread
+	atomic<bool> running(true);
+	thread longLived;
+	for(int round = 0; round < 2; round++) {
+		string file = directory + "/trace_capture_check_" + to_string(round) + ".bin";
+		string name = "threads, capture " + to_string(round + 1);
+		TraceCaptureOptions options;
+		options.file = file.c_str();
+		options.ringEntries = 256;
+		string error;
+		if(!traceCaptureStart(options,error)) {
+			check(false,name + ": " + error);
+			continue;
+		}
+		check(!traceCaptureStart(options,error),name + ": a second capture started alongside the first");
+		if(round == 0) {
+			longLived = thread([&running]() {
+				for(long i = 0; running.load(memory_order_relaxed); i++) TRACE_LOAD(&data[i & 65535]);
+			});
+		}
+		vector<thread> threads;
+		for(int t = 0; t < SHORT_THREADS; t++) {
+			threads.push_back(thread([t]() {
+				for(int i = 0; i < SHORT_THREAD_REFERENCES; i++) TRACE_STORE((t + 1)*THREAD_STRIDE + i*8);
+			}));
+		}
+		for(size_t t = 0; t < threads.size(); t++) threads[t].join();
+		TraceCaptureStatistics statistics;
+		check(traceCaptureStop(&statistics),name + ": the trace was not written");
+		vector<Reference> references;
+		check(readTrace(file,references),name + ": the trace does not decode");
+		check(statistics.written == references.size() && statistics.captured == statistics.written,
+			  name + ": the counts do not match the trace");
+		// Each short thread's stores are complete and in order, under its own core
+		vector<int> stored(SHORT_THREADS,0);
+		vector<int> cores(SHORT_THREADS,-1);
+		bool ordered = true;
+		for(size_t i = 0; i < references.size(); i++) {
+			uint64_t storer = references[i].address/THREAD_STRIDE;
+			if(storer == 0 || storer > (uint64_t)SHORT_THREADS) continue;	// The long-lived thread's
+			int index = (int)storer - 1;
+			if(cores[index] < 0) cores[index] = references[i].core;
+			ordered = ordered && references[i].operation == TRACE_CAPTURE_WRITE && references[i].core == cores[index]
+					  && references[i].address == storer*THREAD_STRIDE + (uint64_t)stored[index]*8;
+			stored[index]++;
+		}
+		for(int t = 0; t < SHORT_THREADS; t++) ordered = ordered && stored[t] == SHORT_THREAD_REFERENCES;
+		check(ordered,name + ": a thread's references are missing or out of order");
+		int expectedThreads = SHORT_THREADS + (round == 0 ? 1 : 0);	// And the long-lived thread
+		check(statistics.threads == expectedThreads,name + ": " + to_string(statistics.threads) + " threads registered");
+		if(round == 0) {							// Stopped captures ignore the thread
+			running.store(false,memory_order_relaxed);
+			longLived.join();
+		}
+		printf("%s: %llu references from %d threads (%llu late)\n",name.c_str(),
+			   (unsigned long long)statistics.written,statistics.threads,(unsigned long long)statistics.late);
+	}
+	TRACE_LOAD(&data[0]);							// After every capture, so ignored
+	return;
+}
+
+int main(int argc, char* argv[]) {
+	string directory = (argc > 1) ? argv[1] : "/tmp";
+	string file = directory + "/trace_capture_check.bin";
+	checkSingleThread(file,true,true,false);
+	checkSingleThread(file,false,true,false);
+	checkSingleThread(file,true,false,false);
+	checkSingleThread(file,true,false,true);
+	checkSingleThread(file,false,true,true);
+	checkAddressLimits(file);
+	checkThreads(directory);
+	if(failures == 0) {
+		printf("Trace capture check passed\n");
+		return 0;
+	}
+	printf("Trace capture check failed: %d checks\n",failures);
+	return 1;
+}
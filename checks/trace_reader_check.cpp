@@ -0,0 +1,170 @@
+/*
+  Memory Simulator trace reader check
+  Writes the same references as a text trace and as raw, delta encoded and multi-core binary traces,
+  streams each back through the simulator's TraceReader and checks every reference, from the start
+  and after a skip, and that the pages parsed while streaming were released. Then checks binary
+  records round-trip the highest addresses and largest deltas they allow.
+
+  Build:	g++ -std=c++11 -Wall -O2 -march=native -pthread -I. checks/trace_reader_check.cpp -o check
+  			(builds mem_simulator.cpp in with MEM_SIMULATOR_LIBRARY, so its internals are reachable)
+  Run:		./check
+*/
+
+// The library's internals are in an anonymous namespace, which GCC warns about once the file holding
+// CacheSimulator::Implementation is included rather than compiled itself
+#define MEM_SIMULATOR_LIBRARY
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsubobject-linkage"
+#include "mem_simulator.cpp"
+#pragma GCC diagnostic pop
+
+// References in each trace streamed back, enough for every format to span several release steps
+const int64_t READER_CHECK_REFERENCES = 1 << 18;
+
+/*****************************************************************************
+Function name:    checkTraceReader
+Purpose:          Checks that the same references written as a text trace and
+                  as raw, delta encoded and multi-core binary traces all
+                  stream back unchanged, both from the start and after
+                  skipping a third of them, and that the pages parsed while
+                  streaming are released
+Input parameters: traceFile - const char* - a file to write the traces to
+                  error - string& - set to a description of the first failure
+Return value:     bool - true if every trace streamed back correctly
+******************************************************************************/
+static bool checkTraceReader(const char* traceFile, string& error) {
+	const char* FORMAT_NAMES[4] = {"text","raw","delta","multi-core"};
+	const int64_t MEMORY_SIZE = (int64_t)1 << 40;	// Wide addresses, for varints of every length
+	const int64_t SKIPPED = READER_CHECK_REFERENCES/3;
+	vector<MemoryReference> references(READER_CHECK_REFERENCES);
+	for(int format = 0; format < 4; format++) {
+		bool multiCore = (format == 3);				// Cores and instruction fetches
+		TraceGenerator generator(UNIFORM,MEMORY_SIZE,64,25,format + 1);
+		for(int64_t i = 0; i < READER_CHECK_REFERENCES; i++) {
+			MemoryReference& reference = references[i];
+			generator.next(reference.memoryAddress,reference.operation);
+			reference.core = multiCore ? (int)(i % MAX_CORES) : 0;
+			if(multiCore && i % 5 == 0) reference.operation = FETCH;
+		}
+		bool written;
+		if(format == 0) {
+			ofstream textFile(traceFile,ios::out | ios::trunc);
+			textFile << READER_CHECK_REFERENCES << "\n";
+			for(int64_t i = 0; i < READER_CHECK_REFERENCES; i++) {
+				textFile << (references[i].operation == WRITE ? "W " : "R ") << references[i].memoryAddress << "\n";
+			}
+			textFile.close();
+			written = (bool)textFile;
+		}
+		else {
+			TraceWriter traceWriter;
+			written = traceWriter.open(traceFile,format != 1,multiCore,multiCore);
+			for(int64_t i = 0; i < READER_CHECK_REFERENCES; i++) {
+				traceWriter.write(references[i].memoryAddress,references[i].operation,references[i].core);
+			}
+			written = traceWriter.close() && written;
+		}
+		struct stat fileStatus;
+		TraceReader traceReader;
+		if(!written || stat(traceFile,&fileStatus) != 0 || !traceReader.open(traceFile)
+		   || !traceReader.validate(MEMORY_SIZE,error)) {
+			error = string(FORMAT_NAMES[format]) + " trace could not be written or validated. " + error;
+			return false;
+		}
+		int64_t releasedBefore = traceReader.getReleasedBytes();
+		// Stream every reference, then everything after the skipped ones
+		for(int pass = 0; pass < 2; pass++) {
+			traceReader.rewind();
+			int64_t position = (pass == 0) ? 0 : traceReader.skip(SKIPPED);
+			vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+			int chunkSize;
+			while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+				for(int i = 0; i < chunkSize; i++, position++) {
+					const MemoryReference& expected = references[min(position,READER_CHECK_REFERENCES - 1)];
+					if(position >= READER_CHECK_REFERENCES || chunk[i].memoryAddress != expected.memoryAddress
+					   || chunk[i].operation != expected.operation || chunk[i].core != expected.core) {
+						error = string(FORMAT_NAMES[format]) + " trace reference " + to_string(position)
+								+ " streamed back wrongly";
+						return false;
+					}
+				}
+			}
+			if(position != READER_CHECK_REFERENCES) {
+				error = string(FORMAT_NAMES[format]) + " trace ended after " + to_string(position) + " references";
+				return false;
+			}
+			// The whole trace but the partial release steps at either end was released on the way
+			int64_t released = traceReader.getReleasedBytes() - releasedBefore;
+			if(pass == 0 && released + 2*(int64_t)TRACE_RELEASE_SIZE < (int64_t)fileStatus.st_size) {
+				error = string(FORMAT_NAMES[format]) + " trace released only " + to_string(released) + " of its "
+						+ to_string((int64_t)fileStatus.st_size) + " bytes while streaming";
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*****************************************************************************
+Function name:    checkTraceLimits
+Purpose:          Checks that binary traces round-trip the extreme addresses
+                  and deltas of their records: up to MAX_MEMORY_SIZE for
+                  reads and writes and MAX_FETCH_TRACE_ADDRESS once fetches
+                  are kept, raw and delta encoded
+Input parameters: traceFile - const char* - a file to write the traces to
+                  error - string& - set to a description of the first failure
+Return value:     bool - true if every trace read back correctly
+******************************************************************************/
+static bool checkTraceLimits(const char* traceFile, string& error) {
+	for(int format = 0; format < 4; format++) {
+		bool deltaEncoded = (format & 1) != 0;
+		bool fetches = (format & 2) != 0;
+		int64_t highest = (fetches ? MAX_FETCH_TRACE_ADDRESS : MAX_MEMORY_SIZE) - 1;
+		// The largest steps both ways, then the smallest
+		const int64_t ADDRESSES[6] = {0,highest,0,highest,highest - 1,highest/2};
+		string name = string(deltaEncoded ? "delta" : "raw") + (fetches ? " fetch" : "") + " trace";
+		TraceWriter traceWriter;
+		bool written = traceWriter.open(traceFile,deltaEncoded,fetches);
+		for(int i = 0; i < 6; i++) traceWriter.write(ADDRESSES[i],(fetches && i % 2) ? FETCH : (ReadWrite)(i % 2));
+		written = traceWriter.close() && written;
+		TraceReader traceReader;
+		if(!written || !traceReader.open(traceFile) || !traceReader.validate(MAX_MEMORY_SIZE,error)) {
+			error = name + " at the address limit could not be written or validated. " + error;
+			return false;
+		}
+		MemoryReference chunk[6];
+		if(traceReader.readChunk(chunk,6) != 6) {
+			error = name + " at the address limit ended early";
+			return false;
+		}
+		for(int i = 0; i < 6; i++) {
+			if(chunk[i].memoryAddress != ADDRESSES[i]
+			   || chunk[i].operation != ((fetches && i % 2) ? FETCH : (ReadWrite)(i % 2))) {
+				error = name + " read back address " + to_string(chunk[i].memoryAddress) + " for "
+						+ to_string(ADDRESSES[i]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main() {
+	char traceFile[] = "/tmp/trace_reader_check_XXXXXX";
+	int fileDescriptor = mkstemp(traceFile);
+	if(fileDescriptor < 0) {
+		cerr << "Error: The check's trace could not be created" << endl;
+		return 1;
+	}
+	close(fileDescriptor);
+	string error;
+	bool passed = checkTraceReader(traceFile,error) && checkTraceLimits(traceFile,error);
+	unlink(traceFile);
+	if(!passed) {
+		cout << "Trace reader check failed: " << error << endl;
+		return 1;
+	}
+	cout << "Trace reader check passed: text, raw, delta and multi-core traces streamed back and released, "
+			"and the address limits round-tripped" << endl;
+	return 0;
+}
@@ -1,627 +1,8581 @@
-/*
-  ECE 487 Laboratory 7
-  Memory Simulator
-  A simulator for a two-level momeory heirarchy using set-associative cache mapping. Parameters are prompted
-  from the user and memory access operations are given in a file provided by the user. The simulator
-  calculates various operational and performance characteristics of the given memory system including
-  cache size, bits required for each field, hit rate, operating status, and final status.
-  
-  Compile:	g++ -std=c++11 -Wall Lab7.cpp -o Lab7.out
-  Run:		./Lab7.out
-  
-  Jonathan Platt
-  11807130
-*/
-
-#include <fstream>									// Imported for working with files (ifstream)
-#include <iostream>									// Imported for interacting with user (cout, cin)
-#include <iomanip>									// Imported for improving printing (setw, setprecision)
-#include <string>									// Imported for strings
-#include <vector>									// Imported for vectors
-
-using namespace std;								// Use standard namespace for brevity and convenience
-
-// Simple enumerated type for whether the replacement policy is LRU or FIFO
-enum ReplacementPolicy {LRU,FIFO};					// LRU is Least Recently Used
-													// FIFO is First In First Out
-// Simple enumerated type for whether an operation is read or write
-enum ReadWrite {READ, WRITE};
-
-// Simple enumerated type for whether a memory access results in a hit or miss
-enum HitMiss {HIT, MISS};
-
-/*****************************************************************************
-Struct name:      MemoryReference
-Purpose:          Stores a single memory reference operation (read / write)
-                  and the address being operated on
-******************************************************************************/
-struct MemoryReference {
-	ReadWrite operation;							// Whether the operation is read or write 
-	int memoryAddress;								// The memory address being read / written
-};
-
-/*****************************************************************************
-Function name:    log2
-Purpose:          Calculates and return the base 2 logarithm of the input
-Input parameters: value - int - the number to take the logarithm of
-Return value:     int - the base 2 logarithm of the input rounded down to an
-                        integer. If the input is less than 1, 0 is returned.
-******************************************************************************/
-int log2(int value) {
-	int power = 0;									// Initialize power (answer) to 0
-	while(value > 1) {								// While the input value is > 1 (log2(value) > 0)
-		value = value >> 1;							// Right shift value 1 bit (divide by 2)
-		power++;									// Increment the power value
-	}
-	return power;									// Return power once value <= 1
-}
-
-/*****************************************************************************
-******************************************************************************
-Class name:       UserInterface
-Purpose:          Prompt the user for input of memory simulator parameters
-******************************************************************************/
-class UserInterface {
-	public:
-/*****************************************************************************
-Function name:    valuePrompt
-Purpose:          Prompt the user for the value of a particular memory feature
-Input parameters: prompt - string - the prompt to print to the user
-                  minimumVal - int - the minimum value of the feature
-                  maximumVal - int - the maximum value of the feature
-Return value:     int - the recieved numerical user input
-******************************************************************************/
-		int valuePrompt(string prompt, int minimumVal, int maximumVal) {
-			int size = -1;							// Stores the size recieved from the user
-			string buffer;							// String buffer in case of non-numeric input
-			while(true) {							// Repeat until we recieve valid input
-				cout << prompt;						// Prompt the user using the functions 'prompt' input
-				cin >> size;						// Store user input in int 'size'
-				// If size is a power of two within the limits, return it as an int
-				if(size >= minimumVal && size <= maximumVal && isPowerOfTwo(size)) return size;
-				// Otherwise, inform the use their input is invalud
-				cout << "Error: Value must be an integer power of two between "
-				     << minimumVal << " and " << maximumVal << "." << endl;
-				if (cin.fail()) {					// If 'cin' fails (non-integer input)
-					cin.clear();					// Clear the error
-					cin >> buffer;					// Read the erroneous input into the string buffer
-				}
-			}
-		}
-/*****************************************************************************
-Function name:    replacementPolicyPrompt
-Purpose:          Prompt the user for the memory's replacement policy
-Input parameters: None
-Return value:     ReplacementPolicy - the user selected replacement policy
-******************************************************************************/
-		ReplacementPolicy replacementPolicyPrompt() {
-			string text;							// Stores the text input recieved from the user
-			while(true) {							// Repeat until we recieve valid input
-				cout << "Enter the replacement policy (L = LRU, F = FIFO): ";
-				cin >> text;
-				if(text == "L" || text == "l") return LRU;		// If the input is 'L', return LRU enum
-				else if(text == "F" || text == "f") return FIFO;// If the input is 'F', return FIFO enum
-				// If neither an L or F is detected, print and error and reprompt the user
-				cout << "Error: Character must be an 'L' or an 'F'" << endl;
-			}
-		}
-/*****************************************************************************
-Function name:    memoryReferenceFilePrompt
-Purpose:          Prompt the user for the memory reference file and read it
-Input parameters: memorySize - int - the memorySize size in bytes
-Return value:     vector<MemoryReference> - vector containing the memory
-                                            operations from reference file
-******************************************************************************/
-		vector<MemoryReference> memoryReferenceFilePrompt(int memorySize) {
-			// Stores the memory references read from the text file as a vector of MemoryReference structs
-			vector<MemoryReference> memoryReferences;
-			string file;							// Stores the input file handle
-			string buffer;							// Stores read from the input file
-			int numReferences;						// The number of references from file's first line
-			int memoryAddress;						// Stores a memory address read from the file
-			bool repeat = true;						// Stores whether to repeat (reprompt user if error)
-			while(repeat) {
-				repeat = false;						// Do not repeat unless an error is encountered
-				cout << "Enter the name of the input file containing the list of "
-						"memory references generated by the CPU: ";
-				cin >> file;
-				ifstream inputFile;					// Create file handler
-				inputFile.open(file);				// Open the file recieved from the user input
-				if(!inputFile) {					// If the file cannot be opened, print an error
-					cout << "Error: Input file: \"" << file << "\" not found" << endl;
-					repeat = true;					// And set the repeat parameter
-					continue;						// Restart the loop
-				}
-				inputFile >> numReferences;			// Read the first line (containing number of refs)
-				// If the number of references is not an integer greater than 0, print an error
-				if (inputFile.fail() || numReferences < 1) {
-					cout << "Error: File must contain at least 1 memory reference." << endl;
-					repeat = true;					// And set the repeat parameter
-					continue;						// Restart the loop
-				}
-				// Set the vector size to the same as the number of references
-				memoryReferences.resize(numReferences);
-				// For every reference in the specified file
-				for(int i = 0; i < numReferences; i++) {
-					inputFile >> buffer;			// Read the operation (read / write)
-					// Set the appropriate memoryReference at the current vector index to read / write
-					if(buffer == "R") memoryReferences[i].operation = READ;
-					else if(buffer == "W") memoryReferences[i].operation = WRITE;
-					else {							// If neither read nor write, print an error
-						cout << "Error: Input file contains an invalid operation on line "
-							 << 3 + i << "." << endl;
-						repeat = true;				// Set the repeat parameter
-						break;						// And exist the for loop
-					}
-					inputFile >> memoryAddress;		// Read the memory address from the file
-					// If the address is an int between 0 and the memory size
-					if(memoryAddress >= 0 && memoryAddress < memorySize && !inputFile.fail()) {
-						// Set the address of the current vector index to the read address
-						memoryReferences[i].memoryAddress = memoryAddress;
-					}
-					else {							// If not an int within the bounds, print error
-						cout << "Error: Input file contains an invalid memory address on line "
-							 << 3 + i << "." << endl;
-						repeat = true;				// Set the repeat parameter
-						break;						// And exist the for loop
-					}
-				}
-				inputFile.close();
-			}
-			return memoryReferences;
-		}
-/*****************************************************************************
-Function name:    repeatPrompt
-Purpose:          Prompt the user if they would like to continue / repeat
-Input parameters: None
-Return value:     bool - The user's response (true to repeat, false to end)
-******************************************************************************/
-		bool repeatPrompt() {
-			string text;							// Stores the text input recieved from the user
-			while(true) {							// Repeat until we recieve valid input
-				cout << "Continue? (y = yes, n = no): ";
-				cin >> text;
-				if(text == "Y" || text == "y") return true;			// If 'y' (yes), return true
-				else if(text == "N" || text == "n") return false;	// If 'n' (no), return false
-				// If neither a Y or N is detected, print and error and reprompt the user
-				cout << "Error: Character must be a 'y' or an 'n'" << endl;
-			}
-		}
-	private:
-/*****************************************************************************
-Function name:    powerOfTwo
-Purpose:          Returns if the input is a nonnegative integer power of two
-Input parameters: value - int - the input to check if it is a power of two
-Return value:     bool - true is the input is a power of two, false if not
-******************************************************************************/
-		bool isPowerOfTwo(int value) {
-			if(value < 1) return false;				// Numbers below 1 are not nonnegative powers of two
-			for(int i = 1; i <= value; i*=2) {		// Double i until it is greater than the input value
-				if(i == value) return true;			// If i is exactly the value, return true
-			}
-			return false;							// If i never equaled value, it is not a power of two
-		}
-};
-
-/*****************************************************************************
-Struct name:      CacheBlock
-Purpose:          Stores the components of a simple cache block including
-                  dirty bit, valid bit, tag, and data, where data stores the
-                  number of the memory block stored in the cache block
-******************************************************************************/
-struct CacheBlock {
-	int dirtyBit = 0;								// 1 if the cache has had a 'write', 0 if not
-	int validBit = 0;								// 1 if the cache contains valid data, 0 if not
-	int tag = -1;									// The cache's tag value, or -1 if unknown
-	int data = -1;									// The number of the memory block in the cache
-};													// or -1 is unknown or not set
-
-/*****************************************************************************
-******************************************************************************
-Class name:       CacheSet
-Purpose:          Models a cache set, which may contain multiple cache blocks,
-                  including keeping track a cache's priority (via FIFO or LRU)
-                  to faithfully model the cache's replacement policy
-******************************************************************************/
-class CacheSet {
-	public:
-/*****************************************************************************
-Function name:    CacheSet (constructor)
-Purpose:          Creates a CacheSet object with the specified parameters
-Input parameters: associativity - int - the associativity of the cache memory
-                                        (the number of cache blocks per set)
-                  policy - ReplacementPolicy - whether to follow FIFO or LRU
-Return value:     none
-******************************************************************************/
-		CacheSet(int associativity, ReplacementPolicy policy) {
-			this->associativity = associativity;	// Set the CacheSet object's associativity
-			this->policy = policy;					// Set the CacheSet object's replacement policy
-			// Set the size of the cache block and cache block priority vectors to the
-			// associativity, since that is the number of cache blocks per set
-			cacheBlocks.resize(associativity);
-			cacheReplacementPriority.resize(associativity);
-			for(int i = 0; i < associativity; i++) {// For every element in the priority queue
-				cacheReplacementPriority[i] = i;	// set the element to contain its position index
-			}										// meaning that lower indicies are first in the queue
-			return;									// to be replaced (ie lower slots in cache filled 1st)
-		}
-		
-/*****************************************************************************
-Function name:    getCacheBlock
-Purpose:          Gets the cache block at the specified offset within the set
-Input parameters: blockNumber - int - the offset of the block within the set
-Return value:     CacheBlock - the CacheBlock object with the given offset
-******************************************************************************/
-		CacheBlock getCacheBlock(int blockNumber) {
-			return cacheBlocks[blockNumber];		// Return the block at the given index
-		}
-		
-/*****************************************************************************
-Function name:    getCacheBlock
-Purpose:          Gets the cache block at the specified offset within the set
-Input parameters: blockNumber - int - the offset of the block within the set
-Return value:     CacheBlock - the CacheBlock object with the given offset
-******************************************************************************/
-		HitMiss access(int tag, int data, ReadWrite operation) {
-			// Find the index of the cache block with the given tag
-			int cacheBlockIndex = findCacheBlock(tag);
-			// Update the priority of the given index, returning the updated index
-			int updatedIndex = updatePriority(cacheBlockIndex);
-			// If the operation is a WRITE, set the dirty bit
-			if(operation == WRITE) cacheBlocks[updatedIndex].dirtyBit = 1;
-			// If the previous and updated index are the same, then the data was already
-			// in the cache and the access was a HIT
-			if(cacheBlockIndex == updatedIndex) return HIT;
-			// Otherwise, update the cache blocks parameters, including the dirty bit on a READ
-			cacheBlocks[updatedIndex].tag = tag;
-			cacheBlocks[updatedIndex].data = data;
-			if(operation == READ) cacheBlocks[updatedIndex].dirtyBit = 0;
-			cacheBlocks[updatedIndex].validBit = 1;
-			return MISS;							// Return a MISS (only reached if not a HIT)
-		}
-	private:
-		int associativity;							// Stores the associativity (blocks per set)
-		ReplacementPolicy policy;					// Stores the replacement policy (FIFO or LRU)
-		vector<CacheBlock> cacheBlocks;				// Vector of cache blocks. Size set by associativity
-		vector<int> cacheReplacementPriority;		// Stores block IDs in priority order with lower
-													// priorities (first to be replaced) at lower indicies
-/*****************************************************************************
-Function name:    findCacheBlock
-Purpose:          Find the index of the cache block with the given tag value
-Input parameters: tag - int - the tag of the cache block to search for
-Return value:     int - index of the cache block with the provided tag
-                        or -1 if the tag is not found
-******************************************************************************/
-		int findCacheBlock(int tag) {
-			for(int i = 0; i < associativity; i++) {// for every block in the set
-				// Return the index if the block tag matches the provided tag
-				if(cacheBlocks[i].tag == tag) return i;
-			}
-			return -1;								// Otherwise return -1 (block with tag not found)
-		}
-
-/*****************************************************************************
-Function name:    updatePriority
-Purpose:          Update the priority of the block that is being accessed
-Input parameters: tag - int - the tag of the cache block to search for
-Return value:     int - index of the cache block with the provided tag
-                        or -1 if the tag is not found
-******************************************************************************/
-		int updatePriority(int cacheBlockID) {
-			if(cacheBlockID != -1) {				// If the block is already in cache (index not -1, hit)
-				// Return block id if we're a FIFO policy, since FIFO priorities only change on misses
-				if(policy == FIFO) return cacheBlockID;
-				else if(policy == LRU) {			// Otherwise (if policy is LRU)
-					// Loop through the cache priority queue
-					for(int i = 0; i < associativity; i++) {
-						// and when the cache block id is found in the priority queue
-						if(cacheReplacementPriority[i] == cacheBlockID) {
-							// Remove the block id from its current position and put it at the end
-							cacheReplacementPriority.erase(cacheReplacementPriority.begin()+i);
-							cacheReplacementPriority.push_back(cacheBlockID);
-							return cacheBlockID;	// Return the block id (unchanged)
-						}
-					}
-					// If the block id isn't found in the priority queue there is an error
-					cerr << "Cache Set Priority Error" << endl;
-					throw "Cache Set Priority Error";
-				}
-			}
-			else {									// Otherwise, if the block was not in cache (miss)
-				// Find the lowest priority block id in the queue (index 0), and move it to the back
-				cacheBlockID = cacheReplacementPriority[0];
-				cacheReplacementPriority.erase(cacheReplacementPriority.begin());
-				cacheReplacementPriority.push_back(cacheBlockID);
-			}
-			return cacheBlockID;					// Return the updated block id from the queue
-		}
-};
-
-/*****************************************************************************
-******************************************************************************
-Class name:       MemorySimulator
-Purpose:          Class for simulating memory supporting generation of the
-                  structure and simulation of reference operations
-******************************************************************************/
-class MemorySimulator {
-	public:
-/*****************************************************************************
-Function name:    MemorySimulator (constructor)
-Purpose:          Create the memory simulator object and initialize attributes
-Input parameters: memorySize - int - The size of main memory in bytes
-                  cacheSize - int - The size of the cache memory in bytes
-                  cacheBlockSize - The size of the cache blocks in bytes
-                  associativity - The degree of associativity, 
-                                  1 meaning direct mapped
-                  policy - ReplacementPolicy - The memory's replacement policy
-                                               LRU or FIFO
-Return value:     none
-******************************************************************************/
-		MemorySimulator(int memorySize, int cacheSize, int cacheBlockSize,
-						int associativity, ReplacementPolicy policy) {
-			// Set the objects internal attributes
-			this->cacheSize = cacheSize;
-			this->cacheBlockSize = cacheBlockSize;
-			this->associativity = associativity;
-			// Calculate number of cache blocks, cache sets, and memory blocks total
-			cacheBlocks = cacheSize/cacheBlockSize;
-			cacheSets = cacheBlocks/associativity;
-			memoryBlocks = memorySize/cacheBlockSize;
-			// Calculate the number of address bits and the sizes of the offset, index and tag fields
-			totalAddressBits = log2(memorySize);
-			offsetBits = log2(cacheBlockSize);
-			indexBits = log2(cacheSets);
-			tagBits = log2(memoryBlocks/cacheSets);
-			// Initialize the cache memory, which is made up of the previously calculated number of
-			// cache sets, each of which has the same associativity and replacement policy
-			cacheMemory = vector<CacheSet>(cacheSets,CacheSet(associativity,policy));
-			return;
-		}
-		
-/*****************************************************************************
-Function name:    printMemoryInfo
-Purpose:          Prints various pieces of information about the memory module
-                  including address size in bits, offset, index, and tag sizes
-                  and the total cache size accounting for overhead bits
-Input parameters: none (values come from MemorySimulator object)
-Return value:     none (Output directly printed to console)
-******************************************************************************/
-		void printMemoryInfo() {
-			// Print the number of address lines requires and the size of the 3 fields
-			cout << "Total address lines required = " << totalAddressBits << endl;
-			cout << "Number of bits for offset = " << offsetBits << endl;
-			cout << "Number of bits for index = " << indexBits << endl;
-			cout << "Number of bits for tag = " << tagBits << endl;
-			// Calculate the total cache size (2 accounts for the dirty and valid bits)
-			// divide by 8 to convert the dirty, valid, and tag bit sum to bytes
-			float totalCacheSize = (2 + tagBits)*cacheBlocks/8. + cacheSize;
-			// Print toal cache size, displaying a maximum of 8 significant figures (then revert)
-			cout << "Total cache size required = " << setprecision(8) << totalCacheSize
-				 << setprecision(6) << " bytes" << endl << endl;
-		}
-		
-/*****************************************************************************
-Function name:    runSimulation
-Purpose:          Runs the memory simulation using the given vector of memory
-                  references and prints summary statistics on the program
-Input parameters: memoryReferences - vector<MemoryReference>& - Vector of
-                                   memory references to simulate, passed by
-                                   reference to avoid needless data copying
-Return value:     none (Output directly printed to console)
-******************************************************************************/
-		void runSimulation(vector<MemoryReference>& memoryReferences) {
-			// Print the memory references header for the simulation
-			cout << "main memory address" << setw(12) << "mm blk #" << setw(12) << "cm set #" 
-				 << setw(12) << "cm blk #" << setw(12) << "hit/miss" << endl;
-			cout << string(67,'-') << endl;			// Print line to separate header from data
-			int hitCount = 0;						// Counts the number of cache hits while simulating
-			// For each memory reference item in the vector
-			for(unsigned int i = 0; i < memoryReferences.size(); i++) {
-				// Run the simulation one step
-				HitMiss status = simulationStep(memoryReferences[i]);
-				// Print the result of the current simulation step
-				printSimulationStep(memoryReferences[i].memoryAddress,status);
-				if(status == HIT) hitCount++;		// If the operation is a hit, increase the hit count
-			}
-			// Calculate the ideal hit count for the memory reference file
-			int idealHitCount = calculateIdealHitCount(memoryReferences);
-			// Print ideal hit count and calculated ideal hit rate
-			cout << "\nHighest possible hit rate = " << idealHitCount << "/" << memoryReferences.size()
-				 << " = " << (float)idealHitCount/memoryReferences.size()*100 << "%" << endl;
-			// Print actual hit count and calculated actual hit rate
-			cout << "Actual hit rate = " << hitCount << "/" << memoryReferences.size()
-				 << " = " << (float)hitCount/memoryReferences.size()*100 << "%" << endl << endl;
-			return;
-		}
-		
-/*****************************************************************************
-Function name:    printCache
-Purpose:          Prints the state of the cache of the MemorySimulator object
-                  at the current simulation step
-Input parameters: none (values come from MemorySimulator object)
-Return value:     none (Output directly printed to console)
-******************************************************************************/
-		void printCache() {
-			// Print cache contents header
-			cout << "Cache blk #" << setw(12) << "dirty bit" << setw(12) << "valid bit" 
-				 << setw(10) << "tag" << setw(16) << "Data" << endl;
-			cout << string(67,'-') << endl;			// Print line to separate header from data
-			for(int i = 0; i < cacheBlocks; i++) {	// For each cache block in the memory simulator
-				printCacheBlock(i);					// print the cache block
-			}
-			cout << endl;							// Print blank line for spacing
-			return;
-		}
-	private:
-		int cacheSize;								// Stores the size of cache in bytes
-		int cacheBlockSize;							// Stores the size of cache blocks in bytes
-		int associativity;							// Stores the memory's degree of associativity 
-		int cacheBlocks;							// Stores the number of cache blocks
-		int cacheSets;								// Stores the number of cache sets
-		int memoryBlocks;							// Stores the number of memory blocks
-		int totalAddressBits;						// Stores the number of address bits for memory
-		int offsetBits;								// Stores the number of offset bits in the address
-		int indexBits;								// Stores the number of index bits in the address
-		int tagBits;								// Stores the number of tag bits in the address
-		vector<CacheSet> cacheMemory;				// Emulated cache memory device made from a vector
-													// of cache sets
-/*****************************************************************************
-Function name:    simulationStep
-Purpose:          Runs the memory simulator one step, performing the operation
-                  specified in the memory reference parameter
-Input parameters: memoryReference - MemoryReference& - the memory access
-                                    operation to perform, contains an address
-                                    and a read/write flag
-Return value:     HitMiss - whether the access results in a hit or a miss in
-                            the cache
-******************************************************************************/
-		HitMiss simulationStep(MemoryReference& memoryReference) {
-			// Extract the parameters from the MemoryReference struct
-			int memoryAddress = memoryReference.memoryAddress;
-			ReadWrite operation = memoryReference.operation;
-			// Calculate the memory block and cache set the operation would access
-			int memoryBlockNumber = memoryAddress / cacheBlockSize;
-			int cacheSetNumber = memoryBlockNumber % cacheSets;
-			// Calculate the tag value for the memory address being referenced
-			int tag = memoryBlockNumber / cacheSets;
-			// Perform the cache access operation and store the return status (hit or miss)
-			HitMiss status = cacheMemory[cacheSetNumber].access(tag,memoryBlockNumber,operation);
-			return status;
-		}
-		
-/*****************************************************************************
-Function name:    calculateIdealHitCount
-Purpose:          Calculates and returns the ideal hit rate of a sequence of
-                  memory references
-Input parameters: memoryReferences - vector<MemoryReference>& - the memory 
-                                     access operations to consider
-Return value:     int - the ideal hit count of the sequence
-******************************************************************************/
-		int calculateIdealHitCount(vector<MemoryReference>& memoryReferences) {
-			// Create a zero initialized array of ints to count references to memory blocks
-			int memoryBlockReferences[memoryBlocks] = {0};
-			// For every memory reference operation in the vector input
-			for(unsigned int i = 0; i < memoryReferences.size(); i++) {
-				// Calculate the memory block number under reference
-				int memoryBlockNumber = memoryReferences[i].memoryAddress/cacheBlockSize;
-				// Increment the count at the index given by the memory block number
-				memoryBlockReferences[memoryBlockNumber]++;
-			}
-			int idealHitCount = 0;					// Stores the ideal number of memory hits
-			for(int i = 0; i < memoryBlocks; i++) {	// For every memory block
-				// If the number of references to that block is greater than one, increase idealHitCount
-				// by the number of references minus 1, since the first access must always be a miss 
-				if(memoryBlockReferences[i] > 1) idealHitCount += memoryBlockReferences[i] - 1;
-			}
-			return idealHitCount;					// Return the ideal hit count
-		}
-
-/*****************************************************************************
-Function name:    printCacheBlock
-Purpose:          Prints the contents of a single cache block
-Input parameters: cacheBlockNumber - int - the number of the block to print 
-Return value:     none (Output directly printed to console)
-******************************************************************************/
-		void printCacheBlock(int cacheBlockNumber) {
-			// Calculate the cache set and set offset of the specified block
-			int cacheSetNumber = cacheBlockNumber / associativity;
-			int cacheSetOffset = cacheBlockNumber % associativity;
-			// Get the specified cache block from the calculated cache set in the cache memory vector
-			CacheBlock cacheBlock = cacheMemory[cacheSetNumber].getCacheBlock(cacheSetOffset);
-			string tagString;						// Strings to store tag and data for printing
-			string dataString;
-			if(cacheBlock.validBit == 0) {			// If the cache block is considered invalid
-				tagString = string(tagBits,'x');	// Set the tag string to contain the same number of
-				dataString = "?";					// 'X's as there are tag bits. Also set data to '?'
-			} else {								// Otherwise
-				// Calculate the binary equivalent of the tag and format the data string
-				tagString = toBinary(cacheBlock.tag,tagBits);
-				dataString = "mm blk # " + to_string(cacheBlock.data);
-			}
-			// Print the parameterized contents of the cache block to the console
-			cout << setw(7) << cacheBlockNumber << setw(12) << cacheBlock.dirtyBit << setw(12)
-				 << cacheBlock.validBit << setw(15) << tagString << string(8,' ') << dataString << endl;
-			return;
-		}
-
-/*****************************************************************************
-Function name:    printSimulationStep
-Purpose:          Prints the a memory reference and its result (a single
-                  simulation step)
-Input parameters: memoryAddress - int - the memory address being accessed
-                  status - HitMiss - the result of the memory access operation
-Return value:     none (Output directly printed to console)
-******************************************************************************/
-		void printSimulationStep(int memoryAddress, HitMiss status) {
-			// Calculate the memory block and cache set the operation would access
-			int memoryBlockNumber = memoryAddress / cacheBlockSize;
-			int cacheSetNumber = memoryBlockNumber % cacheSets;
-			// Generate string for cacheBlockNumber, since it could represent a range
-			string cacheBlockNumber;
-			// If the associativity is 1, there can only be one possible cache block number
-			if(associativity == 1) cacheBlockNumber = to_string(cacheSetNumber);
-			// If the associativity is 2, there is a binary choice of cache block number
-			else if(associativity == 2) cacheBlockNumber = to_string(cacheSetNumber*2)
-									+ " or " + to_string(cacheSetNumber*2 + 1);
-			// If the associativity is > 2, there is a consecutive range of possible cache block numbers
-			else cacheBlockNumber = to_string(cacheSetNumber*associativity)
-									+ " - " + to_string((cacheSetNumber+1)*associativity - 1);
-			// Convert the returned HitMiss status into a string
-			string statusString = (status == HIT) ? "hit" : "miss";
-			
-			// Print the result of the memory simulator step
-			cout << setw(11) << memoryAddress << setw(17) << memoryBlockNumber << setw(12) << cacheSetNumber 
-				 << setw(15) << cacheBlockNumber << setw(10) << statusString << endl;
-			return;
-		}
-
-/*****************************************************************************
-Function name:    toBinary
-Purpose:          Converts an integer to a binary number in the specified
-                  number of bits
-Input parameters: value - int - the number to convert to binary
-                  numberOfBits - int - the desired number of bits to output 
-Return value:     string - the binary representation of the input value
-******************************************************************************/
-		string toBinary(int value, int numberOfBits) {
-			string binary = "";						// Create an empty string
-			for(int i = 0; i < numberOfBits; i++) {	// For every desired bit
-				int currentBit = (value >> i) % 2;	// Calculate the bit at the current bit offset
-				// Convert the bit to a string and append it to the front of the string
-				binary = to_string(currentBit) + binary;
-			}
-			return binary;							// Return the string
-		}
-};
-
-/*****************************************************************************
-Function name:    main
-Purpose:          Main program loop, get user input and outputs results
-Input parameters: None
-Return value:     int - returns 0 if program terminates with no errors
-******************************************************************************/
-int main() {
-	UserInterface interface;						// Instantiate interface object
-	do {											// Repeat until user terminates
-		// Prompt user for integer size / associativity inputs
-		int memorySize = interface.valuePrompt("Enter the size of main memory in bytes: ",4,32768);
-		int cacheSize = interface.valuePrompt("Enter the size of the cache in bytes: ",2,memorySize);
-		int cacheBlockSize = interface.valuePrompt("Enter the cache block/line size: ",2,cacheSize);
-		int cacheBlocks = cacheSize/cacheBlockSize;	// Number of cache blocks is size over block size 
-		cout << endl;								// Print blank line for spacing
-		int associativity = interface.valuePrompt("Enter the degree of set-associativity "
-									"(input n for an n-way set-associative mapping): ",1,cacheBlocks);
-		// Prompt user for replacement policy
-		ReplacementPolicy policy = interface.replacementPolicyPrompt();
-		// Prompt user for memory reference file and read the file of memory references
-		vector<MemoryReference> memoryReferences = interface.memoryReferenceFilePrompt(memorySize);
-		
-		cout << endl << "Simulator Output:" << endl;
-		// Create simulator with user provided cache and main memory sizes and layout
-		MemorySimulator simulator(memorySize,cacheSize,cacheBlockSize,associativity,policy);
-		simulator.printMemoryInfo();				// Print information about the memory devices buses
-		simulator.runSimulation(memoryReferences);	// Run simulation with memory references from file
-		simulator.printCache();						// Print the final state of the cache device
-	} while(interface.repeatPrompt());				// Prompt user and conditionally restart program
-	return 0;
-}
\ No newline at end of file
+/*
+  ECE 487 Laboratory 7
+  Memory Simulator
+  A simulator for a two-level momeory heirarchy using set-associative cache mapping. Parameters are prompted
+  from the user and memory access operations are given in a file provided by the user. The simulator
+  calculates various operational and performance characteristics of the given memory system including
+  cache size, bits required for each field, hit rate, operating status, and final status.
+  
+  Compile:	g++ -std=c++11 -Wall -O2 -march=native -pthread Lab7.cpp -o Lab7.out
+  			(-march enables the AVX2 tag search where supported, SSE2 / scalar is used otherwise)
+  Run:		./Lab7.out											(interactive prompts)
+  			./Lab7.out --trace trace.txt --cache 1024 --block 16 --ways 4 --policy L [--config file]
+  			(non-interactive, see ./Lab7.out --help for every option)
+  Convert:	./Lab7.out convert trace.txt trace.bin [raw]	(text trace to compact binary trace)
+  Sweep:	./Lab7.out sweep trace.txt 16 32768 [16 [0.01]]	(LRU miss ratio curve of every cache size)
+  Batch:	./Lab7.out batch trace.txt configs.txt [threads]	(simulate many configurations in parallel)
+  Parallel:	./Lab7.out parallel trace.txt 32768 1024 16 4 L [threads]	(one simulation split by set)
+  Hierarchy:	./Lab7.out hierarchy trace.txt levels.txt		(L1I/L1D, L2, L3... caches and TLBs)
+  Coherence:	./Lab7.out coherence trace.txt MESI 1024 64 4 L [hot lines]	(private caches per core)
+  Generate:	./Lab7.out generate ZIPFIAN 1000000 1048576 trace.bin [64 25 1]	(synthetic binary trace)
+  Bench:	./Lab7.out bench 1000000 [filter]			(references per second of the simulator core)
+  Library:	g++ -std=c++11 -O2 -march=native -pthread -DMEM_SIMULATOR_LIBRARY -c Lab7.cpp
+  			(no main or tools and nothing exported but mem_simulator.h, for linking into other programs)
+  Check:	checks/check_policies.sh ./Lab7.out		(LRU, FIFO and OPT hit counts of a fixed trace)
+  			g++ -std=c++11 -O2 -pthread -I. checks/trace_reader_check.cpp -o check && ./check
+  			(every trace format streams back unchanged and its pages are released)
+  Capture:	g++ -std=c++11 -O2 -pthread program.cpp trace_capture.cpp -o program
+  			(binary traces of an instrumented program's loads and stores, see trace_capture.h)
+  
+  Jonathan Platt
+  11807130
+*/
+
+#include <algorithm>								// Imported for min / max and sorting (sort)
+#include <chrono>									// Imported for timing simulations (steady_clock)
+#include <condition_variable>						// Imported for waiting on reference queues
+#include <cerrno>									// Imported for system call errors (errno)
+#include <climits>									// Imported for integer limits (INT_MAX, LLONG_MAX)
+#include <cmath>									// Imported for the Zipfian distribution (pow)
+#include <cstdint>									// Imported for fixed width integers (uint64_t)
+#include <cstdlib>									// Imported for aligned allocation (posix_memalign)
+#include <cstring>									// Imported for raw memory operations (memcpy)
+#include <deque>									// Imported for worker task queues (deque)
+#include <fstream>									// Imported for working with files (ifstream, ofstream)
+#include <functional>								// Imported for storing tasks (function)
+#include <iostream>									// Imported for interacting with user (cout, cin)
+#include <iomanip>									// Imported for improving printing (setw, setprecision)
+#include <memory>									// Imported for owning pointers (unique_ptr)
+#include <mutex>									// Imported for locking task queues (mutex)
+#include <sstream>									// Imported for parsing configuration lines
+#include <string>									// Imported for strings
+#include <thread>									// Imported for worker threads (thread)
+#include <unordered_map>							// Imported for hash tables (unordered_map)
+#include <vector>									// Imported for vectors
+#include <new>										// Imported for allocation failures (bad_alloc)
+#ifdef __SSE2__
+#include <immintrin.h>								// Imported for SIMD tag comparison (SSE2 / AVX2)
+#endif
+#include <fcntl.h>									// Imported for opening trace files (open)
+#include <sys/mman.h>								// Imported for memory-mapping trace files (mmap)
+#include <sys/stat.h>								// Imported for getting trace file sizes (fstat)
+#include <strings.h>								// Imported for reading policy names (strcasecmp)
+#include <unistd.h>									// Imported for closing trace files (close)
+#include "mem_simulator.h"							// The library interface (CacheSimulator)
+
+using namespace std;								// Use standard namespace for brevity and convenience
+
+// The library keeps every name but those of mem_simulator.h to itself, so none can collide with the
+// names of the program it is linked into
+#ifdef MEM_SIMULATOR_LIBRARY
+namespace {
+#endif
+
+// Simple enumerated type for the cache's replacement policy
+enum ReplacementPolicy {LRU,FIFO,OPT,				// LRU is Least Recently Used
+						TREE_PLRU,BIT_PLRU,			// FIFO is First In First Out
+						SRRIP,BRRIP,DRRIP,			// OPT is Belady's offline optimal policy
+						RANDOM,LFU};				// The rest are tree and bit pseudo-LRU, static,
+													// bimodal and dynamic re-reference interval
+													// prediction, random and least frequently used
+const int NUM_POLICIES = LFU + 1;
+
+// The name of each replacement policy, in the order of the enumerated type
+const char* const POLICY_NAMES[NUM_POLICIES] = {"LRU","FIFO","OPT","PLRU","BIT-PLRU",
+												"SRRIP","BRRIP","DRRIP","RANDOM","LFU"};
+// Simple enumerated type for whether an operation is a data read, a data write or an
+// instruction fetch (which only a hierarchy with a split L1 instruction cache treats apart)
+enum ReadWrite {READ, WRITE, FETCH};
+
+// Simple enumerated type for whether a memory access results in a hit or miss
+enum HitMiss {HIT, MISS};
+
+// Simple enumerated type for how a level of a cache hierarchy relates to the levels above it:
+// holding every block they hold, none of them, or neither rule (non-inclusive non-exclusive)
+enum InclusionPolicy {INCLUSIVE, EXCLUSIVE, NINE};
+const int NUM_INCLUSION_POLICIES = NINE + 1;
+const char* const INCLUSION_NAMES[NUM_INCLUSION_POLICIES] = {"INCLUSIVE","EXCLUSIVE","NINE"};
+
+// Simple enumerated types for whether a write marks the cached block dirty or is passed straight
+// on to the next level, and whether a write miss fills the block into the cache
+enum WritePolicy {WRITE_BACK, WRITE_THROUGH};
+enum WriteAllocation {WRITE_ALLOCATE, NO_WRITE_ALLOCATE};
+const char* const WRITE_POLICY_NAMES[2] = {"WRITE-BACK","WRITE-THROUGH"};
+const char* const WRITE_ALLOCATION_NAMES[2] = {"WRITE-ALLOCATE","NO-WRITE-ALLOCATE"};
+
+// Simple enumerated type for the hardware prefetcher run alongside the demand accesses: none,
+// the next blocks after a miss, a stride learned per memory region, or a sequential stream
+enum PrefetcherType {NO_PREFETCHER, NEXT_LINE, STRIDE, STREAM};
+const int NUM_PREFETCHERS = STREAM + 1;
+const char* const PREFETCHER_NAMES[NUM_PREFETCHERS] = {"NONE","NEXT-LINE","STRIDE","STREAM"};
+
+// Simple enumerated type for how a block number picks where a cache may hold it: its low bits
+// (modulo the number of sets), its low bits XORed with the bits above them, or one hash per way
+// into each way's own bank (skewed-associative), searched further by relocating blocks (zcache)
+enum IndexFunction {MODULO_INDEX, XOR_INDEX, SKEWED_INDEX, ZCACHE_INDEX};
+const int NUM_INDEX_FUNCTIONS = ZCACHE_INDEX + 1;
+const char* const INDEX_NAMES[NUM_INDEX_FUNCTIONS] = {"MODULO","XOR","SKEWED","ZCACHE"};
+
+// Simple enumerated types for the snooping protocol keeping the private caches of a multi-core
+// simulation coherent, and the state of a block under it (MESI never uses OWNED, in which a
+// block is dirty but shared, with its owner supplying it to the other cores)
+enum CoherenceProtocol {MESI, MOESI};
+const char* const PROTOCOL_NAMES[2] = {"MESI","MOESI"};
+enum CoherenceState {STATE_INVALID, STATE_SHARED, STATE_EXCLUSIVE, STATE_OWNED, STATE_MODIFIED};
+
+// Simple enumerated type for the access pattern of a synthetic trace: consecutive words, a fixed
+// stride, uniformly random or Zipfian distributed elements, or a random cycle of dependent loads
+enum TracePattern {SEQUENTIAL, STRIDED, UNIFORM, ZIPFIAN, POINTER_CHASE};
+const int NUM_PATTERNS = POINTER_CHASE + 1;
+const char* const PATTERN_NAMES[NUM_PATTERNS] = {"SEQUENTIAL","STRIDED","UNIFORM","ZIPFIAN","POINTER-CHASE"};
+
+// The page sizes of the virtual memory front end: 4 KB base pages, and 2 MB and 1 GB huge pages
+// mapped one and two levels higher up the page table, and the address bits each one spans
+const int NUM_PAGE_SIZES = 3;
+const char* const PAGE_SIZE_NAMES[NUM_PAGE_SIZES] = {"4K","2M","1G"};
+const int PAGE_SIZE_BITS[NUM_PAGE_SIZES] = {12,21,30};
+
+/*****************************************************************************
+Struct name:      MemoryReference
+Purpose:          Stores a single memory reference operation (read / write)
+                  and the address being operated on, and the core making it
+******************************************************************************/
+struct MemoryReference {
+	ReadWrite operation;							// Whether the operation is read or write 
+	int64_t memoryAddress;							// The memory address being read / written
+	int core;										// The core making the reference (0 unless
+													// the trace records cores)
+};
+
+/*****************************************************************************
+Function name:    log2
+Purpose:          Calculates and return the base 2 logarithm of the input
+Input parameters: value - int - the number to take the logarithm of
+Return value:     int - the base 2 logarithm of the input rounded down to an
+                        integer. If the input is less than 1, 0 is returned.
+******************************************************************************/
+int log2(int value) {
+	int power = 0;									// Initialize power (answer) to 0
+	while(value > 1) {								// While the input value is > 1 (log2(value) > 0)
+		value = value >> 1;							// Right shift value 1 bit (divide by 2)
+		power++;									// Increment the power value
+	}
+	return power;									// Return power once value <= 1
+}
+
+/*****************************************************************************
+Function name:    log2
+Purpose:          Calculates and return the base 2 logarithm of a 64-bit input
+Input parameters: value - int64_t - the number to take the logarithm of
+Return value:     int - the base 2 logarithm of the input rounded down to an
+                        integer. If the input is less than 1, 0 is returned.
+******************************************************************************/
+int log2(int64_t value) {
+	int power = 0;									// Initialize power (answer) to 0
+	while(value > 1) {								// While the input value is > 1 (log2(value) > 0)
+		value = value >> 1;							// Right shift value 1 bit (divide by 2)
+		power++;									// Increment the power value
+	}
+	return power;									// Return power once value <= 1
+}
+
+/*****************************************************************************
+Function name:    policyName
+Purpose:          Gets the printable name of a replacement policy
+Input parameters: policy - ReplacementPolicy - the policy to name
+Return value:     string - the policy's name
+******************************************************************************/
+string policyName(ReplacementPolicy policy) {
+	return POLICY_NAMES[policy];
+}
+
+/*****************************************************************************
+Function name:    parsePolicy
+Purpose:          Reads a replacement policy from its letter (L, F or O) or
+                  its name in any case
+Input parameters: text - string - the policy, for example "L" or "srrip"
+                  policy - ReplacementPolicy& - set to the policy read
+Return value:     bool - true if the text names a policy, false if not
+******************************************************************************/
+bool parsePolicy(string text, ReplacementPolicy& policy) {
+	if(text == "L" || text == "l") text = "LRU";	// The original single letter choices
+	else if(text == "F" || text == "f") text = "FIFO";
+	else if(text == "O" || text == "o") text = "OPT";
+	for(int i = 0; i < NUM_POLICIES; i++) {
+		if(strcasecmp(text.c_str(),POLICY_NAMES[i]) == 0) {
+			policy = (ReplacementPolicy)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*****************************************************************************
+Function name:    hasSharedPolicyState
+Purpose:          Returns if a replacement policy keeps state shared by every
+                  set (a random number generator or a set dueling counter),
+                  or needs the references in trace order, so that the sets
+                  cannot be simulated independently
+Input parameters: policy - ReplacementPolicy - the policy to check
+Return value:     bool - true if the sets depend on each other, false if not
+******************************************************************************/
+bool hasSharedPolicyState(ReplacementPolicy policy) {
+	return policy == OPT || policy == BRRIP || policy == DRRIP || policy == RANDOM;
+}
+
+/*****************************************************************************
+Function name:    parseWritePolicy
+Purpose:          Reads a write policy from its name or abbreviation (WB or
+                  WT) in any case
+Input parameters: text - string - the write policy, for example "wt"
+                  writePolicy - WritePolicy& - set to the policy read
+Return value:     bool - true if the text names a policy, false if not
+******************************************************************************/
+bool parseWritePolicy(string text, WritePolicy& writePolicy) {
+	if(strcasecmp(text.c_str(),"WB") == 0 || strcasecmp(text.c_str(),WRITE_POLICY_NAMES[0]) == 0) {
+		writePolicy = WRITE_BACK;
+	}
+	else if(strcasecmp(text.c_str(),"WT") == 0 || strcasecmp(text.c_str(),WRITE_POLICY_NAMES[1]) == 0) {
+		writePolicy = WRITE_THROUGH;
+	}
+	else return false;
+	return true;
+}
+
+/*****************************************************************************
+Function name:    parseWriteAllocation
+Purpose:          Reads a write miss allocation policy from its name or
+                  abbreviation (WA or NWA) in any case
+Input parameters: text - string - the allocation policy, for example "nwa"
+                  writeAllocation - WriteAllocation& - set to the policy read
+Return value:     bool - true if the text names a policy, false if not
+******************************************************************************/
+bool parseWriteAllocation(string text, WriteAllocation& writeAllocation) {
+	if(strcasecmp(text.c_str(),"WA") == 0 || strcasecmp(text.c_str(),WRITE_ALLOCATION_NAMES[0]) == 0) {
+		writeAllocation = WRITE_ALLOCATE;
+	}
+	else if(strcasecmp(text.c_str(),"NWA") == 0 || strcasecmp(text.c_str(),WRITE_ALLOCATION_NAMES[1]) == 0) {
+		writeAllocation = NO_WRITE_ALLOCATE;
+	}
+	else return false;
+	return true;
+}
+
+/*****************************************************************************
+Function name:    parsePrefetcher
+Purpose:          Reads a prefetcher from its name in any case
+Input parameters: text - string - the prefetcher, for example "stride"
+                  prefetcher - PrefetcherType& - set to the prefetcher read
+Return value:     bool - true if the text names a prefetcher, false if not
+******************************************************************************/
+bool parsePrefetcher(string text, PrefetcherType& prefetcher) {
+	for(int i = 0; i < NUM_PREFETCHERS; i++) {
+		if(strcasecmp(text.c_str(),PREFETCHER_NAMES[i]) == 0) {
+			prefetcher = (PrefetcherType)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*****************************************************************************
+Function name:    parseIndexFunction
+Purpose:          Reads a cache index function from its name in any case
+Input parameters: text - string - the index function, for example "xor"
+                  index - IndexFunction& - set to the index function read
+Return value:     bool - true if the text names an index function, false if not
+******************************************************************************/
+bool parseIndexFunction(string text, IndexFunction& index) {
+	for(int i = 0; i < NUM_INDEX_FUNCTIONS; i++) {
+		if(strcasecmp(text.c_str(),INDEX_NAMES[i]) == 0) {
+			index = (IndexFunction)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+#ifndef MEM_SIMULATOR_LIBRARY						// Only the command line tools read these
+/*****************************************************************************
+Function name:    parseInclusion
+Purpose:          Reads a cache hierarchy inclusion policy from its name in
+                  any case
+Input parameters: text - string - the inclusion policy, for example "nine"
+                  inclusion - InclusionPolicy& - set to the policy read
+Return value:     bool - true if the text names a policy, false if not
+******************************************************************************/
+bool parseInclusion(string text, InclusionPolicy& inclusion) {
+	for(int i = 0; i < NUM_INCLUSION_POLICIES; i++) {
+		if(strcasecmp(text.c_str(),INCLUSION_NAMES[i]) == 0) {
+			inclusion = (InclusionPolicy)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*****************************************************************************
+Function name:    parseProtocol
+Purpose:          Reads a cache coherence protocol from its name in any case
+Input parameters: text - string - the protocol, for example "moesi"
+                  protocol - CoherenceProtocol& - set to the protocol read
+Return value:     bool - true if the text names a protocol, false if not
+******************************************************************************/
+bool parseProtocol(string text, CoherenceProtocol& protocol) {
+	if(strcasecmp(text.c_str(),PROTOCOL_NAMES[MESI]) == 0) protocol = MESI;
+	else if(strcasecmp(text.c_str(),PROTOCOL_NAMES[MOESI]) == 0) protocol = MOESI;
+	else return false;
+	return true;
+}
+
+/*****************************************************************************
+Function name:    parsePattern
+Purpose:          Reads a synthetic trace pattern from its name in any case
+Input parameters: text - string - the pattern, for example "zipfian"
+                  pattern - TracePattern& - set to the pattern read
+Return value:     bool - true if the text names a pattern, false if not
+******************************************************************************/
+bool parsePattern(string text, TracePattern& pattern) {
+	for(int i = 0; i < NUM_PATTERNS; i++) {
+		if(strcasecmp(text.c_str(),PATTERN_NAMES[i]) == 0) {
+			pattern = (TracePattern)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*****************************************************************************
+Function name:    parsePageSize
+Purpose:          Reads a page size from its name in any case
+Input parameters: text - string - the page size, 4K, 2M or 1G
+                  pageSize - int& - set to the index of the page size
+Return value:     bool - true if the text names a page size, false if not
+******************************************************************************/
+bool parsePageSize(string text, int& pageSize) {
+	for(int i = 0; i < NUM_PAGE_SIZES; i++) {
+		if(strcasecmp(text.c_str(),PAGE_SIZE_NAMES[i]) == 0) {
+			pageSize = i;
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+// The largest main memory size supported, which keeps every address and packed binary trace
+// record of reads and writes within 64 bits
+const int64_t MAX_MEMORY_SIZE = (int64_t)1 << 62;
+
+// Binary trace records that keep instruction fetches spend a second bit on the operation, so their
+// addresses must stay below this for every packed record (and zigzag encoded delta) to fit in 64 bits
+const int64_t MAX_FETCH_TRACE_ADDRESS = (int64_t)1 << 61;
+
+// The largest cache size supported, which keeps every cache block and set number within an int
+const int MAX_CACHE_SIZE = 1 << 30;
+
+// The most cores a multi-core trace may reference, so a set of cores fits in one 64-bit mask
+const int MAX_CORES = 64;
+
+// The number of memory references handed to the simulator at a time while streaming a trace
+const int TRACE_CHUNK_SIZE = 4096;
+
+// Parsed pages of a streamed trace are released in steps of this many bytes, a multiple of any page
+// size, counted from the start of the (page aligned) mapping
+const size_t TRACE_RELEASE_SIZE = 1 << 16;
+
+// The next use of a block that is never referenced again, which OPT replaces first
+const int64_t NEVER_REFERENCED = INT64_MAX;
+
+// Traces do not record access sizes, so a write sent to memory without its block (write-through
+// or a no-write-allocate miss) is counted as one word of this many bytes
+const int WRITE_WORD_SIZE = 4;
+
+// The most blocks a victim cache may hold, since it is searched in full on every miss
+const int MAX_VICTIM_ENTRIES = 64;
+
+// How many levels of the relocation tree a zcache walks for replacement candidates, and the most
+// candidates it considers (a 4-way zcache walking 3 levels considers 4 + 12 + 36 = 52 blocks)
+const int ZCACHE_WALK_LEVELS = 3;
+const int MAX_ZCACHE_CANDIDATES = 64;
+
+// The most blocks a prefetcher may request after one access (its highest degree)
+const int MAX_PREFETCH_DEGREE = 16;
+
+// The skew of Zipfian synthetic traces, the exponent used by the YCSB benchmarks: the element of
+// rank i is referenced in proportion to 1 / i^0.99
+const double ZIPF_EXPONENT = 0.99;
+
+// The least time each benchmark is repeated for, so short runs are still measured reliably
+const double MIN_BENCHMARK_SECONDS = 0.1;
+
+// The fewest access times the stack distance analyzer's Fenwick tree holds before renumbering
+const int64_t MIN_ACCESS_TIMES = 1 << 16;
+
+// Sampled simulations keep a block or set when this many top bits of its hash, read as a
+// fraction, fall below the sampling rate, so rates down to 1 in 2^24 can be given
+const int SAMPLE_HASH_BITS = 24;
+
+// Sampled estimates are reported with 95% confidence intervals: this many standard errors
+const double CONFIDENCE_Z = 1.96;
+
+// Independent groups the SHARDS sample is split into, by hash, to estimate its error
+const int SAMPLE_GROUPS = 16;
+
+// Phase detection compares working set signatures, the references of an interval counted in
+// this many buckets of hashed blocks
+const int SIGNATURE_BUCKETS = 4096;
+
+// The working set of an interval is estimated from a bit vector with one bit per hashed block
+// referenced: 4 bits per reference in an interval, kept between 2^12 and 2^20 bits
+const int MIN_WORKING_SET_BITS = 1 << 12;
+const int MAX_WORKING_SET_BITS = 1 << 20;
+
+// An interval starts a new phase when this share of its references or more falls on other blocks
+// than the last interval's did (half the Manhattan distance of the normalized signatures)
+const double PHASE_THRESHOLD = 0.5;
+
+// The most phase signatures kept to recognise a phase when it recurs
+const int MAX_PHASES = 64;
+
+// Page tables are x86-64 style radix trees: 4 levels of 4 KB tables, each indexed by the next 9
+// bits of the virtual address and holding 512 entries of 8 bytes
+const int PAGE_TABLE_LEVELS = 4;
+const int PAGE_TABLE_INDEX_BITS = 9;
+const int PAGE_TABLE_ENTRY_SIZE = 8;
+
+// Binary traces start with a 16 byte header: the magic "MSTR", a 16-bit version, 16-bit flags
+// and the 64-bit number of references, all little-endian. One record per reference follows,
+// packing the operation into the low bit and the address above it: (address << 1) | operation.
+// Traces with instruction fetches set TRACE_FETCH_OPERATIONS and use the low two bits instead.
+// Multi-core traces set TRACE_CORE_IDS and put a byte holding the core before each record.
+// Records are raw 64-bit words, or if TRACE_DELTA_ENCODED is set, LEB128 varints in which the
+// address is replaced by the zigzag-encoded difference from the previous record's address
+const char TRACE_MAGIC[4] = {'M','S','T','R'};
+const uint16_t TRACE_VERSION = 1;
+const uint16_t TRACE_DELTA_ENCODED = 1;				// Flag bit for delta/varint encoded records
+const uint16_t TRACE_FETCH_OPERATIONS = 2;			// Flag bit for records with 2-bit operations
+const uint16_t TRACE_CORE_IDS = 4;					// Flag bit for records with a core byte
+const int TRACE_HEADER_SIZE = 16;
+
+// Checkpoints start with the magic "MSCK" and a 16-bit version, then 64-bit fields describing the
+// cache (which must match the cache restoring it) and the trace position, in the host's byte
+// order. The statistics, the cache's storage and the table of distinct blocks referenced follow
+const char CHECKPOINT_MAGIC[4] = {'M','S','C','K'};
+const uint16_t CHECKPOINT_VERSION = 2;
+const int CHECKPOINT_CACHE_FIELDS = 10;				// Fields that must match: sizes, policies, the
+													// index function and the sizes of the
+													// statistics and the storage
+const int CHECKPOINT_FIELDS = 12;					// Then the next reference and the first counted
+
+/*****************************************************************************
+******************************************************************************
+Class name:       TraceReader
+Purpose:          Memory-maps a memory reference file and streams its
+                  references out in bounded chunks, so that memory use stays
+                  constant regardless of the length of the trace
+******************************************************************************/
+class TraceReader {
+	public:
+/*****************************************************************************
+Function name:    TraceReader (constructor)
+Purpose:          Creates a TraceReader object with no file mapped
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		TraceReader() {
+			fileDescriptor = -1;					// No file is open yet
+			fileBegin = fileEnd = cursor = NULL;	// And nothing is mapped
+			firstReference = released = NULL;
+			releasedBytes = 0;
+			ownsMapping = releasing = false;
+			binary = false;
+			fetches = false;
+			numCores = 1;
+			highestAddress = 0;
+			numReferences = 0;
+			referencesRead = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    ~TraceReader (destructor)
+Purpose:          Unmaps and closes the trace file if one is open
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		~TraceReader() {
+			close();
+		}
+
+/*****************************************************************************
+Function name:    open
+Purpose:          Opens and memory-maps the given trace file, closing any
+                  previously opened file
+Input parameters: file - const string& - the name of the trace file to open
+Return value:     bool - true if the file was opened, false if not
+******************************************************************************/
+		bool open(const string& file) {
+			close();								// Release any previously mapped file
+			fileDescriptor = ::open(file.c_str(),O_RDONLY);
+			if(fileDescriptor < 0) return false;	// The file could not be opened
+			struct stat fileStatus;					// Get the size of the file to map
+			if(fstat(fileDescriptor,&fileStatus) < 0) {
+				close();
+				return false;
+			}
+			fileLength = fileStatus.st_size;
+			if(fileLength > 0) {					// Empty files can not be mapped (nothing to read)
+				void* mapping = mmap(NULL,fileLength,PROT_READ,MAP_PRIVATE,fileDescriptor,0);
+				if(mapping == MAP_FAILED) {
+					close();
+					return false;
+				}
+				// The trace is read front to back, so let the kernel read ahead aggressively
+				madvise(mapping,fileLength,MADV_SEQUENTIAL);
+				fileBegin = (const char*)mapping;
+				fileEnd = fileBegin + fileLength;
+			}
+			ownsMapping = releasing = true;
+			// Binary traces are recognised by their magic number, anything else is parsed as text
+			binary = fileLength >= (size_t)TRACE_HEADER_SIZE && memcmp(fileBegin,TRACE_MAGIC,4) == 0;
+			firstReference = fileBegin;
+			rewind();
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    share
+Purpose:          Makes this reader stream the same validated trace as another
+                  reader, sharing its read-only mapping instead of mapping the
+                  file again. The source reader must outlive this one
+Input parameters: source - const TraceReader& - an open and validated reader
+Return value:     none
+******************************************************************************/
+		void share(const TraceReader& source) {
+			close();
+			fileLength = source.fileLength;			// Point at the source's mapping without owning it
+			fileBegin = source.fileBegin;
+			fileEnd = source.fileEnd;
+			firstReference = source.firstReference;
+			binary = source.binary;
+			fetches = source.fetches;
+			numCores = source.numCores;
+			highestAddress = source.highestAddress;
+			traceFlags = source.traceFlags;
+			numReferences = source.numReferences;
+			rewind();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    close
+Purpose:          Unmaps and closes the trace file if one is open
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void close() {
+			if(fileBegin != NULL && ownsMapping) munmap((void*)fileBegin,fileLength);
+			if(fileDescriptor >= 0) ::close(fileDescriptor);
+			ownsMapping = false;
+			fileDescriptor = -1;
+			fileBegin = fileEnd = cursor = NULL;
+			firstReference = released = NULL;
+			releasedBytes = 0;
+			binary = false;
+			fetches = false;
+			numCores = 1;
+			highestAddress = 0;
+			numReferences = 0;
+			referencesRead = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    validate
+Purpose:          Checks every reference in the trace without storing them,
+                  then rewinds the trace so it can be streamed
+Input parameters: memorySize - int64_t - the memory size in bytes (addresses
+                                         must be below it)
+                  error - string& - set to a description of the first error
+Return value:     bool - true if the trace is valid, false if not
+******************************************************************************/
+		bool validate(int64_t memorySize, string& error) {
+			if(binary) return validateBinary(memorySize,error);
+			cursor = released = fileBegin;			// Start from the reference count on the first line
+			numReferences = 0;
+			const char* tokenStart;					// Bounds of the token currently being checked
+			const char* tokenEnd;
+			int64_t value;							// Stores a number parsed from the file
+			// Read the first line (containing number of refs), which must be an integer above 0
+			if(!nextToken(tokenStart,tokenEnd) || !parseNumber(tokenStart,tokenEnd,value) || value < 1) {
+				error = "File must contain at least 1 memory reference.";
+				return false;
+			}
+			firstReference = cursor;				// Streaming restarts just after the count
+			fetches = false;
+			numCores = 1;
+			highestAddress = 0;
+			int64_t expectedReferences = value;
+			for(int64_t i = 0; i < expectedReferences; i++) {
+				// A reference may start with the number of the core making it
+				bool found = nextToken(tokenStart,tokenEnd);
+				if(found && *tokenStart >= '0' && *tokenStart <= '9') {
+					if(!parseNumber(tokenStart,tokenEnd,value) || value >= MAX_CORES) {
+						error = "Input file contains an invalid core on line " + to_string(3 + i) + ".";
+						return false;
+					}
+					numCores = max(numCores,(int)value + 1);
+					found = nextToken(tokenStart,tokenEnd);
+				}
+				// The operation must be exactly an 'R', a 'W' or an 'I' (instruction fetch)
+				if(!found || tokenEnd - tokenStart != 1
+				   || (*tokenStart != 'R' && *tokenStart != 'W' && *tokenStart != 'I')) {
+					error = "Input file contains an invalid operation on line " + to_string(3 + i) + ".";
+					return false;
+				}
+				if(*tokenStart == 'I') fetches = true;
+				// The address must be an integer between 0 and the memory size
+				if(!nextToken(tokenStart,tokenEnd) || !parseNumber(tokenStart,tokenEnd,value)
+				   || value < 0 || value >= memorySize) {
+					error = "Input file contains an invalid memory address on line " + to_string(3 + i) + ".";
+					return false;
+				}
+				highestAddress = max(highestAddress,value);
+				if((i & (TRACE_CHUNK_SIZE - 1)) == 0) releaseConsumed();
+			}
+			numReferences = expectedReferences;
+			rewind();								// Start streaming from the first reference
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    readChunk
+Purpose:          Parses the next references of a validated trace into the
+                  given buffer
+Input parameters: chunk - MemoryReference* - buffer to store references in
+                  maxReferences - int - the capacity of the buffer
+Return value:     int - the number of references stored, 0 at end of trace
+******************************************************************************/
+		int readChunk(MemoryReference* chunk, int maxReferences) {
+			int count = 0;							// The number of references parsed into the chunk
+			const char* tokenStart;
+			const char* tokenEnd;
+			if(binary) {							// Binary records decode straight into the chunk
+				while(count < maxReferences
+					  && nextRecord(chunk[count].memoryAddress,chunk[count].operation,chunk[count].core)) count++;
+				return count;
+			}
+			while(count < maxReferences && referencesRead < numReferences) {
+				int64_t core = 0;
+				nextToken(tokenStart,tokenEnd);		// Core if given, then operation (checked by validate)
+				if(*tokenStart >= '0' && *tokenStart <= '9') {
+					parseNumber(tokenStart,tokenEnd,core);
+					nextToken(tokenStart,tokenEnd);
+				}
+				chunk[count].core = (int)core;
+				chunk[count].operation = (*tokenStart == 'W') ? WRITE : (*tokenStart == 'I') ? FETCH : READ;
+				nextToken(tokenStart,tokenEnd);		// Memory address (checked by validate)
+				parseNumber(tokenStart,tokenEnd,chunk[count].memoryAddress);
+				count++;
+				referencesRead++;
+			}
+			releaseConsumed();						// Drop the pages that have now been parsed
+			return count;
+		}
+
+/*****************************************************************************
+Function name:    getNumReferences
+Purpose:          Gets the number of references in the validated trace
+Input parameters: none
+Return value:     int64_t - the number of memory references in the trace
+******************************************************************************/
+		int64_t getNumReferences() {
+			return numReferences;
+		}
+
+/*****************************************************************************
+Function name:    isBinary
+Purpose:          Gets whether the open trace is in the binary trace format
+Input parameters: none
+Return value:     bool - true for a binary trace, false for a text trace
+******************************************************************************/
+		bool isBinary() {
+			return binary;
+		}
+
+/*****************************************************************************
+Function name:    hasFetches
+Purpose:          Gets whether the validated trace may contain instruction
+                  fetches as well as reads and writes
+Input parameters: none
+Return value:     bool - true if the trace has instruction fetches
+******************************************************************************/
+		bool hasFetches() {
+			return fetches;
+		}
+
+/*****************************************************************************
+Function name:    getHighestAddress
+Purpose:          Gets the highest address referenced by the validated trace
+Input parameters: none
+Return value:     int64_t - the highest memory address referenced
+******************************************************************************/
+		int64_t getHighestAddress() {
+			return highestAddress;
+		}
+
+/*****************************************************************************
+Function name:    getNumCores
+Purpose:          Gets the number of cores referenced by the validated trace
+Input parameters: none
+Return value:     int - one more than the highest core making a reference
+                        (1 if the trace does not record cores)
+******************************************************************************/
+		int getNumCores() {
+			return numCores;
+		}
+
+/*****************************************************************************
+Function name:    getReleasedBytes
+Purpose:          Gets how much of the mapped trace has been handed back to
+                  the kernel after being parsed
+Input parameters: none
+Return value:     int64_t - the number of bytes released since the trace
+                            was opened
+******************************************************************************/
+		int64_t getReleasedBytes() {
+			return releasedBytes;
+		}
+
+/*****************************************************************************
+Function name:    nextRecord
+Purpose:          Decodes the next reference of a validated binary trace
+                  directly from the mapped file
+Input parameters: memoryAddress - int64_t& - set to the reference's address
+                  operation - ReadWrite& - set to the reference's operation
+Return value:     bool - true if a reference was decoded, false at the end
+******************************************************************************/
+		bool nextRecord(int64_t& memoryAddress, ReadWrite& operation) {
+			int core;
+			return nextRecord(memoryAddress,operation,core);
+		}
+
+/*****************************************************************************
+Function name:    nextRecord
+Purpose:          Decodes the next reference of a validated binary trace,
+                  including the core making it
+Input parameters: memoryAddress - int64_t& - set to the reference's address
+                  operation - ReadWrite& - set to the reference's operation
+                  core - int& - set to the reference's core (0 if the trace
+                                does not record cores)
+Return value:     bool - true if a reference was decoded, false at the end
+******************************************************************************/
+		bool nextRecord(int64_t& memoryAddress, ReadWrite& operation, int& core) {
+			if(referencesRead == numReferences) {
+				releaseConsumed();					// Drop the pages of the finished trace
+				return false;
+			}
+			decodeRecord(memoryAddress,operation,core);
+			// Periodically drop the pages that have already been decoded
+			if((++referencesRead & (TRACE_CHUNK_SIZE - 1)) == 0) releaseConsumed();
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    rewind
+Purpose:          Restarts streaming from the first reference of the trace
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void rewind() {
+			cursor = firstReference;				// Skip the reference count or header
+			// Release from the start of the step holding the first reference, as madvise only takes
+			// page aligned addresses
+			released = fileBegin + ((firstReference - fileBegin) & ~(TRACE_RELEASE_SIZE - 1));
+			referencesRead = 0;
+			previousAddress = 0;					// Delta encoding starts from address 0
+			return;
+		}
+
+/*****************************************************************************
+Function name:    skip
+Purpose:          Moves past the next references of a validated trace without
+                  returning them. Raw binary records are all the same size,
+                  so they are stepped over at once, while delta encoded and
+                  text references have to be decoded to find where they end
+Input parameters: count - int64_t - the number of references to skip
+Return value:     int64_t - the number of references skipped, fewer only at
+                            the end of the trace
+******************************************************************************/
+		int64_t skip(int64_t count) {
+			count = min(count,numReferences - referencesRead);
+			if(binary && !(traceFlags & TRACE_DELTA_ENCODED)) {
+				cursor += count*(8 + ((traceFlags & TRACE_CORE_IDS) ? 1 : 0));
+				referencesRead += count;
+				releaseConsumed();
+				return count;
+			}
+			MemoryReference reference;
+			for(int64_t i = 0; i < count; i++) readChunk(&reference,1);
+			releaseConsumed();
+			return count;
+		}
+	private:
+		int fileDescriptor;							// Descriptor of the open trace file, or -1
+		size_t fileLength;							// The length of the mapped file in bytes
+		const char* fileBegin;						// Start of the mapped file, or NULL
+		const char* fileEnd;						// One past the end of the mapped file
+		const char* cursor;							// The next character to be tokenized
+		const char* firstReference;					// The first character after the reference count
+		const char* released;						// Pages before this have been released
+		int64_t releasedBytes;						// Bytes released so far
+		bool ownsMapping;							// Whether this reader mapped the file itself
+		bool releasing;								// Whether parsed pages are being released
+		bool binary;								// Whether the file is a binary trace
+		bool fetches;								// Whether the trace has instruction fetches
+		int numCores;								// The number of cores referenced
+		int64_t highestAddress;						// The highest address referenced
+		uint16_t traceFlags;						// The header flags of a binary trace
+		int64_t previousAddress;					// Last decoded address (for delta encoding)
+		int64_t numReferences;						// The number of references in the trace
+		int64_t referencesRead;						// The number of references streamed so far
+
+/*****************************************************************************
+Function name:    validateBinary
+Purpose:          Checks the header and every record of a binary trace, then
+                  rewinds the trace so it can be streamed
+Input parameters: memorySize - int64_t - the memory size in bytes (addresses
+                                         must be below it)
+                  error - string& - set to a description of the first error
+Return value:     bool - true if the trace is valid, false if not
+******************************************************************************/
+		bool validateBinary(int64_t memorySize, string& error) {
+			uint16_t version;						// Header fields
+			uint64_t headerReferences;
+			memcpy(&version,fileBegin + 4,sizeof(version));
+			memcpy(&traceFlags,fileBegin + 6,sizeof(traceFlags));
+			memcpy(&headerReferences,fileBegin + 8,sizeof(headerReferences));
+			numReferences = 0;
+			if(version != TRACE_VERSION
+			   || (traceFlags & ~(TRACE_DELTA_ENCODED | TRACE_FETCH_OPERATIONS | TRACE_CORE_IDS)) != 0) {
+				error = "Unsupported binary trace version " + to_string(version) + ".";
+				return false;
+			}
+			if(headerReferences < 1 || headerReferences > (uint64_t)INT64_MAX) {
+				error = "File must contain at least 1 memory reference.";
+				return false;
+			}
+			firstReference = fileBegin + TRACE_HEADER_SIZE;
+			fetches = (traceFlags & TRACE_FETCH_OPERATIONS) != 0;
+			numCores = 1;
+			highestAddress = 0;
+			rewind();
+			int64_t address;
+			ReadWrite operation = READ;
+			int core;
+			for(uint64_t i = 0; i < headerReferences; i++) {
+				if(!decodeRecord(address,operation,core)) {
+					error = "Input file is truncated at memory reference " + to_string(i + 1) + ".";
+					return false;
+				}
+				if(address < 0 || address >= memorySize) {
+					error = "Input file contains an invalid memory address in reference "
+							+ to_string(i + 1) + ".";
+					return false;
+				}
+				if(operation > FETCH) {
+					error = "Input file contains an invalid operation in reference " + to_string(i + 1) + ".";
+					return false;
+				}
+				if(core >= MAX_CORES) {
+					error = "Input file contains an invalid core in reference " + to_string(i + 1) + ".";
+					return false;
+				}
+				numCores = max(numCores,core + 1);
+				highestAddress = max(highestAddress,address);
+				if((i & (TRACE_CHUNK_SIZE - 1)) == 0) releaseConsumed();
+			}
+			numReferences = (int64_t)headerReferences;
+			rewind();								// Start streaming from the first record
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    decodeRecord
+Purpose:          Decodes the binary record at the cursor and advances past it
+Input parameters: address - int64_t& - set to the record's address
+                  operation - ReadWrite& - set to the record's operation
+                  core - int& - set to the record's core, or 0
+Return value:     bool - true if a whole record was decoded, false if the
+                         file ends part way through the record
+******************************************************************************/
+		bool decodeRecord(int64_t& address, ReadWrite& operation, int& core) {
+			uint64_t value = 0;						// The packed record value
+			core = 0;
+			if(traceFlags & TRACE_CORE_IDS) {		// Core byte ahead of the record
+				if(cursor == fileEnd) return false;
+				core = (unsigned char)*cursor++;
+			}
+			if(traceFlags & TRACE_DELTA_ENCODED) {	// LEB128 varint, 7 bits per byte
+				int shift = 0;
+				do {
+					if(cursor == fileEnd || shift > 63) return false;
+					value |= (uint64_t)(*cursor & 0x7f) << shift;
+					shift += 7;
+				} while(*cursor++ & 0x80);
+			}
+			else {									// Raw 64-bit little-endian word
+				if(fileEnd - cursor < 8) return false;
+				memcpy(&value,cursor,sizeof(value));
+				cursor += 8;
+			}
+			if(traceFlags & TRACE_FETCH_OPERATIONS) {	// Two operation bits
+				operation = (ReadWrite)(value & 3);
+				value >>= 2;
+			}
+			else {
+				operation = (value & 1) ? WRITE : READ;
+				value >>= 1;
+			}
+			if(traceFlags & TRACE_DELTA_ENCODED) {	// Undo the zigzag encoding and add the delta
+				int64_t delta = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+				previousAddress += delta;
+				address = previousAddress;
+			}
+			else address = (int64_t)value;
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    nextToken
+Purpose:          Finds the next whitespace separated token in the file and
+                  advances the cursor past it
+Input parameters: tokenStart - const char*& - set to the start of the token
+                  tokenEnd - const char*& - set to one past the token's end
+Return value:     bool - true if a token was found, false at end of file
+******************************************************************************/
+		bool nextToken(const char*& tokenStart, const char*& tokenEnd) {
+			const char* position = cursor;
+			// Skip leading whitespace (spaces, tabs, and line breaks)
+			while(position < fileEnd && (*position == ' ' || (*position >= '\t' && *position <= '\r'))) {
+				position++;
+			}
+			tokenStart = position;
+			while(position < fileEnd && *position != ' ' && (*position < '\t' || *position > '\r')) {
+				position++;
+			}
+			tokenEnd = cursor = position;
+			return tokenStart != tokenEnd;
+		}
+
+/*****************************************************************************
+Function name:    parseNumber
+Purpose:          Converts a token to a 64-bit integer, rejecting anything
+                  that is not an optionally signed decimal integer, or a
+                  hexadecimal integer with a leading "0x", within range
+Input parameters: tokenStart - const char* - the start of the token
+                  tokenEnd - const char* - one past the end of the token
+                  value - int64_t& - set to the parsed value
+Return value:     bool - true if the token is a valid integer, false if not
+******************************************************************************/
+		bool parseNumber(const char* tokenStart, const char* tokenEnd, int64_t& value) {
+			bool negative = false;					// Whether the number has a leading minus sign
+			if(tokenStart < tokenEnd && (*tokenStart == '-' || *tokenStart == '+')) {
+				negative = (*tokenStart == '-');
+				tokenStart++;
+			}
+			uint64_t base = 10;						// Addresses captured from tools are often in hex
+			if(tokenEnd - tokenStart > 2 && tokenStart[0] == '0' && (tokenStart[1] == 'x' || tokenStart[1] == 'X')) {
+				base = 16;
+				tokenStart += 2;
+			}
+			if(tokenStart == tokenEnd) return false;// A sign with no digits is not a number
+			uint64_t result = 0;					// Unsigned to detect overflow before it happens
+			for(; tokenStart < tokenEnd; tokenStart++) {
+				uint64_t digit;
+				char character = *tokenStart;
+				if(character >= '0' && character <= '9') digit = character - '0';
+				else if(base == 16 && character >= 'a' && character <= 'f') digit = character - 'a' + 10;
+				else if(base == 16 && character >= 'A' && character <= 'F') digit = character - 'A' + 10;
+				else return false;
+				// Too large to be a signed 64-bit integer
+				if(result > ((uint64_t)INT64_MAX - digit)/base) return false;
+				result = result*base + digit;
+			}
+			value = negative ? -(int64_t)result : (int64_t)result;
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    releaseConsumed
+Purpose:          Tells the kernel the pages already parsed are not needed,
+                  so the resident size of the mapping does not grow
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void releaseConsumed() {
+			// Pages of a shared mapping may still be needed by the other readers
+			if(!ownsMapping || !releasing) return;
+			size_t consumed = (cursor - released) & ~(TRACE_RELEASE_SIZE - 1);
+			if(consumed == 0) return;
+			if(madvise((void*)released,consumed,MADV_DONTNEED) != 0) {
+				// Keep streaming without releasing rather than fail the simulation
+				cerr << "Warning: Parsed trace pages could not be released: " << strerror(errno) << endl;
+				releasing = false;
+				return;
+			}
+			released += consumed;
+			releasedBytes += consumed;
+			return;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       TraceWriter
+Purpose:          Writes memory references to a file in the binary trace
+                  format, optionally delta/varint encoded
+******************************************************************************/
+class TraceWriter {
+	public:
+/*****************************************************************************
+Function name:    ~TraceWriter (destructor)
+Purpose:          Finishes the trace file if it is still open
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		~TraceWriter() {
+			close();
+		}
+
+/*****************************************************************************
+Function name:    open
+Purpose:          Creates the trace file and writes a placeholder header
+Input parameters: file - const string& - the name of the trace file to create
+                  deltaEncoded - bool - whether to delta/varint encode records
+                  fetchOperations - bool - whether records need room for
+                                           instruction fetches
+                  coreIds - bool - whether records store the core making them
+Return value:     bool - true if the file was created, false if not
+******************************************************************************/
+		bool open(const string& file, bool deltaEncoded, bool fetchOperations = false, bool coreIds = false) {
+			close();
+			outputFile.open(file,ios::out | ios::binary | ios::trunc);
+			if(!outputFile) return false;
+			flags = (deltaEncoded ? TRACE_DELTA_ENCODED : 0) | (fetchOperations ? TRACE_FETCH_OPERATIONS : 0)
+					| (coreIds ? TRACE_CORE_IDS : 0);
+			operationBits = fetchOperations ? 2 : 1;
+			previousAddress = 0;
+			numReferences = 0;
+			writeHeader();							// The reference count is filled in by close
+			return (bool)outputFile;
+		}
+
+/*****************************************************************************
+Function name:    write
+Purpose:          Appends a single memory reference to the trace
+Input parameters: memoryAddress - int64_t - the address being referenced
+                                            (below MAX_FETCH_TRACE_ADDRESS if
+                                            opened for fetches)
+                  operation - ReadWrite - whether the reference is a read, a
+                                          write or (if opened for fetches) an
+                                          instruction fetch
+                  core - int - the core making the reference (only stored if
+                               opened for core IDs)
+Return value:     none
+******************************************************************************/
+		void write(int64_t memoryAddress, ReadWrite operation, int core = 0) {
+			char record[11];						// Large enough for a core and any 64-bit varint
+			int length = 0;
+			if(flags & TRACE_CORE_IDS) record[length++] = (char)core;
+			if(flags & TRACE_DELTA_ENCODED) {
+				int64_t delta = memoryAddress - previousAddress;
+				previousAddress = memoryAddress;
+				// Zigzag encode the delta so small negative steps are small numbers too
+				uint64_t value = (((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63)) << operationBits | operation;
+				while(value >= 0x80) {				// Emit 7 bits at a time, low bits first
+					record[length++] = (char)(value | 0x80);
+					value >>= 7;
+				}
+				record[length++] = (char)value;
+			}
+			else {
+				uint64_t value = (uint64_t)memoryAddress << operationBits | operation;
+				memcpy(record + length,&value,sizeof(value));
+				length += sizeof(value);
+			}
+			outputFile.write(record,length);
+			numReferences++;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    close
+Purpose:          Fills in the header's reference count and closes the file
+Input parameters: none
+Return value:     bool - true if the whole trace was written successfully
+******************************************************************************/
+		bool close() {
+			if(!outputFile.is_open()) return false;
+			outputFile.seekp(0);					// Rewrite the header with the final count
+			writeHeader();
+			bool success = (bool)outputFile;
+			outputFile.close();
+			return success;
+		}
+	private:
+		ofstream outputFile;						// The trace file being written
+		uint16_t flags;								// The header flags of the trace
+		int operationBits;							// Low record bits holding the operation
+		int64_t previousAddress;					// Last written address (for delta encoding)
+		uint64_t numReferences;						// The number of references written
+
+/*****************************************************************************
+Function name:    writeHeader
+Purpose:          Writes the trace header at the current file position
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void writeHeader() {
+			char header[TRACE_HEADER_SIZE];
+			memcpy(header,TRACE_MAGIC,4);
+			memcpy(header + 4,&TRACE_VERSION,sizeof(TRACE_VERSION));
+			memcpy(header + 6,&flags,sizeof(flags));
+			memcpy(header + 8,&numReferences,sizeof(numReferences));
+			outputFile.write(header,TRACE_HEADER_SIZE);
+			return;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       TraceGenerator
+Purpose:          Generates a deterministic synthetic trace of memory
+                  references within a footprint of memory. The footprint is
+                  divided into elements (the stride of a strided trace): a
+                  sequential trace reads consecutive words, the other
+                  patterns reference whole elements. The same pattern,
+                  sizes and seed always generate the same trace
+******************************************************************************/
+class TraceGenerator {
+	public:
+/*****************************************************************************
+Function name:    TraceGenerator (constructor)
+Purpose:          Creates a generator, building the Zipfian constants or the
+                  pointer chase cycle the pattern needs
+Input parameters: pattern - TracePattern - the access pattern to generate
+                  footprint - int64_t - the bytes of memory referenced
+                  elementSize - int - the bytes in each element (the stride)
+                  writePercent - int - the percentage of references that are
+                                       writes
+                  seed - uint64_t - the seed of the random choices
+Return value:     none
+******************************************************************************/
+		TraceGenerator(TracePattern pattern, int64_t footprint, int elementSize, int writePercent, uint64_t seed) {
+			this->pattern = pattern;
+			this->elementSize = elementSize;
+			this->writePercent = writePercent;
+			numElements = max(footprint/elementSize,(int64_t)1);
+			numWords = max(footprint/WRITE_WORD_SIZE,(int64_t)1);
+			// Spread the seed's bits (splitmix64) as the cache's random policies do
+			seed = (seed ^ (seed >> 30))*0xBF58476D1CE4E5B9ULL;
+			seed = (seed ^ (seed >> 27))*0x94D049BB133111EBULL;
+			randomState = (seed ^ (seed >> 31)) | 1;
+			position = 0;
+			if(pattern == ZIPFIAN) {
+				// Constants of Gray et al.'s method, which draws a rank in constant time
+				zetaN = 0;
+				for(int64_t i = 1; i <= numElements; i++) zetaN += 1/pow((double)i,ZIPF_EXPONENT);
+				zipfAlpha = 1/(1 - ZIPF_EXPONENT);
+				zipfEta = (1 - pow(2.0/numElements,1 - ZIPF_EXPONENT))/(1 - (1 + pow(0.5,ZIPF_EXPONENT))/zetaN);
+			}
+			else if(pattern == POINTER_CHASE) {
+				// Sattolo's algorithm shuffles the elements into a single cycle, so the chase visits
+				// every element once before repeating, in an order no prefetcher can predict
+				nextElement.resize(numElements);
+				for(int64_t i = 0; i < numElements; i++) nextElement[i] = i;
+				for(int64_t i = numElements - 1; i > 0; i--) swap(nextElement[i],nextElement[nextRandom() % i]);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    next
+Purpose:          Generates the next memory reference of the trace
+Input parameters: memoryAddress - int64_t& - set to the address referenced
+                  operation - ReadWrite& - set to whether it is a read or a
+                                           write
+Return value:     none
+******************************************************************************/
+		void next(int64_t& memoryAddress, ReadWrite& operation) {
+			switch(pattern) {
+				case SEQUENTIAL:					// Consecutive words, wrapping at the footprint
+					memoryAddress = position*WRITE_WORD_SIZE;
+					position = (position + 1 == numWords) ? 0 : position + 1;
+					break;
+				case STRIDED:						// One element after another
+					memoryAddress = position*elementSize;
+					position = (position + 1 == numElements) ? 0 : position + 1;
+					break;
+				case UNIFORM:
+					memoryAddress = (int64_t)(nextRandom() % numElements)*elementSize;
+					break;
+				case ZIPFIAN:						// Rank 0, the most referenced, is at address 0
+					memoryAddress = zipfianRank()*elementSize;
+					break;
+				case POINTER_CHASE:
+					memoryAddress = position*elementSize;
+					position = nextElement[position];
+					break;
+			}
+			operation = ((int)(nextRandom() % 100) < writePercent) ? WRITE : READ;
+			return;
+		}
+	private:
+		TracePattern pattern;						// The access pattern generated
+		int elementSize;							// The bytes in each element
+		int writePercent;							// The percentage of references that write
+		int64_t numElements;						// The elements in the footprint
+		int64_t numWords;							// The words in the footprint
+		uint64_t randomState;						// The random number generator's state
+		int64_t position;							// The next word or element of sequential,
+													// strided and pointer chase traces
+		double zetaN;								// Zipfian only: the sum of 1 / i^exponent
+		double zipfAlpha;							// Zipfian only: 1 / (1 - exponent)
+		double zipfEta;								// Zipfian only: the scale of the rank formula
+		vector<int64_t> nextElement;				// Pointer chase only: the element each points to
+
+/*****************************************************************************
+Function name:    nextRandom
+Purpose:          Gets the next number of the random sequence (xorshift64*)
+Input parameters: none
+Return value:     uint64_t - the next random number
+******************************************************************************/
+		uint64_t nextRandom() {
+			randomState ^= randomState >> 12;
+			randomState ^= randomState << 25;
+			randomState ^= randomState >> 27;
+			return randomState*0x2545F4914F6CDD1DULL;
+		}
+
+/*****************************************************************************
+Function name:    zipfianRank
+Purpose:          Draws the rank of an element from the Zipfian distribution
+Input parameters: none
+Return value:     int64_t - the rank, 0 being the most likely
+******************************************************************************/
+		int64_t zipfianRank() {
+			double uniform = (nextRandom() >> 11)*(1.0/9007199254740992.0);	// 53 random bits in [0,1)
+			double scaled = uniform*zetaN;
+			if(scaled < 1) return 0;
+			if(scaled < 1 + pow(0.5,ZIPF_EXPONENT)) return 1;
+			int64_t rank = (int64_t)(numElements*pow(zipfEta*uniform - zipfEta + 1,zipfAlpha));
+			return min(rank,numElements - 1);
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       UserInterface
+Purpose:          Prompt the user for input of memory simulator parameters
+******************************************************************************/
+class UserInterface {
+	public:
+/*****************************************************************************
+Function name:    valuePrompt
+Purpose:          Prompt the user for the value of a particular memory feature
+Input parameters: prompt - string - the prompt to print to the user
+                  minimumVal - int64_t - the minimum value of the feature
+                  maximumVal - int64_t - the maximum value of the feature
+Return value:     int64_t - the recieved numerical user input
+******************************************************************************/
+		int64_t valuePrompt(string prompt, int64_t minimumVal, int64_t maximumVal) {
+			int64_t size = -1;						// Stores the size recieved from the user
+			string buffer;							// String buffer in case of non-numeric input
+			while(true) {							// Repeat until we recieve valid input
+				cout << prompt;						// Prompt the user using the functions 'prompt' input
+				cin >> size;						// Store user input in 'size'
+				// If size is a power of two within the limits, return it
+				if(size >= minimumVal && size <= maximumVal && isPowerOfTwo(size)) return size;
+				// Otherwise, inform the use their input is invalud
+				cout << "Error: Value must be an integer power of two between "
+				     << minimumVal << " and " << maximumVal << "." << endl;
+				if (cin.fail()) {					// If 'cin' fails (non-integer input)
+					cin.clear();					// Clear the error
+					cin >> buffer;					// Read the erroneous input into the string buffer
+				}
+			}
+		}
+/*****************************************************************************
+Function name:    replacementPolicyPrompt
+Purpose:          Prompt the user for the memory's replacement policy
+Input parameters: None
+Return value:     ReplacementPolicy - the user selected replacement policy
+******************************************************************************/
+		ReplacementPolicy replacementPolicyPrompt() {
+			string text;							// Stores the text input recieved from the user
+			while(true) {							// Repeat until we recieve valid input
+				cout << "Enter the replacement policy (L = LRU, F = FIFO, O = OPT, "
+						"or PLRU, BIT-PLRU, SRRIP, BRRIP, DRRIP, RANDOM, LFU): ";
+				cin >> text;
+				ReplacementPolicy policy;
+				if(parsePolicy(text,policy)) return policy;
+				// If no policy is detected, print and error and reprompt the user
+				cout << "Error: Enter an 'L', an 'F', an 'O' or one of the policy names" << endl;
+			}
+		}
+/*****************************************************************************
+Function name:    memoryReferenceFilePrompt
+Purpose:          Prompt the user for the memory reference file, then open and
+                  validate it so the references can be streamed from it
+Input parameters: memorySize - int64_t - the memorySize size in bytes
+                  traceReader - TraceReader& - the reader to open the file with
+Return value:     none (the trace reader is left open on the validated file)
+******************************************************************************/
+		void memoryReferenceFilePrompt(int64_t memorySize, TraceReader& traceReader) {
+			string file;							// Stores the input file handle
+			string error;							// Stores the reason a file was rejected
+			while(true) {							// Repeat until we recieve a valid file
+				cout << "Enter the name of the input file containing the list of "
+						"memory references generated by the CPU: ";
+				cin >> file;
+				if(!traceReader.open(file)) {		// If the file cannot be opened, print an error
+					cout << "Error: Input file: \"" << file << "\" not found" << endl;
+					continue;						// Restart the loop
+				}
+				// Check every reference in the file, printing an error and reprompting if any are bad
+				if(traceReader.validate(memorySize,error)) return;
+				cout << "Error: " << error << endl;
+			}
+		}
+/*****************************************************************************
+Function name:    optimalPrompt
+Purpose:          Prompt the user if they would like the hit rate of the
+                  optimal (OPT) policy on their cache, the best achievable,
+                  which replays the trace a second time
+Input parameters: None
+Return value:     bool - The user's response (true to replay under OPT)
+******************************************************************************/
+		bool optimalPrompt() {
+			string text;							// Stores the text input recieved from the user
+			while(true) {							// Repeat until we recieve valid input
+				cout << "Also find the best achievable (OPT) hit rate by replaying the trace? (y = yes, n = no): ";
+				cin >> text;
+				if(text == "Y" || text == "y") return true;			// If 'y' (yes), return true
+				else if(text == "N" || text == "n") return false;	// If 'n' (no), return false
+				// If neither a Y or N is detected, print and error and reprompt the user
+				cout << "Error: Character must be a 'y' or an 'n'" << endl;
+			}
+		}
+/*****************************************************************************
+Function name:    repeatPrompt
+Purpose:          Prompt the user if they would like to continue / repeat
+Input parameters: None
+Return value:     bool - The user's response (true to repeat, false to end)
+******************************************************************************/
+		bool repeatPrompt() {
+			string text;							// Stores the text input recieved from the user
+			while(true) {							// Repeat until we recieve valid input
+				cout << "Continue? (y = yes, n = no): ";
+				cin >> text;
+				if(text == "Y" || text == "y") return true;			// If 'y' (yes), return true
+				else if(text == "N" || text == "n") return false;	// If 'n' (no), return false
+				// If neither a Y or N is detected, print and error and reprompt the user
+				cout << "Error: Character must be a 'y' or an 'n'" << endl;
+			}
+		}
+	private:
+/*****************************************************************************
+Function name:    powerOfTwo
+Purpose:          Returns if the input is a nonnegative integer power of two
+Input parameters: value - int64_t - the input to check if it is a power of two
+Return value:     bool - true is the input is a power of two, false if not
+******************************************************************************/
+		bool isPowerOfTwo(int64_t value) {
+			if(value < 1) return false;				// Numbers below 1 are not nonnegative powers of two
+			return (value & (value - 1)) == 0;		// Powers of two have exactly one bit set
+		}
+};
+
+/*****************************************************************************
+Struct name:      CacheBlock
+Purpose:          Stores the components of a simple cache block including
+                  dirty bit, valid bit, tag, and data, where data stores the
+                  number of the memory block stored in the cache block. Used
+                  as a snapshot of a block gathered from the cache storage
+******************************************************************************/
+struct CacheBlock {
+	int dirtyBit = 0;								// 1 if the cache has had a 'write', 0 if not
+	int validBit = 0;								// 1 if the cache contains valid data, 0 if not
+	int64_t tag = -1;								// The cache's tag value, or -1 if unknown
+	int64_t data = -1;								// The number of the memory block in the cache
+};													// or -1 is unknown or not set
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CacheStorage
+Purpose:          Holds the state of every cache block of a cache in one
+                  contiguous, cache-line-aligned structure-of-arrays: a tag
+                  array, packed valid and dirty bitmaps and the replacement
+                  priority lists (or, for OPT, each set's heap of next uses,
+                  and for the other policies a packed state byte per block
+                  and state bits per set), with the blocks of each set kept
+                  adjacent
+******************************************************************************/
+class CacheStorage {
+	public:
+		int cacheSets;								// The number of cache sets
+		int associativity;							// The number of cache blocks per set
+		ReplacementPolicy policy;					// The replacement policy of every set
+		int64_t* tags;								// Tag of each block, or -1 if never filled
+		uint64_t* validBits;						// One valid bit per block, packed 64 per word
+		uint64_t* dirtyBits;						// One dirty bit per block, packed 64 per word
+		int* previousBlock;							// Lower priority neighbour of each block in its
+													// set's priority list, or -1 if none
+		int* nextBlock;								// Higher priority neighbour, or -1 if none
+		int* priorityEnds;							// Lowest and highest priority block of each set
+		int64_t* nextUses;							// OPT only: the next reference to each block
+		int* heapBlocks;							// OPT only: each set's blocks as a max-heap on
+													// their next use, furthest first
+		int* heapPositions;							// OPT only: each block's index in its set's heap
+		uint8_t* blockStates;						// Other policies: each block's re-reference
+													// prediction value or use count
+		uint64_t* setStates;						// Other policies: each set's tree or MRU bits,
+													// one bit per block, setStateWords words per set
+		int setStateWords;							// The number of state words per set
+		uint64_t randomState;						// Random number generator shared by every set
+		int policySelector;							// DRRIP's set dueling counter, above the middle
+													// when the BRRIP leader sets miss less
+
+/*****************************************************************************
+Function name:    CacheStorage (constructor)
+Purpose:          Allocates and initializes the storage for an empty cache
+Input parameters: cacheSets - int - the number of cache sets
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - whether to follow FIFO, LRU
+                                               or OPT
+Return value:     none
+******************************************************************************/
+		CacheStorage(int cacheSets, int associativity, ReplacementPolicy policy) {
+			this->cacheSets = cacheSets;
+			this->associativity = associativity;
+			this->policy = policy;
+			size_t blocks = (size_t)cacheSets*associativity;
+			size_t bitWords = (blocks + 63)/64;		// Words needed for one bit per block
+			// Carve every array out of one allocation, starting each on its own cache line
+			size_t tagBytes = alignToLine(blocks*sizeof(int64_t));
+			size_t linkBytes = alignToLine(blocks*sizeof(int));
+			size_t bitBytes = alignToLine(bitWords*sizeof(uint64_t));
+			size_t endBytes = alignToLine(2*(size_t)cacheSets*sizeof(int));
+			size_t heapBytes = (policy == OPT) ? tagBytes + 2*linkBytes : 0;
+			bool packedState = (policy != LRU && policy != FIFO && policy != OPT);
+			setStateWords = (associativity + 63)/64;
+			size_t blockStateBytes = packedState ? alignToLine(blocks) : 0;
+			size_t setStateBytes = packedState ? alignToLine((size_t)cacheSets*setStateWords*sizeof(uint64_t)) : 0;
+			totalBytes = tagBytes + 2*linkBytes + 2*bitBytes + endBytes + heapBytes + blockStateBytes + setStateBytes;
+			void* allocation = NULL;
+			if(posix_memalign(&allocation,CACHE_LINE_SIZE,totalBytes) != 0) throw bad_alloc();
+			memory = (char*)allocation;
+			tags = (int64_t*)memory;
+			validBits = (uint64_t*)(memory + tagBytes);
+			dirtyBits = (uint64_t*)(memory + tagBytes + bitBytes);
+			previousBlock = (int*)(memory + tagBytes + 2*bitBytes);
+			nextBlock = (int*)(memory + tagBytes + linkBytes + 2*bitBytes);
+			priorityEnds = (int*)(memory + tagBytes + 2*linkBytes + 2*bitBytes);
+			nextUses = NULL;
+			heapBlocks = NULL;
+			heapPositions = NULL;
+			if(policy == OPT) {						// The heaps follow the priority lists
+				char* heapMemory = memory + tagBytes + 2*linkBytes + 2*bitBytes + endBytes;
+				nextUses = (int64_t*)heapMemory;
+				heapBlocks = (int*)(heapMemory + tagBytes);
+				heapPositions = (int*)(heapMemory + tagBytes + linkBytes);
+			}
+			blockStates = NULL;
+			setStates = NULL;
+			if(packedState) {						// The packed state follows the priority lists
+				blockStates = (uint8_t*)(memory + tagBytes + 2*linkBytes + 2*bitBytes + endBytes);
+				setStates = (uint64_t*)(memory + tagBytes + 2*linkBytes + 2*bitBytes + endBytes + blockStateBytes);
+				memset(blockStates,0,blockStateBytes + setStateBytes);
+			}
+			seedRandom(1);
+			policySelector = POLICY_SELECTOR_MAX/2;
+			memset(validBits,0,2*bitBytes);			// No block is valid or dirty yet
+			for(size_t i = 0; i < blocks; i++) {
+				int offset = i % associativity;		// Block offset within its set
+				tags[i] = -1;						// Tag unknown
+				// Link each set's blocks into its priority list in order of their position index,
+				// meaning that lower indicies are first in the queue to be replaced (ie lower slots
+				// in cache filled 1st)
+				previousBlock[i] = offset - 1;
+				nextBlock[i] = (offset == associativity - 1) ? -1 : offset + 1;
+				if(policy == OPT) {					// Empty blocks are never referenced, so OPT
+					nextUses[i] = NEVER_REFERENCED;	// fills them before replacing anything
+					heapBlocks[i] = offset;
+					heapPositions[i] = offset;
+				}
+			}
+			for(int i = 0; i < cacheSets; i++) {
+				priorityEnds[2*i] = 0;				// First block to be replaced
+				priorityEnds[2*i + 1] = associativity - 1;	// Last block to be replaced
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    ~CacheStorage (destructor)
+Purpose:          Frees the storage of the cache
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		~CacheStorage() {
+			free(memory);
+		}
+
+/*****************************************************************************
+Function name:    seedRandom
+Purpose:          Seeds the random number generator used by the RANDOM and
+                  BRRIP policies, so that simulations can be repeated
+Input parameters: seed - uint64_t - the seed
+Return value:     none
+******************************************************************************/
+		void seedRandom(uint64_t seed) {
+			// Spread the seed's bits (splitmix64), since the generator may not start at 0
+			seed += 0x9E3779B97F4A7C15ULL;
+			seed = (seed ^ (seed >> 30))*0xBF58476D1CE4E5B9ULL;
+			seed = (seed ^ (seed >> 27))*0x94D049BB133111EBULL;
+			randomState = (seed ^ (seed >> 31)) | 1;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    nextRandom
+Purpose:          Gets the next number of the random sequence (xorshift64*)
+Input parameters: none
+Return value:     uint64_t - the next random number
+******************************************************************************/
+		uint64_t nextRandom() {
+			randomState ^= randomState >> 12;
+			randomState ^= randomState << 25;
+			randomState ^= randomState >> 27;
+			return randomState*0x2545F4914F6CDD1DULL;
+		}
+
+/*****************************************************************************
+Function name:    getSize
+Purpose:          Gets the size of the storage's allocation
+Input parameters: none
+Return value:     size_t - the number of bytes holding the cache's state
+******************************************************************************/
+		size_t getSize() {
+			return totalBytes;
+		}
+
+/*****************************************************************************
+Function name:    save
+Purpose:          Writes the state of every block and set to a checkpoint.
+                  The arrays hold block and set indexes rather than pointers,
+                  so the allocation is written as it is in one block
+Input parameters: output - ostream& - the checkpoint being written
+Return value:     none
+******************************************************************************/
+		void save(ostream& output) {
+			output.write(memory,totalBytes);
+			output.write((const char*)&randomState,sizeof(randomState));
+			output.write((const char*)&policySelector,sizeof(policySelector));
+			return;
+		}
+
+/*****************************************************************************
+Function name:    load
+Purpose:          Reads the state of every block and set back from a
+                  checkpoint of a cache with the same geometry and policy,
+                  straight into the allocation
+Input parameters: input - istream& - the checkpoint being read
+Return value:     bool - true if the whole state was read, false if not
+******************************************************************************/
+		bool load(istream& input) {
+			input.read(memory,totalBytes);
+			input.read((char*)&randomState,sizeof(randomState));
+			input.read((char*)&policySelector,sizeof(policySelector));
+			return (bool)input;
+		}
+
+		static const int POLICY_SELECTOR_MAX = 1023;	// DRRIP's counter is 10 bits wide
+	private:
+		static const size_t CACHE_LINE_SIZE = 64;	// Alignment of every array in bytes
+		char* memory;								// The single allocation holding every array
+		size_t totalBytes;							// The size of the allocation in bytes
+
+		CacheStorage(const CacheStorage&);			// Not copyable, it owns its allocation
+		CacheStorage& operator=(const CacheStorage&);
+
+/*****************************************************************************
+Function name:    alignToLine
+Purpose:          Rounds a size in bytes up to a whole number of cache lines
+Input parameters: bytes - size_t - the size to round up
+Return value:     size_t - the rounded size in bytes
+******************************************************************************/
+		static size_t alignToLine(size_t bytes) {
+			return (bytes + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+		}
+};
+
+// The replacement policies, one specialization per policy (defined after CacheSet)
+template<ReplacementPolicy POLICY> struct Replacement;
+struct ReReferenceInterval;
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CacheSet
+Purpose:          Models a cache set, which may contain multiple cache blocks,
+                  including keeping track a cache's priority (via the
+                  replacement policy's Replacement specialization)
+                  to faithfully model the cache's replacement policy. A set
+                  is a lightweight view of its blocks within a CacheStorage
+******************************************************************************/
+class CacheSet {
+	public:
+/*****************************************************************************
+Function name:    CacheSet (constructor)
+Purpose:          Creates a CacheSet object viewing one set of a cache
+Input parameters: storage - CacheStorage& - the storage of the whole cache
+                  setNumber - int - the number of the set within the cache
+Return value:     none
+******************************************************************************/
+		CacheSet(CacheStorage& storage, int setNumber) {
+			associativity = storage.associativity;	// Set the CacheSet object's associativity
+			policy = storage.policy;				// Set the CacheSet object's replacement policy
+			firstBlock = (size_t)setNumber*associativity;
+			tags = storage.tags + firstBlock;		// Point at this set's part of each array
+			previousBlock = storage.previousBlock + firstBlock;
+			nextBlock = storage.nextBlock + firstBlock;
+			priorityEnds = storage.priorityEnds + 2*setNumber;
+			nextUses = NULL;						// Only the policy's own state is set below
+			heapBlocks = heapPositions = NULL;
+			blockStates = NULL;
+			setStates = NULL;
+			if(policy == OPT) {
+				nextUses = storage.nextUses + firstBlock;
+				heapBlocks = storage.heapBlocks + firstBlock;
+				heapPositions = storage.heapPositions + firstBlock;
+			}
+			else if(storage.blockStates != NULL) {
+				blockStates = storage.blockStates + firstBlock;
+				setStates = storage.setStates + (size_t)setNumber*storage.setStateWords;
+			}
+			this->storage = &storage;
+			this->setNumber = setNumber;
+			validBits = storage.validBits;			// Bitmaps are indexed by the cache-wide block
+			dirtyBits = storage.dirtyBits;			// number (firstBlock + offset)
+			return;
+		}
+		
+/*****************************************************************************
+Function name:    getCacheBlock
+Purpose:          Gets the cache block at the specified offset within the set
+Input parameters: blockNumber - int - the offset of the block within the set
+Return value:     CacheBlock - the CacheBlock object with the given offset
+                               (data is left unset, since it depends on the
+                               number of sets in the cache)
+******************************************************************************/
+		CacheBlock getCacheBlock(int blockNumber) {
+			CacheBlock cacheBlock;					// Gather the block's fields from the storage
+			cacheBlock.dirtyBit = getBit(dirtyBits,blockNumber);
+			cacheBlock.validBit = getBit(validBits,blockNumber);
+			cacheBlock.tag = tags[blockNumber];
+			return cacheBlock;
+		}
+		
+/*****************************************************************************
+Function name:    access
+Purpose:          Reads or writes the block with the given tag, filling it
+                  into the set on a miss, following the set's replacement
+                  policy
+Input parameters: tag - int64_t - the tag of the memory block being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  nextUse - int64_t - OPT only, the number of the next
+                                      reference to the same memory block
+Return value:     HitMiss - whether the access was a hit or a miss
+******************************************************************************/
+		HitMiss access(int64_t tag, ReadWrite operation, int64_t nextUse = 0) {
+			switch(policy) {
+				case LRU: return access<LRU,0>(tag,operation);
+				case FIFO: return access<FIFO,0>(tag,operation);
+				case OPT: return access<OPT,0>(tag,operation,nextUse);
+				case TREE_PLRU: return access<TREE_PLRU,0>(tag,operation);
+				case BIT_PLRU: return access<BIT_PLRU,0>(tag,operation);
+				case SRRIP: return access<SRRIP,0>(tag,operation);
+				case BRRIP: return access<BRRIP,0>(tag,operation);
+				case DRRIP: return access<DRRIP,0>(tag,operation);
+				case RANDOM: return access<RANDOM,0>(tag,operation);
+				default: return access<LFU,0>(tag,operation);
+			}
+		}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Reads or writes the block with the given tag, filling it
+                  into the set on a miss. The replacement policy and, if not
+                  0, the associativity are fixed at compile time so that the
+                  access has no policy branches and a fixed size tag search
+Template params:  POLICY - ReplacementPolicy - the set's replacement policy
+                  ASSOCIATIVITY - int - the set's associativity, or 0 if it
+                                        is only known at run time
+Input parameters: tag - int64_t - the tag of the memory block being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  nextUse - int64_t - OPT only, the number of the next
+                                      reference to the same memory block
+                  evicted - CacheBlock* - if not NULL, set on a miss to the
+                                          block that was replaced
+Return value:     HitMiss - whether the access was a hit or a miss
+******************************************************************************/
+		template<ReplacementPolicy POLICY, int ASSOCIATIVITY>
+		HitMiss access(int64_t tag, ReadWrite operation, int64_t nextUse = 0, CacheBlock* evicted = NULL) {
+			// A fixed associativity replaces the run time one, so that the replacement policy's
+			// loops over the set also have a constant trip count
+			if(ASSOCIATIVITY != 0) associativity = ASSOCIATIVITY;
+			// Find the index of the cache block with the given tag
+			int cacheBlockIndex = findCacheBlock<ASSOCIATIVITY>(tag);
+			// Update the priority of the given index, returning the updated index
+			int updatedIndex = updatePriority<POLICY>(cacheBlockIndex,nextUse);
+			// Take a snapshot of the replaced block before it is overwritten
+			if(evicted != NULL && cacheBlockIndex != updatedIndex) *evicted = getCacheBlock(updatedIndex);
+			// If the operation is a WRITE, set the dirty bit
+			if(operation == WRITE) setBit(dirtyBits,updatedIndex,true);
+			// If the previous and updated index are the same, then the data was already
+			// in the cache and the access was a HIT
+			if(cacheBlockIndex == updatedIndex) return HIT;
+			// Otherwise, update the cache blocks parameters, including the dirty bit on a READ / FETCH
+			tags[updatedIndex] = tag;
+			if(operation != WRITE) setBit(dirtyBits,updatedIndex,false);
+			setBit(validBits,updatedIndex,true);
+			return MISS;							// Return a MISS (only reached if not a HIT)
+		}
+
+/*****************************************************************************
+Function name:    lookup
+Purpose:          Reads or writes the block with the given tag if it is in
+                  the set, updating its priority on a hit but leaving the set
+                  untouched on a miss, so that a cache hierarchy can search
+                  the next level before anything is replaced
+Input parameters: tag - int64_t - the tag of the memory block being accessed
+                  operation - ReadWrite - whether the access is a read/write
+Return value:     HitMiss - whether the access was a hit or a miss
+******************************************************************************/
+		HitMiss lookup(int64_t tag, ReadWrite operation) {
+			switch(policy) {
+				case LRU: return lookup<LRU,0>(tag,operation);
+				case FIFO: return lookup<FIFO,0>(tag,operation);
+				case OPT: return lookup<OPT,0>(tag,operation);
+				case TREE_PLRU: return lookup<TREE_PLRU,0>(tag,operation);
+				case BIT_PLRU: return lookup<BIT_PLRU,0>(tag,operation);
+				case SRRIP: return lookup<SRRIP,0>(tag,operation);
+				case BRRIP: return lookup<BRRIP,0>(tag,operation);
+				case DRRIP: return lookup<DRRIP,0>(tag,operation);
+				case RANDOM: return lookup<RANDOM,0>(tag,operation);
+				default: return lookup<LFU,0>(tag,operation);
+			}
+		}
+
+/*****************************************************************************
+Function name:    lookup
+Purpose:          Reads or writes the block with the given tag if it is in
+                  the set, with the replacement policy and, if not 0, the
+                  associativity fixed at compile time
+Template params:  POLICY - ReplacementPolicy - the set's replacement policy
+                  ASSOCIATIVITY - int - the set's associativity, or 0 if it
+                                        is only known at run time
+Input parameters: tag - int64_t - the tag of the memory block being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  nextUse - int64_t - OPT only, the number of the next
+                                      reference to the same memory block
+Return value:     HitMiss - whether the access was a hit or a miss
+******************************************************************************/
+		template<ReplacementPolicy POLICY, int ASSOCIATIVITY>
+		HitMiss lookup(int64_t tag, ReadWrite operation, int64_t nextUse = 0) {
+			if(ASSOCIATIVITY != 0) associativity = ASSOCIATIVITY;
+			int cacheBlockIndex = findCacheBlock<ASSOCIATIVITY>(tag);
+			if(cacheBlockIndex == -1) return MISS;
+			Replacement<POLICY>::hit(*this,cacheBlockIndex,nextUse);
+			if(operation == WRITE) setBit(dirtyBits,cacheBlockIndex,true);
+			return HIT;
+		}
+
+/*****************************************************************************
+Function name:    find
+Purpose:          Finds the block with the given tag in the set, without
+                  changing its priority
+Input parameters: tag - int64_t - the tag of the memory block to search for
+Return value:     int - the offset of the block within the set, or -1 if it
+                        is not in the set
+******************************************************************************/
+		int find(int64_t tag) {
+			return findCacheBlock<0>(tag);
+		}
+
+/*****************************************************************************
+Function name:    markDirty
+Purpose:          Marks the block with the given tag dirty, if it is in the
+                  set, without changing its priority
+Input parameters: tag - int64_t - the tag of the memory block
+Return value:     none
+******************************************************************************/
+		void markDirty(int64_t tag) {
+			int cacheBlockIndex = findCacheBlock<0>(tag);
+			if(cacheBlockIndex != -1) setBit(dirtyBits,cacheBlockIndex,true);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    fill
+Purpose:          Fills a block that is not in the set into the block chosen
+                  by the replacement policy
+Input parameters: tag - int64_t - the tag of the memory block to fill
+                  dirty - bool - whether the filled block is dirty
+Return value:     CacheBlock - the block that was replaced (its valid bit is
+                               0 if an empty block was filled)
+******************************************************************************/
+		CacheBlock fill(int64_t tag, bool dirty) {
+			int victim;								// The block to replace
+			switch(policy) {
+				case LRU: victim = fillPriority<LRU>(); break;
+				case FIFO: victim = fillPriority<FIFO>(); break;
+				case OPT: victim = fillPriority<OPT>(); break;
+				case TREE_PLRU: victim = fillPriority<TREE_PLRU>(); break;
+				case BIT_PLRU: victim = fillPriority<BIT_PLRU>(); break;
+				case SRRIP: victim = fillPriority<SRRIP>(); break;
+				case BRRIP: victim = fillPriority<BRRIP>(); break;
+				case DRRIP: victim = fillPriority<DRRIP>(); break;
+				case RANDOM: victim = fillPriority<RANDOM>(); break;
+				default: victim = fillPriority<LFU>(); break;
+			}
+			CacheBlock evicted = getCacheBlock(victim);
+			tags[victim] = tag;
+			setBit(dirtyBits,victim,dirty);
+			setBit(validBits,victim,true);
+			return evicted;
+		}
+
+/*****************************************************************************
+Function name:    invalidate
+Purpose:          Removes the block with the given tag from the set, if it is
+                  there, and makes it the next block to be replaced
+Input parameters: tag - int64_t - the tag of the memory block to remove
+                  dirty - bool& - set to whether the removed block was dirty
+Return value:     bool - true if the block was in the set, false if not
+******************************************************************************/
+		bool invalidate(int64_t tag, bool& dirty) {
+			int cacheBlockIndex = findCacheBlock<0>(tag);
+			if(cacheBlockIndex == -1) return false;
+			dirty = getBit(dirtyBits,cacheBlockIndex);
+			tags[cacheBlockIndex] = -1;				// No lookup can find the block any more
+			setBit(dirtyBits,cacheBlockIndex,false);
+			setBit(validBits,cacheBlockIndex,false);
+			// The packed state policies fill invalid blocks first, the others need the block
+			// moved to the front of their replacement order
+			if(policy == LRU || policy == FIFO) moveToFront(cacheBlockIndex);
+			else if(policy == OPT) {
+				nextUses[cacheBlockIndex] = NEVER_REFERENCED;
+				restoreHeap(heapPositions[cacheBlockIndex]);
+			}
+			return true;
+		}
+	private:
+		// Every replacement policy works directly on the set's metadata
+		template<ReplacementPolicy> friend struct Replacement;
+		friend struct ReReferenceInterval;
+
+		int associativity;							// Stores the associativity (blocks per set)
+		ReplacementPolicy policy;					// Stores the replacement policy
+		CacheStorage* storage;						// The whole cache, for state shared by every set
+		int setNumber;								// The number of the set within the cache
+		size_t firstBlock;							// Cache-wide number of the set's first block
+		int64_t* tags;								// The set's tags, one per block
+		uint64_t* validBits;						// The cache's valid bitmap
+		uint64_t* dirtyBits;						// The cache's dirty bitmap
+		// The blocks are kept in a doubly linked list in priority order, stored as block indicies,
+		// so a block can be moved to the back of the list in constant time
+		int* previousBlock;							// The next lower priority block, or -1 if none
+		int* nextBlock;								// The next higher priority block, or -1 if none
+		int* priorityEnds;							// The block first in line to be replaced,
+													// followed by the block last in line
+		int64_t* nextUses;							// OPT only: next reference to each block
+		int* heapBlocks;							// OPT only: blocks as a max-heap on next use
+		int* heapPositions;							// OPT only: each block's index in the heap
+		uint8_t* blockStates;						// Other policies: one state byte per block
+		uint64_t* setStates;						// Other policies: the set's tree or MRU bits
+
+/*****************************************************************************
+Function name:    findCacheBlock
+Purpose:          Find the index of the cache block with the given tag value,
+                  comparing a whole vector of tags at once where the CPU
+                  supports it. Blocks that were never filled hold tag -1,
+                  which no lookup uses, so valid bits need not be checked
+Template params:  ASSOCIATIVITY - int - the set's associativity, or 0 if it
+                                        is only known at run time
+Input parameters: tag - int64_t - the tag of the cache block to search for
+Return value:     int - index of the cache block with the provided tag
+                        or -1 if the tag is not found
+******************************************************************************/
+		template<int ASSOCIATIVITY>
+		int findCacheBlock(int64_t tag) {
+			// The number of blocks to search, a constant when the associativity is fixed
+			const int ways = (ASSOCIATIVITY != 0) ? ASSOCIATIVITY : associativity;
+#ifdef __AVX2__
+			if(ways >= 4) {							// Compare 4 tags per instruction
+				__m256i key = _mm256_set1_epi64x(tag);
+				for(int i = 0; i < ways; i += 4) {
+					__m256i block = _mm256_load_si256((const __m256i*)(tags + i));
+					int matches = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(block,key)));
+					if(matches != 0) return i + __builtin_ctz(matches);
+				}
+				return -1;
+			}
+#endif
+#ifdef __SSE2__
+			if(ways >= 2) {							// Compare 2 tags per instruction
+				__m128i key = _mm_set1_epi64x(tag);
+				for(int i = 0; i < ways; i += 2) {
+					__m128i block = _mm_load_si128((const __m128i*)(tags + i));
+					// SSE2 has no 64-bit compare, so a tag matches when both of its halves do
+					__m128i halves = _mm_cmpeq_epi32(block,key);
+					halves = _mm_and_si128(halves,_mm_shuffle_epi32(halves,_MM_SHUFFLE(2,3,0,1)));
+					int matches = _mm_movemask_pd(_mm_castsi128_pd(halves));
+					if(matches != 0) return i + __builtin_ctz(matches);
+				}
+				return -1;
+			}
+#endif
+			for(int i = 0; i < ways; i++) {			// for every block in the set
+				// Return the index if the block tag matches the provided tag
+				if(tags[i] == tag) return i;
+			}
+			return -1;								// Otherwise return -1 (block with tag not found)
+		}
+
+/*****************************************************************************
+Function name:    updatePriority
+Purpose:          Update the priority of the block that is being accessed,
+                  choosing the block to replace on a miss, through the
+                  policy's Replacement specialization
+Template params:  POLICY - ReplacementPolicy - the set's replacement policy
+Input parameters: cacheBlockID - int - index of the accessed cache block, or
+                                       -1 if the access was a miss
+                  nextUse - int64_t - OPT only, the number of the next
+                                      reference to the accessed block
+Return value:     int - index of the cache block holding the accessed data,
+                        which is the block to replace on a miss
+******************************************************************************/
+		template<ReplacementPolicy POLICY>
+		int updatePriority(int cacheBlockID, int64_t nextUse) {
+			if(cacheBlockID != -1) {				// If the block is already in cache (index not -1, hit)
+				Replacement<POLICY>::hit(*this,cacheBlockID,nextUse);
+				return cacheBlockID;
+			}
+			// Otherwise, if the block was not in cache (miss), replace the policy's chosen block
+			cacheBlockID = Replacement<POLICY>::victim(*this);
+			Replacement<POLICY>::fill(*this,cacheBlockID,nextUse);
+			return cacheBlockID;					// Return the updated block id
+		}
+
+/*****************************************************************************
+Function name:    fillPriority
+Purpose:          Chooses the block to replace on a miss and updates its
+                  priority as though it had been filled
+Template params:  POLICY - ReplacementPolicy - the set's replacement policy
+Input parameters: none
+Return value:     int - index of the cache block to replace
+******************************************************************************/
+		template<ReplacementPolicy POLICY>
+		int fillPriority() {
+			int cacheBlockID = Replacement<POLICY>::victim(*this);
+			Replacement<POLICY>::fill(*this,cacheBlockID,0);
+			return cacheBlockID;
+		}
+
+/*****************************************************************************
+Function name:    findInvalidBlock
+Purpose:          Finds the first block of the set that has never been
+                  filled, reading the valid bitmap a word at a time
+Input parameters: none
+Return value:     int - index of the first invalid block, or -1 if the set
+                        is full
+******************************************************************************/
+		int findInvalidBlock() {
+			// A set of fewer than 64 blocks lies within one bitmap word, since the associativity
+			// is a power of two, and larger sets start on a word boundary
+			for(int offset = 0; offset < associativity; offset += 64) {
+				size_t bit = firstBlock + offset;
+				int count = min(associativity - offset,64);
+				uint64_t invalid = ~(validBits[bit >> 6] >> (bit & 63));
+				if(count < 64) invalid &= ((uint64_t)1 << count) - 1;
+				if(invalid != 0) return offset + __builtin_ctzll(invalid);
+			}
+			return -1;
+		}
+
+/*****************************************************************************
+Function name:    getStateBit
+Purpose:          Reads one of the set's tree or MRU bits
+Input parameters: bit - int - the number of the bit
+Return value:     int - the bit's value, 0 or 1
+******************************************************************************/
+		int getStateBit(int bit) {
+			return (setStates[bit >> 6] >> (bit & 63)) & 1;
+		}
+
+/*****************************************************************************
+Function name:    setStateBit
+Purpose:          Sets or clears one of the set's tree or MRU bits
+Input parameters: bit - int - the number of the bit
+                  value - bool - true to set the bit, false to clear it
+Return value:     none
+******************************************************************************/
+		void setStateBit(int bit, bool value) {
+			// Written without a branch, since tree bits are set and cleared unpredictably
+			uint64_t mask = (uint64_t)1 << (bit & 63);
+			setStates[bit >> 6] = (setStates[bit >> 6] & ~mask) | (mask & -(uint64_t)value);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    moveToBack
+Purpose:          Moves a block to the back of the priority list, making it
+                  the last block to be replaced
+Input parameters: cacheBlockID - int - index of the block to move
+Return value:     none
+******************************************************************************/
+		void moveToBack(int cacheBlockID) {
+			int& lowestPriority = priorityEnds[0];
+			int& highestPriority = priorityEnds[1];
+			if(cacheBlockID == highestPriority) return;	// Already at the back
+			// Unlink the block from its current position (it has a next block since it isn't last)
+			int previous = previousBlock[cacheBlockID];
+			int next = nextBlock[cacheBlockID];
+			if(previous == -1) lowestPriority = next;
+			else nextBlock[previous] = next;
+			previousBlock[next] = previous;
+			// Link the block back in after the current highest priority block
+			previousBlock[cacheBlockID] = highestPriority;
+			nextBlock[cacheBlockID] = -1;
+			nextBlock[highestPriority] = cacheBlockID;
+			highestPriority = cacheBlockID;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    moveToFront
+Purpose:          Moves a block to the front of the priority list, making it
+                  the next block to be replaced
+Input parameters: cacheBlockID - int - index of the block to move
+Return value:     none
+******************************************************************************/
+		void moveToFront(int cacheBlockID) {
+			int& lowestPriority = priorityEnds[0];
+			int& highestPriority = priorityEnds[1];
+			if(cacheBlockID == lowestPriority) return;	// Already at the front
+			// Unlink the block from its current position (it has a previous block since it isn't first)
+			int previous = previousBlock[cacheBlockID];
+			int next = nextBlock[cacheBlockID];
+			if(next == -1) highestPriority = previous;
+			else previousBlock[next] = previous;
+			nextBlock[previous] = next;
+			// Link the block back in before the current lowest priority block
+			nextBlock[cacheBlockID] = lowestPriority;
+			previousBlock[cacheBlockID] = -1;
+			previousBlock[lowestPriority] = cacheBlockID;
+			lowestPriority = cacheBlockID;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    restoreHeap
+Purpose:          Moves a block whose next use has changed up or down the
+                  set's heap until every block's next use is at least as far
+                  away as its children's, taking O(log associativity) steps
+Input parameters: position - int - the block's index in the heap
+Return value:     none
+******************************************************************************/
+		void restoreHeap(int position) {
+			int block = heapBlocks[position];
+			int64_t key = nextUses[block];
+			while(position > 0) {					// Sift up past parents used sooner
+				int parent = (position - 1)/2;
+				if(nextUses[heapBlocks[parent]] >= key) break;
+				placeInHeap(heapBlocks[parent],position);
+				position = parent;
+			}
+			while(true) {							// Sift down past children used later
+				int child = 2*position + 1;
+				if(child >= associativity) break;
+				if(child + 1 < associativity && nextUses[heapBlocks[child + 1]] > nextUses[heapBlocks[child]]) child++;
+				if(nextUses[heapBlocks[child]] <= key) break;
+				placeInHeap(heapBlocks[child],position);
+				position = child;
+			}
+			placeInHeap(block,position);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    placeInHeap
+Purpose:          Stores a block at an index of the set's heap
+Input parameters: cacheBlockID - int - index of the block within the set
+                  position - int - the block's new index in the heap
+Return value:     none
+******************************************************************************/
+		void placeInHeap(int cacheBlockID, int position) {
+			heapBlocks[position] = cacheBlockID;
+			heapPositions[cacheBlockID] = position;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getBit
+Purpose:          Reads the bit of one of the set's blocks from a bitmap
+Input parameters: bitmap - uint64_t* - the cache-wide bitmap to read
+                  cacheBlockID - int - index of the block within the set
+Return value:     int - the bit's value, 0 or 1
+******************************************************************************/
+		int getBit(uint64_t* bitmap, int cacheBlockID) {
+			size_t bit = firstBlock + cacheBlockID;
+			return (bitmap[bit >> 6] >> (bit & 63)) & 1;
+		}
+
+/*****************************************************************************
+Function name:    setBit
+Purpose:          Sets or clears the bit of one of the set's blocks in a bitmap
+Input parameters: bitmap - uint64_t* - the cache-wide bitmap to update
+                  cacheBlockID - int - index of the block within the set
+                  value - bool - true to set the bit, false to clear it
+Return value:     none
+******************************************************************************/
+		void setBit(uint64_t* bitmap, int cacheBlockID, bool value) {
+			size_t bit = firstBlock + cacheBlockID;
+			if(value) bitmap[bit >> 6] |= (uint64_t)1 << (bit & 63);
+			else bitmap[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+			return;
+		}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<LRU>
+Purpose:          Least recently used replacement. Every access moves the
+                  block to the back of the set's priority list, and the
+                  block at the front is replaced. Each policy provides hit,
+                  victim and fill, which CacheSet::updatePriority calls on
+                  the set's metadata, so the policy is chosen at compile time
+******************************************************************************/
+template<>
+struct Replacement<LRU> {
+	static void hit(CacheSet& set, int cacheBlockID, int64_t) { set.moveToBack(cacheBlockID); }
+	static int victim(CacheSet& set) { return set.priorityEnds[0]; }
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) { set.moveToBack(cacheBlockID); }
+};
+
+/*****************************************************************************
+Struct name:      Replacement<FIFO>
+Purpose:          First in first out replacement. Priorities only change when
+                  a block is filled, so hits leave the priority list alone
+******************************************************************************/
+template<>
+struct Replacement<FIFO> {
+	static void hit(CacheSet&, int, int64_t) {}
+	static int victim(CacheSet& set) { return set.priorityEnds[0]; }
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) { set.moveToBack(cacheBlockID); }
+};
+
+/*****************************************************************************
+Struct name:      Replacement<OPT>
+Purpose:          Belady's optimal replacement. The block whose next use is
+                  furthest in the future, the top of the set's heap, is
+                  replaced
+******************************************************************************/
+template<>
+struct Replacement<OPT> {
+	static void hit(CacheSet& set, int cacheBlockID, int64_t nextUse) { fill(set,cacheBlockID,nextUse); }
+	static int victim(CacheSet& set) { return set.heapBlocks[0]; }
+	static void fill(CacheSet& set, int cacheBlockID, int64_t nextUse) {
+		set.nextUses[cacheBlockID] = nextUse;
+		set.restoreHeap(set.heapPositions[cacheBlockID]);
+	}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<TREE_PLRU>
+Purpose:          Tree pseudo-LRU replacement. The set's state bits form a
+                  binary tree over its blocks (node 1 is the root, node n has
+                  children 2n and 2n+1, and the blocks are the leaves), each
+                  bit pointing to the half holding the next block to replace.
+                  An access points every node on the block's path away from
+                  it. Empty blocks are filled first, as in hardware
+******************************************************************************/
+template<>
+struct Replacement<TREE_PLRU> {
+	static void hit(CacheSet& set, int cacheBlockID, int64_t nextUse) { fill(set,cacheBlockID,nextUse); }
+	static int victim(CacheSet& set) {
+		int invalid = set.findInvalidBlock();
+		if(invalid != -1) return invalid;
+		int node = 1;								// Follow the bits down from the root
+		while(node < set.associativity) node = 2*node + set.getStateBit(node);
+		return node - set.associativity;
+	}
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) {
+		// A left child (even node) makes its parent point right, and a right child left
+		for(int node = cacheBlockID + set.associativity; node > 1; node >>= 1) {
+			set.setStateBit(node >> 1,(node & 1) == 0);
+		}
+	}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<BIT_PLRU>
+Purpose:          Bit pseudo-LRU (MRU bit) replacement. An access sets the
+                  block's bit, clearing every other bit once all are set,
+                  and the first block with a clear bit is replaced
+******************************************************************************/
+template<>
+struct Replacement<BIT_PLRU> {
+	static void hit(CacheSet& set, int cacheBlockID, int64_t nextUse) { fill(set,cacheBlockID,nextUse); }
+	static int victim(CacheSet& set) {
+		int invalid = set.findInvalidBlock();
+		if(invalid != -1) return invalid;
+		for(int offset = 0; offset < set.associativity; offset += 64) {
+			uint64_t clear = ~set.setStates[offset >> 6];
+			if(set.associativity - offset < 64) clear &= ((uint64_t)1 << (set.associativity - offset)) - 1;
+			if(clear != 0) return offset + __builtin_ctzll(clear);
+		}
+		return 0;									// Only reached by direct mapped sets
+	}
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) {
+		set.setStateBit(cacheBlockID,true);
+		for(int offset = 0; offset < set.associativity; offset += 64) {
+			uint64_t full = (set.associativity - offset < 64)
+							? ((uint64_t)1 << (set.associativity - offset)) - 1 : ~(uint64_t)0;
+			if((set.setStates[offset >> 6] & full) != full) return;
+		}
+		// Every bit is set, so start a new round with only the accessed block marked
+		memset(set.setStates,0,((set.associativity + 63)/64)*sizeof(uint64_t));
+		set.setStateBit(cacheBlockID,true);
+	}
+};
+
+/*****************************************************************************
+Struct name:      ReReferenceInterval
+Purpose:          The parts shared by the RRIP policies. Each block's state
+                  byte holds a 2-bit re-reference prediction value (RRPV): 0
+                  on a hit, and the block with the highest value is replaced,
+                  aging every block of the set until one reaches the maximum
+******************************************************************************/
+struct ReReferenceInterval {
+	static const uint8_t RRPV_MAX = 3;				// Predicted to be re-referenced in the distant future
+	static const uint8_t RRPV_LONG = 2;				// Predicted to be re-referenced in a long while
+	static void hit(CacheSet& set, int cacheBlockID, int64_t) { set.blockStates[cacheBlockID] = 0; }
+	static int victim(CacheSet& set) {
+		int invalid = set.findInvalidBlock();
+		if(invalid != -1) return invalid;
+		int victim = 0;								// The first block with the highest RRPV
+		uint8_t oldest = set.blockStates[0];
+		for(int i = 1; i < set.associativity; i++) {	// Kept branch free, as the RRPVs are unpredictable
+			bool older = set.blockStates[i] > oldest;
+			victim = older ? i : victim;
+			oldest = older ? set.blockStates[i] : oldest;
+		}
+		// Age the set until the victim's RRPV reaches the maximum
+		if(oldest < RRPV_MAX) {
+			for(int i = 0; i < set.associativity; i++) set.blockStates[i] += RRPV_MAX - oldest;
+		}
+		return victim;
+	}
+	// BRRIP inserts most blocks at the distant RRPV and 1 in 32 at the long RRPV
+	static uint8_t bimodalInsertion(CacheSet& set) {
+		if((set.storage->nextRandom() & 31) == 0) return RRPV_LONG;
+		return RRPV_MAX;
+	}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<SRRIP>
+Purpose:          Static RRIP (hit priority) replacement, inserting every
+                  block at the long re-reference interval
+******************************************************************************/
+template<>
+struct Replacement<SRRIP> : ReReferenceInterval {
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) { set.blockStates[cacheBlockID] = RRPV_LONG; }
+};
+
+/*****************************************************************************
+Struct name:      Replacement<BRRIP>
+Purpose:          Bimodal RRIP replacement, which resists thrashing by
+                  inserting most blocks at the distant re-reference interval
+******************************************************************************/
+template<>
+struct Replacement<BRRIP> : ReReferenceInterval {
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) {
+		set.blockStates[cacheBlockID] = bimodalInsertion(set);
+	}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<DRRIP>
+Purpose:          Dynamic RRIP replacement using set dueling. Of every group
+                  of sets (32 groups, or groups of 2 in small caches), the
+                  first always inserts like SRRIP and the second like BRRIP,
+                  and their misses move the cache's policy selector. The
+                  other sets insert like whichever leader misses less
+******************************************************************************/
+template<>
+struct Replacement<DRRIP> : ReReferenceInterval {
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) {
+		int& selector = set.storage->policySelector;
+		// The number of sets is a power of two, so the group size is too
+		int leader = set.setNumber & (max(set.storage->cacheSets >> 5,2) - 1);
+		bool bimodal;								// Whether to insert like BRRIP
+		if(leader == 0) {							// SRRIP leader missed
+			bimodal = false;
+			if(selector < CacheStorage::POLICY_SELECTOR_MAX) selector++;
+		}
+		else if(leader == 1) {						// BRRIP leader missed
+			bimodal = true;
+			if(selector > 0) selector--;
+		}
+		else bimodal = selector > CacheStorage::POLICY_SELECTOR_MAX/2;
+		set.blockStates[cacheBlockID] = bimodal ? bimodalInsertion(set) : RRPV_LONG;
+	}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<RANDOM>
+Purpose:          Random replacement from the cache's seeded generator, so a
+                  run can be repeated exactly
+******************************************************************************/
+template<>
+struct Replacement<RANDOM> {
+	static void hit(CacheSet&, int, int64_t) {}
+	static int victim(CacheSet& set) {
+		int invalid = set.findInvalidBlock();
+		if(invalid != -1) return invalid;
+		return (int)(set.storage->nextRandom() & (set.associativity - 1));
+	}
+	static void fill(CacheSet&, int, int64_t) {}
+};
+
+/*****************************************************************************
+Struct name:      Replacement<LFU>
+Purpose:          Least frequently used replacement. Each block's state byte
+                  counts its accesses since it was filled, and the first block
+                  with the lowest count is replaced. A count reaching 255
+                  halves every count in the set, so old popularity fades
+******************************************************************************/
+template<>
+struct Replacement<LFU> {
+	static void hit(CacheSet& set, int cacheBlockID, int64_t) {
+		if(set.blockStates[cacheBlockID] == UINT8_MAX) {
+			for(int i = 0; i < set.associativity; i++) set.blockStates[i] >>= 1;
+		}
+		set.blockStates[cacheBlockID]++;
+	}
+	static int victim(CacheSet& set) {
+		int invalid = set.findInvalidBlock();
+		if(invalid != -1) return invalid;
+		int victim = 0;								// The first block with the lowest count
+		uint8_t fewest = set.blockStates[0];
+		for(int i = 1; i < set.associativity; i++) {	// Kept branch free, as the counts are unpredictable
+			bool fewer = set.blockStates[i] < fewest;
+			victim = fewer ? i : victim;
+			fewest = fewer ? set.blockStates[i] : fewest;
+		}
+		return victim;
+	}
+	static void fill(CacheSet& set, int cacheBlockID, int64_t) { set.blockStates[cacheBlockID] = 1; }
+};
+
+/*****************************************************************************
+Struct name:      FixedGeometry
+Purpose:          Describes a cache geometry known at compile time, so that
+                  splitting an address into block number, set and tag takes
+                  constant shifts and masks
+Template params:  OFFSET_BITS - int - the number of block offset bits
+                  INDEX_BITS - int - the number of set index bits
+                  ASSOC - int - the number of cache blocks per set
+******************************************************************************/
+template<int OFFSET_BITS, int INDEX_BITS, int ASSOC>
+struct FixedGeometry {
+	static const int ASSOCIATIVITY = ASSOC;			// Fixed associativity for the set's tag search
+	int64_t blockNumber(int64_t memoryAddress) const { return memoryAddress >> OFFSET_BITS; }
+	int setNumber(int64_t memoryBlockNumber) const { return memoryBlockNumber & ((1 << INDEX_BITS) - 1); }
+	int64_t tag(int64_t memoryBlockNumber) const { return memoryBlockNumber >> INDEX_BITS; }
+	int64_t memoryBlock(int64_t tag, int setNumber) const { return (tag << INDEX_BITS) | setNumber; }
+	// Whether this geometry describes a cache with the given field sizes and associativity
+	static bool matches(int offsetBits, int indexBits, int associativity) {
+		return offsetBits == OFFSET_BITS && indexBits == INDEX_BITS && associativity == ASSOC;
+	}
+};
+
+/*****************************************************************************
+Struct name:      RuntimeGeometry
+Purpose:          Describes any other cache geometry, splitting addresses with
+                  shifts and masks computed when the simulator is created
+******************************************************************************/
+struct RuntimeGeometry {
+	static const int ASSOCIATIVITY = 0;				// Associativity is only known at run time
+	int offsetBits;									// The number of block offset bits
+	int indexBits;									// The number of set index bits
+	int indexMask;									// Mask selecting the set index bits
+	RuntimeGeometry(int offsetBits, int indexBits)
+		: offsetBits(offsetBits), indexBits(indexBits), indexMask((1 << indexBits) - 1) {}
+	int64_t blockNumber(int64_t memoryAddress) const { return memoryAddress >> offsetBits; }
+	int setNumber(int64_t memoryBlockNumber) const { return memoryBlockNumber & indexMask; }
+	int64_t tag(int64_t memoryBlockNumber) const { return memoryBlockNumber >> indexBits; }
+	int64_t memoryBlock(int64_t tag, int setNumber) const { return (tag << indexBits) | setNumber; }
+};
+
+/*****************************************************************************
+Struct name:      XorGeometry
+Purpose:          Describes a cache indexed by the XOR of the low block number
+                  bits and the tag bits above them, which spreads power of two
+                  strides over every set. The tag is unchanged, so the block
+                  number is still found from the tag and set
+******************************************************************************/
+struct XorGeometry {
+	static const int ASSOCIATIVITY = 0;				// Associativity is only known at run time
+	int offsetBits;									// The number of block offset bits
+	int indexBits;									// The number of set index bits
+	int indexMask;									// Mask selecting the set index bits
+	XorGeometry(int offsetBits, int indexBits)
+		: offsetBits(offsetBits), indexBits(indexBits), indexMask((1 << indexBits) - 1) {}
+	int64_t blockNumber(int64_t memoryAddress) const { return memoryAddress >> offsetBits; }
+	int setNumber(int64_t memoryBlockNumber) const {
+		return (memoryBlockNumber ^ (memoryBlockNumber >> indexBits)) & indexMask;
+	}
+	int64_t tag(int64_t memoryBlockNumber) const { return memoryBlockNumber >> indexBits; }
+	int64_t memoryBlock(int64_t tag, int setNumber) const {
+		return (tag << indexBits) | ((setNumber ^ tag) & indexMask);
+	}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       ReferenceQueue
+Purpose:          A bounded queue of batches of memory references passed from
+                  the thread reading a trace to one simulation worker
+******************************************************************************/
+class ReferenceQueue {
+	public:
+/*****************************************************************************
+Function name:    ReferenceQueue (constructor)
+Purpose:          Creates an empty, open queue
+Input parameters: capacity - int - the most batches the queue will hold
+                                   before the producer waits
+Return value:     none
+******************************************************************************/
+		ReferenceQueue(int capacity) {
+			this->capacity = capacity;
+			closed = false;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    push
+Purpose:          Adds a batch to the queue, waiting while the queue is full
+Input parameters: batch - vector<MemoryReference>& - the batch to add, which
+                                                     is left empty
+Return value:     none
+******************************************************************************/
+		void push(vector<MemoryReference>& batch) {
+			unique_lock<mutex> lock(queueLock);
+			notFull.wait(lock,[this]() { return (int)batches.size() < capacity; });
+			batches.push_back(vector<MemoryReference>());
+			batches.back().swap(batch);				// Hand over the batch without copying it
+			notEmpty.notify_one();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    pop
+Purpose:          Takes the oldest batch from the queue, waiting while the
+                  queue is empty and still open
+Input parameters: batch - vector<MemoryReference>& - set to the batch taken
+Return value:     bool - true if a batch was taken, false if the queue is
+                         closed and empty
+******************************************************************************/
+		bool pop(vector<MemoryReference>& batch) {
+			unique_lock<mutex> lock(queueLock);
+			notEmpty.wait(lock,[this]() { return !batches.empty() || closed; });
+			if(batches.empty()) return false;
+			batch.swap(batches.front());
+			batches.pop_front();
+			notFull.notify_one();
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    close
+Purpose:          Marks that no more batches will be added
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void close() {
+			lock_guard<mutex> lock(queueLock);
+			closed = true;
+			notEmpty.notify_all();
+			return;
+		}
+	private:
+		int capacity;								// The most batches held at once
+		bool closed;								// Whether the producer has finished
+		deque< vector<MemoryReference> > batches;	// The batches waiting to be simulated
+		mutex queueLock;							// Guards every member above
+		condition_variable notFull;					// Signalled when a batch is taken
+		condition_variable notEmpty;				// Signalled when a batch is added or on close
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       BlockCounter
+Purpose:          Counts the distinct memory blocks referenced by a trace with
+                  an open addressing hash set, so the memory used depends on
+                  the trace's footprint rather than the size of main memory
+******************************************************************************/
+class BlockCounter {
+	public:
+/*****************************************************************************
+Function name:    BlockCounter (constructor)
+Purpose:          Creates an empty block counter
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		BlockCounter() : slots(1024,EMPTY_SLOT), distinctBlocks(0) {}
+
+/*****************************************************************************
+Function name:    add
+Purpose:          Records a reference to a memory block
+Input parameters: memoryBlockNumber - int64_t - the block referenced
+Return value:     none
+******************************************************************************/
+		void add(int64_t memoryBlockNumber) {
+			size_t mask = slots.size() - 1;
+			size_t slot = hash(memoryBlockNumber) & mask;
+			while(slots[slot] != EMPTY_SLOT) {		// Probe until the block or a free slot is found
+				if(slots[slot] == memoryBlockNumber) return;
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = memoryBlockNumber;
+			// Keep the table at most half full so probe sequences stay short
+			if(++distinctBlocks*2 > (int64_t)slots.size()) grow();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getDistinctBlocks
+Purpose:          Gets the number of distinct memory blocks recorded
+Input parameters: none
+Return value:     int64_t - the number of distinct memory blocks
+******************************************************************************/
+		int64_t getDistinctBlocks() const {
+			return distinctBlocks;
+		}
+
+/*****************************************************************************
+Function name:    save
+Purpose:          Writes the hash table to a checkpoint
+Input parameters: output - ostream& - the checkpoint being written
+Return value:     none
+******************************************************************************/
+		void save(ostream& output) const {
+			int64_t numSlots = slots.size();
+			output.write((const char*)&numSlots,sizeof(numSlots));
+			output.write((const char*)&distinctBlocks,sizeof(distinctBlocks));
+			output.write((const char*)slots.data(),numSlots*sizeof(int64_t));
+			return;
+		}
+
+/*****************************************************************************
+Function name:    load
+Purpose:          Reads the hash table back from a checkpoint
+Input parameters: input - istream& - the checkpoint being read
+Return value:     bool - true if a valid table was read, false if not
+******************************************************************************/
+		bool load(istream& input) {
+			int64_t numSlots;
+			int64_t blocks;
+			input.read((char*)&numSlots,sizeof(numSlots));
+			input.read((char*)&blocks,sizeof(blocks));
+			// The table is a power of two in size, at most half full
+			if(!input || numSlots < 1 || numSlots > ((int64_t)1 << 40) || (numSlots & (numSlots - 1)) != 0
+			   || blocks < 0 || blocks*2 > numSlots) return false;
+			slots.resize(numSlots);
+			input.read((char*)slots.data(),numSlots*sizeof(int64_t));
+			distinctBlocks = blocks;
+			return (bool)input;
+		}
+
+/*****************************************************************************
+Function name:    hash
+Purpose:          Mixes the bits of a block number, since consecutive blocks
+                  would otherwise fill runs of adjacent slots
+Input parameters: memoryBlockNumber - int64_t - the block to hash
+Return value:     size_t - the hash of the block number
+******************************************************************************/
+		static size_t hash(int64_t memoryBlockNumber) {
+			uint64_t value = (uint64_t)memoryBlockNumber * 0x9E3779B97F4A7C15ULL;
+			return (size_t)(value ^ (value >> 29));
+		}
+	private:
+		static const int64_t EMPTY_SLOT = -1;		// Block numbers are never negative
+		vector<int64_t> slots;						// The hash table, a power of two in size
+		int64_t distinctBlocks;						// The number of occupied slots
+
+/*****************************************************************************
+Function name:    grow
+Purpose:          Doubles the size of the hash table, reinserting every block
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void grow() {
+			vector<int64_t> oldSlots(slots.size()*2,EMPTY_SLOT);
+			oldSlots.swap(slots);
+			size_t mask = slots.size() - 1;
+			for(size_t i = 0; i < oldSlots.size(); i++) {
+				if(oldSlots[i] == EMPTY_SLOT) continue;
+				size_t slot = hash(oldSlots[i]) & mask;
+				while(slots[slot] != EMPTY_SLOT) slot = (slot + 1) & mask;
+				slots[slot] = oldSlots[i];
+			}
+			return;
+		}
+};
+const int64_t BlockCounter::EMPTY_SLOT;			// Defined for the vector constructor's reference
+
+/*****************************************************************************
+Function name:    samplingHash
+Purpose:          Hashes a block or set number for sampling, so that the
+                  numbers sampled are spread evenly whatever their pattern
+Input parameters: number - int64_t - the block or set number
+Return value:     uint64_t - the hash, SAMPLE_HASH_BITS bits wide
+******************************************************************************/
+uint64_t samplingHash(int64_t number) {
+	// The splitmix64 finalizer: unlike a multiplicative hash, it does not map 0 (often the
+	// busiest block or set) to 0, which would put it in every sample
+	uint64_t value = (uint64_t)number + 0x9E3779B97F4A7C15ULL;
+	value = (value ^ (value >> 30))*0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27))*0x94D049BB133111EBULL;
+	return (value ^ (value >> 31)) >> (64 - SAMPLE_HASH_BITS);
+}
+
+/*****************************************************************************
+Function name:    sampleError
+Purpose:          Estimates the half-width of the 95% confidence interval of
+                  a count scaled up from a random sample of groups (such as
+                  the misses of sampled sets), relative to a total
+Input parameters: sampleCounts - const vector<int64_t>& - the count in each
+                                                          sampled group
+                  populationGroups - double - the groups in the whole
+                                              population
+                  total - double - the total the error is relative to
+Return value:     double - the half-width, as a percentage of the total
+******************************************************************************/
+double sampleError(const vector<int64_t>& sampleCounts, double populationGroups, double total) {
+	double samples = sampleCounts.size();
+	if(samples < 2 || total <= 0) return 0;		// No spread to measure
+	double mean = 0;
+	for(unsigned int i = 0; i < sampleCounts.size(); i++) mean += sampleCounts[i];
+	mean /= samples;
+	double squares = 0;
+	for(unsigned int i = 0; i < sampleCounts.size(); i++) squares += (sampleCounts[i] - mean)*(sampleCounts[i] - mean);
+	// Variance of the scaled up count, with the correction for sampling without replacement
+	double variance = populationGroups*populationGroups*max(1 - samples/populationGroups,0.0)
+					  *squares/(samples - 1)/samples;
+	return CONFIDENCE_Z*sqrt(variance)/total*100;
+}
+
+/*****************************************************************************
+******************************************************************************
+Class name:       Prefetcher
+Purpose:          Models a hardware prefetcher, which watches the demand
+                  accesses to a cache and predicts the memory blocks needed
+                  next. It only predicts blocks: the simulator skips those
+                  already cached and fills the rest. Traces carry no program
+                  counters, so the stride prefetcher learns one stride per
+                  region of memory rather than one per instruction
+******************************************************************************/
+class Prefetcher {
+	public:
+		PrefetcherType type;						// The prefetcher modelled
+		int degree;									// The blocks requested by one prediction
+		int distance;								// How many blocks (or strides) ahead of the
+													// access the first requested block is
+
+/*****************************************************************************
+Function name:    Prefetcher (constructor)
+Purpose:          Creates a prefetcher that never requests anything
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		Prefetcher() : type(NO_PREFETCHER), degree(1), distance(1), regionShift(0), streamClock(0) {}
+
+/*****************************************************************************
+Function name:    configure
+Purpose:          Chooses the prefetcher and how far ahead and how much it
+                  prefetches, forgetting anything it has learned
+Input parameters: type - PrefetcherType - the prefetcher to model
+                  degree - int - the blocks requested by one prediction
+                  distance - int - how far ahead the first requested block is
+                  offsetBits - int - the number of block offset bits, used to
+                                     find the region of a block
+Return value:     none
+******************************************************************************/
+		void configure(PrefetcherType type, int degree, int distance, int offsetBits) {
+			this->type = type;
+			this->degree = min(max(degree,1),MAX_PREFETCH_DEGREE);
+			this->distance = max(distance,1);
+			regionShift = max(REGION_BITS - offsetBits,0);
+			strides.assign(STRIDE_ENTRIES,StrideEntry());
+			streams.assign(STREAM_ENTRIES,StreamEntry());
+			streamClock = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    predict
+Purpose:          Trains the prefetcher on a demand access and predicts the
+                  blocks to prefetch. The next-line and stream prefetchers
+                  are triggered by misses and by the first use of a
+                  prefetched block, the stride prefetcher by every access
+Input parameters: memoryBlockNumber - int64_t - the block accessed
+                  status - HitMiss - whether the access hit or missed
+                  prefetchHit - bool - whether the access was the first use
+                                       of a prefetched block
+                  candidates - int64_t* - set to the predicted blocks, with
+                                          room for MAX_PREFETCH_DEGREE
+Return value:     int - the number of blocks predicted
+******************************************************************************/
+		int predict(int64_t memoryBlockNumber, HitMiss status, bool prefetchHit, int64_t* candidates) {
+			bool triggered = (status == MISS || prefetchHit);
+			int64_t stride = 0;						// Blocks between the predictions, 0 for none
+			switch(type) {
+				case NEXT_LINE: if(triggered) stride = 1; break;
+				case STRIDE: stride = trainStride(memoryBlockNumber); break;
+				case STREAM: if(triggered) stride = trainStream(memoryBlockNumber,status == MISS); break;
+				default: break;
+			}
+			if(stride == 0) return 0;
+			for(int i = 0; i < degree; i++) candidates[i] = memoryBlockNumber + stride*(distance + i);
+			return degree;
+		}
+	private:
+		static const int REGION_BITS = 12;			// Strides are learned per 4 KB region
+		static const int STRIDE_ENTRIES = 256;		// Regions tracked, a power of two
+		static const int STRIDE_CONFIDENCE_MAX = 3;	// Saturating 2-bit confidence counters
+		static const int STREAM_ENTRIES = 16;		// Streams tracked at once
+		static const int STREAM_WINDOW = 16;		// Blocks an access may be from a stream's last
+													// block and still belong to the stream
+		// The last block and stride seen in one region, and how often the stride repeated
+		struct StrideEntry {
+			int64_t region = -1;
+			int64_t lastBlock = 0;
+			int64_t stride = 0;
+			int confidence = 0;
+		};
+		// The last block of one sequential stream, its direction (1 or -1) once it has moved,
+		// whether it moved the same way twice in a row, and when it was last used
+		struct StreamEntry {
+			int64_t lastBlock = 0;
+			int direction = 0;
+			bool confirmed = false;
+			int64_t lastUse = 0;
+		};
+		int regionShift;							// Shift from a block number to its region
+		vector<StrideEntry> strides;				// Stride table, indexed by region
+		vector<StreamEntry> streams;				// Stream table, replaced least recently used
+		int64_t streamClock;						// Counts stream table updates, for its LRU order
+
+/*****************************************************************************
+Function name:    trainStride
+Purpose:          Updates the stride of the accessed block's region, raising
+                  its confidence when the stride repeats and replacing it
+                  once the confidence has run out
+Input parameters: memoryBlockNumber - int64_t - the block accessed
+Return value:     int64_t - the region's stride if it is trusted, or 0
+******************************************************************************/
+		int64_t trainStride(int64_t memoryBlockNumber) {
+			int64_t region = memoryBlockNumber >> regionShift;
+			StrideEntry& entry = strides[region & (STRIDE_ENTRIES - 1)];
+			if(entry.region != region) {			// First access to the region (or a conflict)
+				entry = StrideEntry();
+				entry.region = region;
+				entry.lastBlock = memoryBlockNumber;
+				return 0;
+			}
+			int64_t delta = memoryBlockNumber - entry.lastBlock;
+			if(delta == 0) return 0;				// Accesses within one block say nothing
+			if(delta == entry.stride) entry.confidence = min(entry.confidence + 1,STRIDE_CONFIDENCE_MAX);
+			else if(entry.confidence > 0) entry.confidence--;
+			else entry.stride = delta;
+			entry.lastBlock = memoryBlockNumber;
+			// The stride is trusted once it has been seen twice in a row
+			return (entry.confidence > 0) ? entry.stride : 0;
+		}
+
+/*****************************************************************************
+Function name:    trainStream
+Purpose:          Moves the stream near the accessed block on to it, or on a
+                  miss starts a new stream in place of the least recently
+                  used one
+Input parameters: memoryBlockNumber - int64_t - the block accessed
+                  miss - bool - whether the access missed
+Return value:     int64_t - the stream's direction once it has moved the same
+                            way twice in a row, or 0
+******************************************************************************/
+		int64_t trainStream(int64_t memoryBlockNumber, bool miss) {
+			int oldest = 0;							// The least recently used stream
+			streamClock++;
+			for(int i = 0; i < STREAM_ENTRIES; i++) {
+				StreamEntry& stream = streams[i];
+				int64_t delta = memoryBlockNumber - stream.lastBlock;
+				if(stream.lastUse != 0 && delta >= -STREAM_WINDOW && delta <= STREAM_WINDOW) {
+					stream.lastUse = streamClock;
+					if(delta == 0) return 0;
+					int direction = (delta > 0) ? 1 : -1;
+					stream.confirmed = (direction == stream.direction);
+					stream.direction = direction;
+					stream.lastBlock = memoryBlockNumber;
+					return stream.confirmed ? direction : 0;
+				}
+				if(stream.lastUse < streams[oldest].lastUse) oldest = i;
+			}
+			if(miss) {
+				streams[oldest] = StreamEntry();
+				streams[oldest].lastBlock = memoryBlockNumber;
+				streams[oldest].lastUse = streamClock;
+			}
+			return 0;
+		}
+};
+
+/*****************************************************************************
+Struct name:      SimulationStatistics
+Purpose:          Stores the results of simulating a trace
+******************************************************************************/
+struct SimulationStatistics {
+	int64_t references = 0;							// The number of memory references simulated
+	int64_t hits = 0;								// The number of cache hits
+	int64_t compulsoryBoundHits = 0;				// References after each block's first, the hits
+													// if only compulsory misses occurred (a loose
+													// bound, OPT gives the best achievable)
+	int64_t blocksRead = 0;							// Blocks filled from main memory
+	int64_t dirtyEvictions = 0;						// Dirty blocks written back to main memory
+	int64_t wordsWritten = 0;						// Writes sent to main memory without a block
+	int64_t prefetches = 0;							// Blocks filled from main memory by prefetches
+	int64_t usefulPrefetches = 0;					// Prefetched blocks later used by a demand access
+	int64_t latePrefetches = 0;						// Useful prefetches still arriving when used
+	int64_t unusedPrefetches = 0;					// Prefetched blocks replaced before any use
+	int64_t pollutionMisses = 0;					// Misses on blocks a prefetch had replaced
+	int64_t prefetchStallCycles = 0;				// Cycles spent waiting for late prefetches
+	int64_t compulsoryMisses = 0;					// Misses on the first reference to a block
+	int64_t capacityMisses = 0;						// Misses a fully associative cache also has
+	int64_t conflictMisses = 0;						// Misses only the cache's mapping causes
+	int64_t victimHits = 0;							// Misses found in the victim cache instead of
+													// being read from memory
+	int64_t sampledReferences = 0;					// References simulated when sampling sets (the
+													// counts above are then scaled up estimates)
+	double hitRateError = 0;						// Half-width of the sampled hit rate's 95%
+													// confidence interval, as a percentage
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       VictimCache
+Purpose:          A small fully associative LRU buffer of the blocks a cache
+                  has just replaced, searched when the cache misses. A block
+                  found there swaps places with the block the cache replaces
+                  for it, so the buffer adds a few ways shared by every set
+                  and only the blocks it pushes out leave the cache
+******************************************************************************/
+class VictimCache {
+	public:
+/*****************************************************************************
+Function name:    VictimCache (constructor)
+Purpose:          Creates an empty victim cache
+Input parameters: entries - int - the number of blocks it holds
+Return value:     none
+******************************************************************************/
+		VictimCache(int entries) : blocks(entries,-1), dirtyBits(entries,0), lastUses(entries,0), clock(0) {}
+
+/*****************************************************************************
+Function name:    getEntries
+Purpose:          Gets the number of blocks the victim cache holds
+Input parameters: none
+Return value:     int - the number of entries
+******************************************************************************/
+		int getEntries() {
+			return (int)blocks.size();
+		}
+
+/*****************************************************************************
+Function name:    remove
+Purpose:          Takes a block out of the victim cache if it is there
+Input parameters: memoryBlockNumber - int64_t - the block to find
+                  dirty - bool& - set to whether the block was dirty
+Return value:     bool - true if the block was found, false if not
+******************************************************************************/
+		bool remove(int64_t memoryBlockNumber, bool& dirty) {
+			for(unsigned int i = 0; i < blocks.size(); i++) {
+				if(blocks[i] != memoryBlockNumber) continue;
+				dirty = dirtyBits[i];
+				blocks[i] = -1;
+				return true;
+			}
+			return false;
+		}
+
+/*****************************************************************************
+Function name:    update
+Purpose:          Finds a block for an access that does not fill the block
+                  into the cache, marking it dirty if the access writes it
+Input parameters: memoryBlockNumber - int64_t - the block accessed
+                  dirty - bool - whether the access leaves the block dirty
+Return value:     bool - true if the block was found, false if not
+******************************************************************************/
+		bool update(int64_t memoryBlockNumber, bool dirty) {
+			for(unsigned int i = 0; i < blocks.size(); i++) {
+				if(blocks[i] != memoryBlockNumber) continue;
+				dirtyBits[i] |= dirty;
+				lastUses[i] = ++clock;
+				return true;
+			}
+			return false;
+		}
+
+/*****************************************************************************
+Function name:    insert
+Purpose:          Adds a block replaced by the cache, pushing out the least
+                  recently added block if the victim cache is full
+Input parameters: memoryBlockNumber - int64_t - the block replaced
+                  dirty - bool - whether the block is dirty
+                  pushedBlockNumber - int64_t& - set to the block pushed out
+                  pushedDirty - bool& - set to whether it was dirty
+Return value:     bool - true if a block was pushed out, false if not
+******************************************************************************/
+		bool insert(int64_t memoryBlockNumber, bool dirty, int64_t& pushedBlockNumber, bool& pushedDirty) {
+			int entry = 0;							// An empty entry, or else the oldest
+			for(unsigned int i = 0; i < blocks.size(); i++) {
+				if(blocks[i] == -1) {
+					entry = i;
+					break;
+				}
+				if(lastUses[i] < lastUses[entry]) entry = i;
+			}
+			bool pushed = (blocks[entry] != -1);
+			pushedBlockNumber = blocks[entry];
+			pushedDirty = pushed && dirtyBits[entry];
+			blocks[entry] = memoryBlockNumber;
+			dirtyBits[entry] = dirty;
+			lastUses[entry] = ++clock;
+			return pushed;
+		}
+	private:
+		vector<int64_t> blocks;						// The block in each entry, or -1 if empty
+		vector<char> dirtyBits;						// Whether each entry's block is dirty
+		vector<uint64_t> lastUses;					// When each entry was last filled or accessed
+		uint64_t clock;								// Counts the fills and accesses
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       ShadowCache
+Purpose:          A fully associative LRU cache of memory block numbers,
+                  used as the reference a set-associative cache is compared
+                  to. The blocks are kept in a doubly linked list in recency
+                  order, found through an open addressing hash table from
+                  block number to list node, so every access takes constant
+                  time
+******************************************************************************/
+class ShadowCache {
+	public:
+/*****************************************************************************
+Function name:    ShadowCache (constructor)
+Purpose:          Creates an empty fully associative cache
+Input parameters: capacity - int - the number of blocks the cache holds
+Return value:     none
+******************************************************************************/
+		ShadowCache(int capacity) : blocks(capacity), previousNode(capacity), nextNode(capacity) {
+			this->capacity = capacity;
+			// Every miss erases a block and inserts another, so keep the table at most a quarter
+			// full (a power of two in size) to keep the clusters they probe through short
+			size_t tableSize = 16;
+			while(tableSize < (size_t)capacity*4) tableSize *= 2;
+			slotBlocks.assign(tableSize,EMPTY_SLOT);
+			slotNodes.assign(tableSize,-1);
+			size = 0;
+			mostRecent = leastRecent = -1;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          References a block, making it the most recently used and
+                  replacing the least recently used block on a miss
+Input parameters: memoryBlockNumber - int64_t - the block referenced
+Return value:     HitMiss - whether the block was in the cache
+******************************************************************************/
+		HitMiss access(int64_t memoryBlockNumber) {
+			size_t slot = findSlot(memoryBlockNumber);
+			if(slotBlocks[slot] == memoryBlockNumber) {
+				int node = slotNodes[slot];
+				if(node != mostRecent) {
+					unlink(node);
+					pushFront(node);
+				}
+				return HIT;
+			}
+			int node;
+			if(size < capacity) node = size++;		// Fill the next empty node
+			else {									// Replace the least recently used block
+				node = leastRecent;
+				unlink(node);
+				erase(blocks[node]);
+				slot = findSlot(memoryBlockNumber);	// Erasing may have moved the free slot
+			}
+			blocks[node] = memoryBlockNumber;
+			slotBlocks[slot] = memoryBlockNumber;
+			slotNodes[slot] = node;
+			pushFront(node);
+			return MISS;
+		}
+	private:
+		static const int64_t EMPTY_SLOT = -1;		// Block numbers are never negative
+		int capacity;								// The number of blocks the cache holds
+		int size;									// The number of blocks held so far
+		vector<int64_t> blocks;						// The block held by each list node
+		vector<int> previousNode;					// The next more recently used node, or -1
+		vector<int> nextNode;						// The next less recently used node, or -1
+		int mostRecent;								// Node of the most recently used block
+		int leastRecent;							// Node of the least recently used block
+		vector<int64_t> slotBlocks;					// Hash table of blocks, with linear probing
+		vector<int> slotNodes;						// The list node of each table slot's block
+
+/*****************************************************************************
+Function name:    findSlot
+Purpose:          Finds the table slot holding a block, or the empty slot
+                  where it would be inserted
+Input parameters: memoryBlockNumber - int64_t - the block to find
+Return value:     size_t - the slot
+******************************************************************************/
+		size_t findSlot(int64_t memoryBlockNumber) {
+			size_t mask = slotBlocks.size() - 1;
+			size_t slot = BlockCounter::hash(memoryBlockNumber) & mask;
+			while(slotBlocks[slot] != EMPTY_SLOT && slotBlocks[slot] != memoryBlockNumber) slot = (slot + 1) & mask;
+			return slot;
+		}
+
+/*****************************************************************************
+Function name:    erase
+Purpose:          Removes a block from the hash table, shifting the blocks
+                  probed past its slot back so that none become unreachable
+Input parameters: memoryBlockNumber - int64_t - the block to remove
+Return value:     none
+******************************************************************************/
+		void erase(int64_t memoryBlockNumber) {
+			size_t mask = slotBlocks.size() - 1;
+			size_t hole = findSlot(memoryBlockNumber);
+			for(size_t slot = (hole + 1) & mask; slotBlocks[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+				// A block may fill the hole unless its home slot lies cyclically after the hole
+				size_t home = BlockCounter::hash(slotBlocks[slot]) & mask;
+				if(((slot - home) & mask) >= ((slot - hole) & mask)) {
+					slotBlocks[hole] = slotBlocks[slot];
+					slotNodes[hole] = slotNodes[slot];
+					hole = slot;
+				}
+			}
+			slotBlocks[hole] = EMPTY_SLOT;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    unlink
+Purpose:          Removes a node from the recency list
+Input parameters: node - int - the node to remove
+Return value:     none
+******************************************************************************/
+		void unlink(int node) {
+			if(previousNode[node] == -1) mostRecent = nextNode[node];
+			else nextNode[previousNode[node]] = nextNode[node];
+			if(nextNode[node] == -1) leastRecent = previousNode[node];
+			else previousNode[nextNode[node]] = previousNode[node];
+			return;
+		}
+
+/*****************************************************************************
+Function name:    pushFront
+Purpose:          Makes a node the most recently used
+Input parameters: node - int - the node to move
+Return value:     none
+******************************************************************************/
+		void pushFront(int node) {
+			previousNode[node] = -1;
+			nextNode[node] = mostRecent;
+			if(mostRecent == -1) leastRecent = node;
+			else previousNode[mostRecent] = node;
+			mostRecent = node;
+			return;
+		}
+};
+const int64_t ShadowCache::EMPTY_SLOT;			// Defined for the vector constructor's reference
+
+/*****************************************************************************
+******************************************************************************
+Class name:       MissClassifier
+Purpose:          Sorts every miss of a cache into the three Cs: compulsory
+                  (the first reference to its block), capacity (a fully
+                  associative LRU cache of the same size misses too) and
+                  conflict (only the cache's set mapping causes it), and
+                  counts the misses of every block and set so the hot spots
+                  can be reported
+******************************************************************************/
+class MissClassifier {
+	public:
+/*****************************************************************************
+Function name:    MissClassifier (constructor)
+Purpose:          Creates a classifier for a cache that has missed nothing
+Input parameters: cacheBlocks - int - the number of blocks in the cache
+                  cacheSets - int - the number of sets in the cache
+Return value:     none
+******************************************************************************/
+		MissClassifier(int cacheBlocks, int cacheSets) : shadowCache(cacheBlocks),
+			blockMisses(1024,make_pair(EMPTY_SLOT,(int64_t)0)), numBlocks(0), setMisses(cacheSets,0), setConflictMisses(cacheSets,0) {}
+
+/*****************************************************************************
+Function name:    record
+Purpose:          Runs a reference through the shadow cache and classifies
+                  it if the cache missed
+Input parameters: memoryBlockNumber - int64_t - the block referenced
+                  cacheSetNumber - int - the block's set in the cache
+                  status - HitMiss - whether the cache hit or missed
+                  statistics - SimulationStatistics& - the miss counts to
+                                                       update
+Return value:     none
+******************************************************************************/
+		void record(int64_t memoryBlockNumber, int cacheSetNumber, HitMiss status,
+					SimulationStatistics& statistics) {
+			HitMiss shadowStatus = shadowCache.access(memoryBlockNumber);
+			// Every reference marks its block, hit or miss, since a prefetched block can hit on its
+			// first reference and miss only later, when the miss is not compulsory
+			bool firstReference;
+			int64_t& misses = findBlock(memoryBlockNumber,firstReference);
+			if(status == HIT) return;
+			misses++;
+			if(firstReference) statistics.compulsoryMisses++;
+			else if(shadowStatus == MISS) statistics.capacityMisses++;
+			else {
+				statistics.conflictMisses++;
+				setConflictMisses[cacheSetNumber]++;
+			}
+			setMisses[cacheSetNumber]++;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printClassification
+Purpose:          Prints the three Cs breakdown of the misses, followed by
+                  the blocks and sets with the most misses
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+                  topCount - int - the number of blocks and sets to list
+                  cacheBlockSize - int - the block size, to print addresses
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printClassification(const SimulationStatistics& statistics, int topCount, int cacheBlockSize) {
+			int64_t misses = statistics.references - statistics.hits;
+			float percent = misses ? 100.0f/misses : 0.0f;
+			cout << "Misses = " << misses << ": " << statistics.compulsoryMisses << " compulsory ("
+				 << statistics.compulsoryMisses*percent << "%), " << statistics.capacityMisses << " capacity ("
+				 << statistics.capacityMisses*percent << "%), " << statistics.conflictMisses << " conflict ("
+				 << statistics.conflictMisses*percent << "%)" << endl;
+			// Rank the blocks by misses, most first, ties by block number
+			vector< pair<int64_t,int64_t> > blocks;	// Negated miss count and block number
+			for(size_t slot = 0; slot < blockMisses.size(); slot++) {
+				if(blockMisses[slot].first != EMPTY_SLOT && blockMisses[slot].second != 0) {
+					blocks.push_back(make_pair(-blockMisses[slot].second,blockMisses[slot].first));
+				}
+			}
+			int blockCount = min(topCount,(int)blocks.size());
+			partial_sort(blocks.begin(),blocks.begin() + blockCount,blocks.end());
+			cout << "\nBlocks with the most misses (" << blockCount << " of " << blocks.size() << ")" << endl;
+			cout << setw(12) << "mm blk #" << setw(20) << "address" << setw(12) << "misses" << endl;
+			cout << string(44,'-') << endl;			// Print line to separate header from data
+			for(int i = 0; i < blockCount; i++) {
+				cout << setw(12) << blocks[i].second << setw(20) << blocks[i].second*cacheBlockSize
+					 << setw(12) << -blocks[i].first << endl;
+			}
+			// Rank the sets the same way
+			vector< pair<int64_t,int> > sets;
+			for(unsigned int set = 0; set < setMisses.size(); set++) {
+				if(setMisses[set] != 0) sets.push_back(make_pair(-setMisses[set],(int)set));
+			}
+			int setCount = min(topCount,(int)sets.size());
+			partial_sort(sets.begin(),sets.begin() + setCount,sets.end());
+			cout << "\nMost contended sets (" << setCount << " of " << sets.size() << " sets with misses)" << endl;
+			cout << setw(12) << "cm set #" << setw(12) << "misses" << setw(12) << "conflict" << endl;
+			cout << string(36,'-') << endl;			// Print line to separate header from data
+			for(int i = 0; i < setCount; i++) {
+				cout << setw(12) << sets[i].second << setw(12) << -sets[i].first
+					 << setw(12) << setConflictMisses[sets[i].second] << endl;
+			}
+			cout << endl;
+			return;
+		}
+	private:
+		static const int64_t EMPTY_SLOT = -1;		// Block numbers are never negative
+		ShadowCache shadowCache;					// Fully associative cache of the same size
+		vector< pair<int64_t,int64_t> > blockMisses;	// Hash table of the blocks referenced and
+													// their miss counts, kept together so each
+													// reference touches one cache line of it
+		int64_t numBlocks;							// The number of occupied table slots
+		vector<int64_t> setMisses;					// The number of misses in each set
+		vector<int64_t> setConflictMisses;			// The number of conflict misses in each set
+
+/*****************************************************************************
+Function name:    findBlock
+Purpose:          Finds a block's miss count, adding the block to the table
+                  with no misses on its first reference
+Input parameters: memoryBlockNumber - int64_t - the block referenced
+                  firstReference - bool& - set to whether the block was added
+Return value:     int64_t& - the block's miss count
+******************************************************************************/
+		int64_t& findBlock(int64_t memoryBlockNumber, bool& firstReference) {
+			size_t mask = blockMisses.size() - 1;
+			size_t slot = BlockCounter::hash(memoryBlockNumber) & mask;
+			firstReference = false;
+			while(blockMisses[slot].first != EMPTY_SLOT) {	// Probe until the block or a free slot is found
+				if(blockMisses[slot].first == memoryBlockNumber) return blockMisses[slot].second;
+				slot = (slot + 1) & mask;
+			}
+			// Keep the table at most half full so probe sequences stay short
+			if((numBlocks + 1)*2 > (int64_t)blockMisses.size()) {
+				grow();
+				return findBlock(memoryBlockNumber,firstReference);
+			}
+			numBlocks++;
+			firstReference = true;
+			blockMisses[slot].first = memoryBlockNumber;
+			return blockMisses[slot].second;
+		}
+
+/*****************************************************************************
+Function name:    grow
+Purpose:          Doubles the size of the miss table, reinserting every block
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void grow() {
+			vector< pair<int64_t,int64_t> > oldBlocks(blockMisses.size()*2,make_pair(EMPTY_SLOT,(int64_t)0));
+			oldBlocks.swap(blockMisses);
+			size_t mask = blockMisses.size() - 1;
+			for(size_t i = 0; i < oldBlocks.size(); i++) {
+				if(oldBlocks[i].first == EMPTY_SLOT) continue;
+				size_t slot = BlockCounter::hash(oldBlocks[i].first) & mask;
+				while(blockMisses[slot].first != EMPTY_SLOT) slot = (slot + 1) & mask;
+				blockMisses[slot] = oldBlocks[i];
+			}
+			return;
+		}
+};
+const int64_t MissClassifier::EMPTY_SLOT;		// Defined for the vector constructor's reference
+
+/*****************************************************************************
+Struct name:      IntervalStatistics
+Purpose:          Stores the results of one interval of a simulation
+******************************************************************************/
+struct IntervalStatistics {
+	int64_t firstReference = 0;						// The number of the interval's first reference
+	int64_t references = 0;							// The references in the interval
+	int64_t hits = 0;								// The cache hits in the interval
+	int64_t blocksRead = 0;							// Blocks filled from main memory
+	int64_t dirtyEvictions = 0;						// Dirty blocks written back to main memory
+	int occupiedBlocks = 0;							// Valid cache blocks at the end of the interval
+	int64_t workingSet = 0;							// Estimated distinct blocks referenced
+	double distance = 0;							// Signature distance from the last interval,
+													// 0 for the first
+	int phase = 0;									// The phase the interval belongs to
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       IntervalRecorder
+Purpose:          Splits a simulation into intervals of a fixed number of
+                  references and records the counts of each, so changes in
+                  the cache's behaviour over a long trace can be seen without
+                  printing every reference. Each interval's working set is
+                  summarized by a signature, its references counted by
+                  hashed block, and an interval whose signature is further
+                  than the phase threshold from the last one's starts a
+                  phase, which is given the number of a previous phase it
+                  matches, if any. Weighting the blocks by their references
+                  keeps the blocks a steady workload touches once or twice
+                  at random from looking like a change of phase
+******************************************************************************/
+class IntervalRecorder {
+	public:
+/*****************************************************************************
+Function name:    IntervalRecorder (constructor)
+Purpose:          Creates a recorder that has recorded no intervals
+Input parameters: intervalLength - int - the references in an interval
+Return value:     none
+******************************************************************************/
+		IntervalRecorder(int intervalLength) {
+			this->intervalLength = intervalLength;
+			workingSetBits = MIN_WORKING_SET_BITS;
+			while(workingSetBits < MAX_WORKING_SET_BITS && workingSetBits < 4*(int64_t)intervalLength) {
+				workingSetBits *= 2;
+			}
+			reset(SimulationStatistics(),0);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    reset
+Purpose:          Discards every interval and phase recorded, ready for a
+                  new simulation
+Input parameters: start - const SimulationStatistics& - the totals the first
+                                                        interval starts from
+                  firstReference - int64_t - the trace position it starts at
+Return value:     none
+******************************************************************************/
+		void reset(const SimulationStatistics& start, int64_t firstReference) {
+			remaining = intervalLength;
+			numPhases = 0;
+			signature.assign(SIGNATURE_BUCKETS,0);
+			referencedBits.assign(workingSetBits/64,0);
+			lastSignature.clear();
+			phaseSignatures.clear();
+			intervals.clear();
+			intervalStart = start;
+			this->firstReference = firstReference;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    record
+Purpose:          Adds a reference to the current interval's signature and
+                  working set
+Input parameters: memoryBlockNumber - int64_t - the block referenced
+Return value:     bool - true if the reference completes the interval
+******************************************************************************/
+		bool record(int64_t memoryBlockNumber) {
+			uint64_t hash = samplingHash(memoryBlockNumber);
+			uint64_t bit = hash & (workingSetBits - 1);
+			signature[hash % SIGNATURE_BUCKETS]++;
+			referencedBits[bit >> 6] |= (uint64_t)1 << (bit & 63);
+			return --remaining == 0;
+		}
+
+/*****************************************************************************
+Function name:    endInterval
+Purpose:          Records the counts of the interval just completed, taken
+                  from the running totals of the simulation, and assigns it
+                  a phase
+Input parameters: statistics - const SimulationStatistics& - the running
+                                                             totals
+                  occupiedBlocks - int - the valid blocks in the cache
+Return value:     none
+******************************************************************************/
+		void endInterval(const SimulationStatistics& statistics, int occupiedBlocks) {
+			IntervalStatistics interval;
+			interval.firstReference = intervals.empty() ? firstReference
+									  : intervals.back().firstReference + intervals.back().references;
+			interval.references = intervalLength - remaining;
+			interval.hits = statistics.hits - intervalStart.hits;
+			interval.blocksRead = statistics.blocksRead - intervalStart.blocksRead;
+			interval.dirtyEvictions = statistics.dirtyEvictions - intervalStart.dirtyEvictions;
+			interval.occupiedBlocks = occupiedBlocks;
+			// Linear counting: the share of bits still clear estimates the distinct blocks hashed
+			int64_t setBits = 0;
+			for(size_t i = 0; i < referencedBits.size(); i++) setBits += __builtin_popcountll(referencedBits[i]);
+			double clearShare = (double)max(workingSetBits - setBits,(int64_t)1)/workingSetBits;
+			interval.workingSet = llround(-workingSetBits*log(clearShare));
+			if(lastSignature.empty()) interval.phase = numPhases++;
+			else {
+				interval.distance = distance(signature,lastSignature);
+				if(interval.distance < PHASE_THRESHOLD) interval.phase = intervals.back().phase;
+				else interval.phase = matchPhase();
+			}
+			if(interval.phase == numPhases - 1 && (int)phaseSignatures.size() < min(numPhases,MAX_PHASES)) {
+				phaseSignatures.push_back(signature);	// The signature a new phase is known by
+			}
+			intervals.push_back(interval);
+			lastSignature.swap(signature);
+			signature.assign(SIGNATURE_BUCKETS,0);
+			referencedBits.assign(workingSetBits/64,0);
+			remaining = intervalLength;
+			intervalStart = statistics;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    finish
+Purpose:          Records the last, partial interval of a simulation, if it
+                  has any references
+Input parameters: statistics - const SimulationStatistics& - the final totals
+                  occupiedBlocks - int - the valid blocks in the cache
+Return value:     none
+******************************************************************************/
+		void finish(const SimulationStatistics& statistics, int occupiedBlocks) {
+			if(remaining != intervalLength) endInterval(statistics,occupiedBlocks);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getNumPhases
+Purpose:          Gets the number of distinct phases found
+Input parameters: none
+Return value:     int - the number of phases
+******************************************************************************/
+		int getNumPhases() {
+			return numPhases;
+		}
+
+/*****************************************************************************
+Function name:    printIntervals
+Purpose:          Writes the intervals as a table, CSV rows with a header, or
+                  a JSON array of objects, one per interval
+Input parameters: output - ostream& - where to write the intervals
+                  format - string - text, csv or json
+                  cacheBlocks - int - the number of blocks in the cache, for
+                                      the occupancy percentages
+Return value:     none
+******************************************************************************/
+		void printIntervals(ostream& output, string format, int cacheBlocks) {
+			int phaseChanges = 0;
+			for(size_t i = 1; i < intervals.size(); i++) phaseChanges += (intervals[i].phase != intervals[i - 1].phase);
+			if(format == "text") {
+				output << "Intervals = " << intervals.size() << " of " << intervalLength << " references, "
+					   << numPhases << " phases, " << phaseChanges << " phase changes" << endl;
+				output << setw(10) << "interval" << setw(14) << "first ref" << setw(10) << "hit rate"
+					   << setw(12) << "misses" << setw(12) << "dirty evs" << setw(11) << "occupancy"
+					   << setw(14) << "working set" << setw(10) << "distance" << setw(8) << "phase" << endl;
+				output << string(101,'-') << endl;	// Print line to separate header from data
+			}
+			else if(format == "csv") {
+				output << "interval,first_reference,references,hits,misses,hit_rate,blocks_read,dirty_evictions,"
+						  "occupied_blocks,occupancy,working_set,distance,phase,phase_change\n";
+			}
+			else output << "[";
+			for(size_t i = 0; i < intervals.size(); i++) {
+				const IntervalStatistics& interval = intervals[i];
+				float hitRate = (float)interval.hits/interval.references*100;
+				float occupancy = (float)interval.occupiedBlocks/cacheBlocks*100;
+				bool phaseChange = (i > 0 && interval.phase != intervals[i - 1].phase);
+				if(format == "text") {
+					output << setw(10) << i << setw(14) << interval.firstReference << setw(9) << hitRate << "%"
+						   << setw(12) << interval.references - interval.hits << setw(12) << interval.dirtyEvictions
+						   << setw(10) << occupancy << "%" << setw(14) << interval.workingSet << setw(10)
+						   << interval.distance << setw(8) << interval.phase << (phaseChange ? " *" : "") << endl;
+				}
+				else if(format == "csv") {
+					output << i << "," << interval.firstReference << "," << interval.references << ","
+						   << interval.hits << "," << interval.references - interval.hits << "," << hitRate << ","
+						   << interval.blocksRead << "," << interval.dirtyEvictions << "," << interval.occupiedBlocks
+						   << "," << occupancy << "," << interval.workingSet << "," << interval.distance << ","
+						   << interval.phase << "," << phaseChange << "\n";
+				}
+				else {
+					output << (i ? ", " : "") << "{\"interval\": " << i << ", \"first_reference\": "
+						   << interval.firstReference << ", \"references\": " << interval.references
+						   << ", \"hits\": " << interval.hits << ", \"misses\": " << interval.references - interval.hits
+						   << ", \"hit_rate\": " << hitRate << ", \"blocks_read\": " << interval.blocksRead
+						   << ", \"dirty_evictions\": " << interval.dirtyEvictions << ", \"occupied_blocks\": "
+						   << interval.occupiedBlocks << ", \"occupancy\": " << occupancy << ", \"working_set\": "
+						   << interval.workingSet << ", \"distance\": " << interval.distance << ", \"phase\": "
+						   << interval.phase << ", \"phase_change\": " << (phaseChange ? "true" : "false") << "}";
+				}
+			}
+			if(format == "json") output << "]";
+			else if(format == "text") output << endl;
+			output << flush;
+			return;
+		}
+	private:
+		int intervalLength;							// The references in a full interval
+		int remaining;								// References left in the current interval
+		int64_t workingSetBits;						// The bits of the working set estimate
+		vector<uint32_t> signature;					// The current interval's references to each
+													// bucket of hashed blocks
+		vector<uint64_t> referencedBits;			// The hashed blocks the current interval has
+													// referenced, one bit each
+		vector<uint32_t> lastSignature;				// The last interval's, or empty if none
+		vector< vector<uint32_t> > phaseSignatures;	// The first signature of each phase kept
+		int numPhases;								// The number of phases found
+		vector<IntervalStatistics> intervals;		// The intervals recorded
+		SimulationStatistics intervalStart;			// The running totals when the current interval
+													// started
+		int64_t firstReference;						// The trace position of the first interval
+
+/*****************************************************************************
+Function name:    distance
+Purpose:          Calculates the distance of two signatures: half the
+                  Manhattan distance of their references per bucket, each
+                  divided by the signature's total, which is the share of
+                  references that would have to move bucket to make them
+                  match
+Input parameters: first - const vector<uint32_t>& - a signature
+                  second - const vector<uint32_t>& - another signature
+Return value:     double - the distance, 0 if they match and 1 if disjoint
+******************************************************************************/
+		double distance(const vector<uint32_t>& first, const vector<uint32_t>& second) {
+			double firstTotal = 0, secondTotal = 0;
+			for(int i = 0; i < SIGNATURE_BUCKETS; i++) {
+				firstTotal += first[i];
+				secondTotal += second[i];
+			}
+			if(firstTotal == 0 || secondTotal == 0) return (firstTotal == secondTotal) ? 0 : 1;
+			double difference = 0;
+			for(int i = 0; i < SIGNATURE_BUCKETS; i++) difference += fabs(first[i]/firstTotal - second[i]/secondTotal);
+			return difference/2;
+		}
+
+/*****************************************************************************
+Function name:    matchPhase
+Purpose:          Finds the kept phase whose signature is closest to the
+                  current interval's, or starts a new phase if none is
+                  within the phase threshold
+Input parameters: none
+Return value:     int - the number of the interval's phase
+******************************************************************************/
+		int matchPhase() {
+			int closestPhase = -1;
+			double closestDistance = PHASE_THRESHOLD;
+			for(size_t phase = 0; phase < phaseSignatures.size(); phase++) {
+				double phaseDistance = distance(signature,phaseSignatures[phase]);
+				if(phaseDistance < closestDistance) {
+					closestPhase = phase;
+					closestDistance = phaseDistance;
+				}
+			}
+			return (closestPhase == -1) ? numPhases++ : closestPhase;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       MemorySimulator
+Purpose:          Class for simulating memory supporting generation of the
+                  structure and simulation of reference operations
+******************************************************************************/
+class MemorySimulator {
+	public:
+/*****************************************************************************
+Function name:    MemorySimulator (constructor)
+Purpose:          Create the memory simulator object and initialize attributes
+Input parameters: memorySize - int64_t - The size of main memory in bytes
+                  cacheSize - int - The size of the cache memory in bytes
+                  cacheBlockSize - The size of the cache blocks in bytes
+                  associativity - The degree of associativity, 
+                                  1 meaning direct mapped
+                  policy - ReplacementPolicy - The memory's replacement policy
+Return value:     none
+******************************************************************************/
+		MemorySimulator(int64_t memorySize, int cacheSize, int cacheBlockSize,
+						int associativity, ReplacementPolicy policy)
+			// Initialize the cache memory, which is made up of the number of cache sets (blocks
+			// over associativity), each of which has the same associativity and replacement policy
+			: cacheMemory(cacheSize/cacheBlockSize/associativity,associativity,policy) {
+			// Set the objects internal attributes
+			this->cacheSize = cacheSize;
+			this->cacheBlockSize = cacheBlockSize;
+			this->associativity = associativity;
+			// Calculate number of cache blocks, cache sets, and memory blocks total
+			cacheBlocks = cacheSize/cacheBlockSize;
+			cacheSets = cacheBlocks/associativity;
+			memoryBlocks = memorySize/cacheBlockSize;
+			// Calculate the number of address bits and the sizes of the offset, index and tag fields
+			totalAddressBits = log2(memorySize);
+			offsetBits = log2(cacheBlockSize);
+			indexBits = log2(cacheSets);
+			tagBits = log2(memoryBlocks/cacheSets);
+			printSteps = true;
+			nextReference = 0;
+			writePolicy = WRITE_BACK;				// Write-back, write-allocate by default
+			writeAllocation = WRITE_ALLOCATE;
+			hitLatency = missLatency = 1;
+			memoryLatency = 100;
+			prefetchClock = 0;
+			classifiedTopCount = 0;				// Misses are not classified by default
+			sampleRate = 1;							// Every set is simulated by default
+			fastForwardReference = 0;				// The whole trace is simulated by default
+			stopReference = -1;
+			restored = false;
+			restoredReference = restoredCounted = 0;
+			countedReference = 0;
+			checkpointOutput = NULL;
+			index = MODULO_INDEX;					// Blocks are placed by their low bits by default
+			return;
+		}
+		
+/*****************************************************************************
+Function name:    printMemoryInfo
+Purpose:          Prints various pieces of information about the memory module
+                  including address size in bits, offset, index, and tag sizes
+                  and the total cache size accounting for overhead bits
+Input parameters: none (values come from MemorySimulator object)
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printMemoryInfo() {
+			// Print the number of address lines requires and the size of the 3 fields
+			cout << "Total address lines required = " << totalAddressBits << endl;
+			cout << "Number of bits for offset = " << offsetBits << endl;
+			cout << "Number of bits for index = " << indexBits << endl;
+			cout << "Number of bits for tag = " << tagBits << endl;
+			// Calculate the total cache size (2 accounts for the dirty and valid bits)
+			// divide by 8 to convert the dirty, valid, and tag bit sum to bytes
+			float totalCacheSize = (2 + tagBits)*cacheBlocks/8. + cacheSize;
+			// Print toal cache size, displaying a maximum of 8 significant figures (then revert)
+			cout << "Total cache size required = " << setprecision(8) << totalCacheSize
+				 << setprecision(6) << " bytes" << endl << endl;
+		}
+		
+/*****************************************************************************
+Function name:    runSimulation
+Purpose:          Runs the memory simulation by streaming the references out
+                  of the given trace and prints summary statistics on the
+                  program
+Input parameters: traceReader - TraceReader& - the opened and validated trace
+                                               of memory references to simulate
+                  optimal - bool - whether to replay the trace a second time
+                                   under OPT for the best achievable hit rate
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void runSimulation(TraceReader& traceReader, bool optimal) {
+			// Print the memory references header for the simulation
+			cout << "main memory address" << setw(12) << "mm blk #" << setw(12) << "cm set #" 
+				 << setw(12) << "cm blk #" << setw(12) << "hit/miss" << endl;
+			cout << string(67,'-') << endl;			// Print line to separate header from data
+			SimulationStatistics statistics = simulate(traceReader,true);
+			int64_t numReferences = statistics.references;
+			// Print the hit count and hit rate if only compulsory misses occurred
+			cout << "\nCompulsory-miss bound = " << statistics.compulsoryBoundHits << "/" << numReferences
+				 << " = " << (float)statistics.compulsoryBoundHits/numReferences*100 << "%" << endl;
+			// Print the hit count and hit rate of the optimal policy on this cache, the best achievable
+			if(optimal) {
+				int64_t optimalHits = calculateOptimalHitCount(traceReader);
+				cout << "Optimal (OPT) hit rate = " << optimalHits << "/" << numReferences
+					 << " = " << (float)optimalHits/numReferences*100 << "%" << endl;
+			}
+			// Print actual hit count and calculated actual hit rate
+			cout << "Actual hit rate = " << statistics.hits << "/" << numReferences
+				 << " = " << (float)statistics.hits/numReferences*100 << "%" << endl;
+			printTraffic(statistics);
+			cout << endl;
+			printMissClassification(statistics);
+			printIntervals(cout,"text");
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printTraffic
+Purpose:          Prints the dirty evictions, the memory traffic and the
+                  average memory access time of a simulation
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printTraffic(const SimulationStatistics& statistics) {
+			if(!sampledSets.empty()) {
+				cout << "Set sampling = " << statistics.sampledReferences << "/" << statistics.references
+					 << " references in " << getSampledSets() << " of " << cacheSets << " sets, hit rate +/- "
+					 << statistics.hitRateError << "% (95% confidence), other counts scaled up" << endl;
+			}
+			cout << "Dirty evictions = " << statistics.dirtyEvictions << " ("
+				 << statistics.dirtyEvictions*cacheBlockSize << " bytes written back)" << endl;
+			if(victimCache) {
+				cout << "Victim cache = " << victimCache->getEntries() << " blocks, " << statistics.victimHits
+					 << " hits (" << (statistics.hits ? (float)statistics.victimHits/statistics.hits*100 : 0)
+					 << "% of hits, " << statistics.hits - statistics.victimHits << " in the " << INDEX_NAMES[index]
+					 << " indexed cache)" << endl;
+			}
+			cout << "Memory traffic = " << getBytesRead(statistics) << " bytes read + "
+				 << getBytesWritten(statistics) << " bytes written = "
+				 << (float)(getBytesRead(statistics) + getBytesWritten(statistics))/statistics.references
+				 << " bytes per reference" << endl;
+			cout << "Average memory access time = " << getAverageAccessTime(statistics) << " cycles" << endl;
+			if(prefetcher.type != NO_PREFETCHER) printPrefetches(statistics);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printPrefetches
+Purpose:          Prints how well the prefetcher did in a simulation: how
+                  many prefetches it issued and how accurate, timely and
+                  polluting they were, and the share of misses they removed
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printPrefetches(const SimulationStatistics& statistics) {
+			cout << "Prefetcher = " << PREFETCHER_NAMES[prefetcher.type] << " (degree " << prefetcher.degree
+				 << ", distance " << prefetcher.distance << ")" << endl;
+			cout << "Prefetches = " << statistics.prefetches << " issued, " << statistics.usefulPrefetches
+				 << " useful (accuracy " << getPrefetchAccuracy(statistics) << "%), " << statistics.latePrefetches
+				 << " late (timeliness " << getPrefetchTimeliness(statistics) << "%)" << endl;
+			cout << "Prefetch coverage = " << getPrefetchCoverage(statistics) << "% of misses, "
+				 << statistics.unusedPrefetches << " replaced unused, " << statistics.pollutionMisses
+				 << " pollution misses" << endl;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    setSampling
+Purpose:          Sets the share of the cache sets simulated, so large traces
+                  can be estimated quickly. Each set is exact, so the only
+                  error is which sets were sampled, and the results are
+                  scaled up to the whole trace with a confidence interval.
+                  The sets with the lowest hashes are chosen, at least two
+Input parameters: rate - double - the share of sets to simulate, 1 for all
+Return value:     none
+******************************************************************************/
+		void setSampling(double rate) {
+			sampleRate = rate;
+			int numSampled = max((int)(rate*cacheSets + 0.5),2);
+			sampledSets.clear();
+			if(numSampled >= cacheSets) return;		// Every set is simulated
+			vector< pair<uint64_t,int> > hashes(cacheSets);
+			for(int set = 0; set < cacheSets; set++) hashes[set] = make_pair(samplingHash(set),set);
+			nth_element(hashes.begin(),hashes.begin() + numSampled,hashes.end());
+			sampledSets.assign(cacheSets,0);
+			for(int i = 0; i < numSampled; i++) sampledSets[hashes[i].second] = 1;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getSampledSets
+Purpose:          Gets the number of cache sets simulated
+Input parameters: none
+Return value:     int - the sets simulated, all of them unless sampling
+******************************************************************************/
+		int getSampledSets() {
+			if(sampledSets.empty()) return cacheSets;
+			return (int)count(sampledSets.begin(),sampledSets.end(),1);
+		}
+
+/*****************************************************************************
+Function name:    setMissClassification
+Purpose:          Sets whether each miss is classified as compulsory,
+                  capacity or conflict, and how many of the blocks and sets
+                  with the most misses the report lists
+Input parameters: topCount - int - the blocks and sets to list, or 0 to not
+                                   classify misses
+Return value:     none
+******************************************************************************/
+		void setMissClassification(int topCount) {
+			classifiedTopCount = topCount;
+			if(topCount > 0) classifier.reset(new MissClassifier(cacheBlocks,cacheSets));
+			else classifier.reset();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printMissClassification
+Purpose:          Prints the three Cs breakdown of the misses and the blocks
+                  and sets with the most misses, if misses are classified
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printMissClassification(const SimulationStatistics& statistics) {
+			if(classifier) classifier->printClassification(statistics,classifiedTopCount,cacheBlockSize);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    setIntervals
+Purpose:          Sets how many references each interval of the simulation
+                  holds, recording the counts and phase of every interval
+Input parameters: intervalLength - int - the references in an interval, or 0
+                                         to not record intervals
+Return value:     none
+******************************************************************************/
+		void setIntervals(int intervalLength) {
+			if(intervalLength > 0) intervals.reset(new IntervalRecorder(intervalLength));
+			else intervals.reset();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printIntervals
+Purpose:          Writes the counts and phase of every interval of the last
+                  simulation, if intervals are recorded
+Input parameters: output - ostream& - where to write the intervals
+                  format - string - text, csv or json
+Return value:     none
+******************************************************************************/
+		void printIntervals(ostream& output, string format) {
+			if(intervals) intervals->printIntervals(output,format,cacheBlocks);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getNumPhases
+Purpose:          Gets the number of phases found in the last simulation
+Input parameters: none
+Return value:     int - the number of phases, 0 if intervals are not recorded
+******************************************************************************/
+		int getNumPhases() {
+			return intervals ? intervals->getNumPhases() : 0;
+		}
+
+/*****************************************************************************
+Function name:    setRange
+Purpose:          Sets the part of the trace simulated. References before the
+                  fast-forward point only warm the cache: they update its
+                  blocks and replacement state but are not counted, printed
+                  or recorded, so a region of interest starts from a warm
+                  cache, and the simulation ends at the stop point
+Input parameters: fastForward - int64_t - the first reference counted
+                  stop - int64_t - one past the last reference simulated, or
+                                   -1 for the end of the trace
+Return value:     none
+******************************************************************************/
+		void setRange(int64_t fastForward, int64_t stop) {
+			fastForwardReference = fastForward;
+			stopReference = stop;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    setCheckpoint
+Purpose:          Sets where the simulation writes a checkpoint of the cache
+                  state, the statistics and the trace position when it ends
+Input parameters: output - ostream* - the open checkpoint file, or NULL to
+                                      not write a checkpoint
+Return value:     none
+******************************************************************************/
+		void setCheckpoint(ostream* output) {
+			checkpointOutput = output;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    restoreCheckpoint
+Purpose:          Restores the cache state and statistics of a checkpoint
+                  taken of a cache with the same configuration, so the next
+                  simulation resumes the trace where the checkpoint was taken.
+                  A checkpoint with counted references can only be resumed
+                  without a fast-forward past it, which would leave a gap in
+                  its counts
+Input parameters: input - istream& - the open checkpoint file
+                  error - string& - set to a description of any error
+Return value:     bool - true if the checkpoint was restored, false if not
+******************************************************************************/
+		bool restoreCheckpoint(istream& input, string& error) {
+			char magic[4];
+			uint16_t version;
+			int64_t expected[CHECKPOINT_FIELDS];	// This cache's fields and the checkpoint's
+			int64_t fields[CHECKPOINT_FIELDS];
+			input.read(magic,sizeof(magic));
+			input.read((char*)&version,sizeof(version));
+			input.read((char*)fields,sizeof(fields));
+			if(!input || memcmp(magic,CHECKPOINT_MAGIC,4) != 0 || version != CHECKPOINT_VERSION) {
+				error = "Not a checkpoint of this version of the simulator";
+				return false;
+			}
+			describeCheckpoint(expected,0,0);
+			if(!equal(fields,fields + CHECKPOINT_CACHE_FIELDS,expected)) {
+				error = "The checkpoint was taken of a cache with a different size, block size, associativity, "
+						"replacement policy, write policy or index function";
+				return false;
+			}
+			input.read((char*)&restoredStatistics,sizeof(restoredStatistics));
+			if(!input || !cacheMemory.load(input) || !restoredBlocks.load(input)) {
+				error = "The checkpoint is incomplete";
+				return false;
+			}
+			restored = true;
+			restoredReference = fields[CHECKPOINT_CACHE_FIELDS];
+			restoredCounted = fields[CHECKPOINT_CACHE_FIELDS + 1];
+			if(restoredStatistics.references > 0 && fastForwardReference > restoredReference) {
+				error = "A checkpoint with counted references cannot be fast-forwarded";
+				return false;
+			}
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    getFirstReference
+Purpose:          Gets the trace position a simulation starts from
+Input parameters: none
+Return value:     int64_t - the next reference of the restored checkpoint, or 0
+******************************************************************************/
+		int64_t getFirstReference() {
+			return restoredReference;
+		}
+
+/*****************************************************************************
+Function name:    setPrefetcher
+Purpose:          Sets the hardware prefetcher run alongside the demand
+                  accesses of the simulation
+Input parameters: type - PrefetcherType - the prefetcher to model
+                  degree - int - the blocks requested by one prediction
+                  distance - int - how far ahead the first requested block is
+Return value:     none
+******************************************************************************/
+		void setPrefetcher(PrefetcherType type, int degree, int distance) {
+			prefetcher.configure(type,degree,distance,offsetBits);
+			prefetchedBlocks.clear();
+			prefetchClock = 0;
+			if(type != NO_PREFETCHER) {
+				pollutionVictims.assign(cacheBlocks,-1);
+				victimCursors.assign(cacheSets,0);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    setOrganization
+Purpose:          Sets how blocks are placed in the cache: the function from
+                  a block number to its set, and the size of an optional
+                  fully associative victim cache of the blocks just replaced,
+                  whose hits count as cache hits taking the miss latency too.
+                  Only the set-indexed MODULO and XOR functions apply here;
+                  the per-way SKEWED and ZCACHE ones are hierarchy levels
+Input parameters: index - IndexFunction - MODULO_INDEX or XOR_INDEX
+                  victimEntries - int - the victim cache's blocks, 0 for none
+Return value:     none
+******************************************************************************/
+		void setOrganization(IndexFunction index, int victimEntries) {
+			this->index = index;
+			victimCache.reset(victimEntries > 0 ? new VictimCache(victimEntries) : NULL);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getPrefetchAccuracy
+Purpose:          Calculates the percentage of prefetches that were used
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     double - the prefetch accuracy in percent
+******************************************************************************/
+		double getPrefetchAccuracy(const SimulationStatistics& statistics) {
+			if(statistics.prefetches == 0) return 0;
+			return (double)statistics.usefulPrefetches/statistics.prefetches*100;
+		}
+
+/*****************************************************************************
+Function name:    getPrefetchCoverage
+Purpose:          Calculates the percentage of the misses the cache would
+                  otherwise have had that the prefetches removed
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     double - the prefetch coverage in percent
+******************************************************************************/
+		double getPrefetchCoverage(const SimulationStatistics& statistics) {
+			int64_t misses = statistics.references - statistics.hits + statistics.usefulPrefetches;
+			if(misses == 0) return 0;
+			return (double)statistics.usefulPrefetches/misses*100;
+		}
+
+/*****************************************************************************
+Function name:    getPrefetchTimeliness
+Purpose:          Calculates the percentage of useful prefetches that had
+                  arrived from memory by the time they were used
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     double - the prefetch timeliness in percent
+******************************************************************************/
+		double getPrefetchTimeliness(const SimulationStatistics& statistics) {
+			if(statistics.usefulPrefetches == 0) return 0;
+			return (double)(statistics.usefulPrefetches - statistics.latePrefetches)/statistics.usefulPrefetches*100;
+		}
+
+/*****************************************************************************
+Function name:    setWritePolicy
+Purpose:          Sets how writes are handled by the cache
+Input parameters: writePolicy - WritePolicy - whether a write marks the block
+                                              dirty or goes through to memory
+                  writeAllocation - WriteAllocation - whether a write miss
+                                                      fills the block
+Return value:     none
+******************************************************************************/
+		void setWritePolicy(WritePolicy writePolicy, WriteAllocation writeAllocation) {
+			this->writePolicy = writePolicy;
+			this->writeAllocation = writeAllocation;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    setLatencies
+Purpose:          Sets the latencies used for the average memory access time
+Input parameters: hitLatency - int - cycles taken by a cache hit
+                  missLatency - int - cycles the cache takes to detect a miss
+                  memoryLatency - int - cycles taken to read a block from
+                                        main memory after a miss
+Return value:     none
+******************************************************************************/
+		void setLatencies(int hitLatency, int missLatency, int memoryLatency) {
+			this->hitLatency = hitLatency;
+			this->missLatency = missLatency;
+			this->memoryLatency = memoryLatency;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getAverageAccessTime
+Purpose:          Calculates the average memory access time of a simulation:
+                  every hit takes the hit latency, every miss the miss
+                  latency, and every block read from memory the memory
+                  latency on top (writes to memory are assumed buffered),
+                  plus any time spent waiting for late prefetches. A victim
+                  cache hit is found only after the cache misses
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     double - the average memory access time in cycles
+******************************************************************************/
+		double getAverageAccessTime(const SimulationStatistics& statistics) {
+			double cycles = (double)statistics.hits*hitLatency
+							+ (double)(statistics.references - statistics.hits)*missLatency
+							+ (double)statistics.blocksRead*memoryLatency
+							+ (double)statistics.prefetchStallCycles
+							+ (double)statistics.victimHits*missLatency;
+			return cycles/statistics.references;
+		}
+
+/*****************************************************************************
+Function name:    getBytesRead
+Purpose:          Calculates the bytes read from main memory in a
+                  simulation, by demand misses and by prefetches
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     int64_t - the number of bytes read
+******************************************************************************/
+		int64_t getBytesRead(const SimulationStatistics& statistics) {
+			return (statistics.blocksRead + statistics.prefetches)*cacheBlockSize;
+		}
+
+/*****************************************************************************
+Function name:    getBytesWritten
+Purpose:          Calculates the bytes written to main memory in a
+                  simulation, both written back blocks and written words
+Input parameters: statistics - const SimulationStatistics& - the results of
+                                                             the simulation
+Return value:     int64_t - the number of bytes written
+******************************************************************************/
+		int64_t getBytesWritten(const SimulationStatistics& statistics) {
+			return statistics.dirtyEvictions*cacheBlockSize + statistics.wordsWritten*WRITE_WORD_SIZE;
+		}
+
+/*****************************************************************************
+Function name:    simulate
+Purpose:          Runs the memory simulation by streaming the references out
+                  of the given trace, optionally printing every step
+Input parameters: traceReader - TraceReader& - the opened and validated trace
+                                               of memory references to simulate
+                  printSteps - bool - whether to print the result of each
+                                      memory reference
+Return value:     SimulationStatistics - the hit counts of the simulation
+******************************************************************************/
+		SimulationStatistics simulate(TraceReader& traceReader, bool printSteps) {
+			// Counts the cache hits while simulating, carrying on from a restored checkpoint's counts
+			SimulationStatistics statistics = restoredStatistics;
+			this->printSteps = printSteps;
+			// Counts the distinct memory blocks referenced, used for the compulsory-miss bound
+			BlockCounter referencedBlocks = restoredBlocks;
+			// Buffer holding one chunk of a text trace at a time, so memory use is bounded
+			vector<MemoryReference> chunk(traceReader.isBinary() ? 0 : TRACE_CHUNK_SIZE);
+			if(cacheMemory.policy == OPT) buildNextUses(traceReader);	// OPT needs to see the future
+			if(!sampledSets.empty()) {				// Count each sampled set's share of the results
+				setReferences.assign(cacheSets,0);
+				setHits.assign(cacheSets,0);
+			}
+			traceReader.rewind();
+			// Skip the references a restored checkpoint has already simulated, warm the cache with the
+			// references before the fast-forward point, then simulate the rest up to the stop point
+			int64_t position = traceReader.skip(restoredReference);
+			int64_t lastReference = traceReader.getNumReferences();
+			if(stopReference >= 0) lastReference = min(stopReference,lastReference);
+			int64_t firstCounted = min(max(fastForwardReference,position),lastReference);
+			nextReference = position;
+			if(intervals) intervals->reset(statistics,firstCounted);
+			SimulationStatistics warmingStatistics;	// Traffic while warming, which is not counted
+			replayReferences<true>(traceReader,chunk,warmingStatistics,referencedBlocks,firstCounted - position);
+			replayReferences<false>(traceReader,chunk,statistics,referencedBlocks,lastReference - firstCounted);
+			statistics.references += lastReference - firstCounted;
+			// Counting started at the restored checkpoint's first counted reference if it had any
+			countedReference = (restoredStatistics.references > 0) ? restoredCounted : firstCounted;
+			if(checkpointOutput) saveCheckpoint(*checkpointOutput,statistics,referencedBlocks,lastReference);
+			if(intervals) intervals->finish(statistics,countValidBlocks());
+			if(!sampledSets.empty()) {
+				estimateFromSample(statistics,referencedBlocks);
+				return statistics;
+			}
+			// Calculate the compulsory-miss bound of the memory reference file
+			statistics.compulsoryBoundHits = calculateCompulsoryBound(statistics.references,referencedBlocks);
+			return statistics;
+		}
+		
+/*****************************************************************************
+Function name:    simulateParallel
+Purpose:          Runs the memory simulation with the cache sets divided
+                  between worker threads. The calling thread streams the
+                  trace and hands each reference to the worker owning its
+                  set, so every set sees its references in trace order and
+                  the hit counts and final cache state match the serial
+                  simulation exactly
+Input parameters: traceReader - TraceReader& - the opened and validated trace
+                                               of memory references to simulate
+                  numThreads - int - the number of worker threads
+Return value:     SimulationStatistics - the hit counts of the simulation
+******************************************************************************/
+		SimulationStatistics simulateParallel(TraceReader& traceReader, int numThreads) {
+			// Policies whose sets depend on each other (OPT numbers its next uses in trace order, and
+			// the random and set dueling policies share state between sets) are simulated serially,
+			// as are prefetchers, which learn from every set and fill blocks into any of them, and
+			// miss classification, whose fully associative shadow cache sees every reference in order,
+			// and intervals, fast-forwards and checkpoints, which end at a point in the trace, and a
+			// victim cache, which every set shares. Set sampling is fast enough on one thread, and the
+			// workers own sets by their low bits
+			if(numThreads <= 1 || hasSharedPolicyState(cacheMemory.policy) || prefetcher.type != NO_PREFETCHER
+			   || classifier || intervals || !sampledSets.empty() || fastForwardReference > 0 || stopReference >= 0
+			   || restored || checkpointOutput || victimCache || index != MODULO_INDEX) {
+				return simulate(traceReader,false);
+			}
+			SimulationStatistics statistics;
+			statistics.references = traceReader.getNumReferences();
+			const int BATCH_SIZE = 4096;			// References handed to a worker at a time
+			const int QUEUE_BATCHES = 8;			// Batches a worker may fall behind by
+			// Sets are owned in groups of 64 blocks, so that no two workers ever update the same
+			// word of the valid and dirty bitmaps
+			int groupShift = max(6 - log2(associativity),0);
+			vector< unique_ptr<ReferenceQueue> > queues;
+			vector<SimulationStatistics> workerStatistics(numThreads);
+			vector<thread> workers;
+			void (MemorySimulator::*partition)(ReferenceQueue*,SimulationStatistics*);	// The worker for the policy
+			switch(cacheMemory.policy) {
+				case FIFO: partition = &MemorySimulator::simulatePartition<FIFO>; break;
+				case TREE_PLRU: partition = &MemorySimulator::simulatePartition<TREE_PLRU>; break;
+				case BIT_PLRU: partition = &MemorySimulator::simulatePartition<BIT_PLRU>; break;
+				case SRRIP: partition = &MemorySimulator::simulatePartition<SRRIP>; break;
+				case LFU: partition = &MemorySimulator::simulatePartition<LFU>; break;
+				default: partition = &MemorySimulator::simulatePartition<LRU>; break;
+			}
+			for(int i = 0; i < numThreads; i++) {
+				queues.push_back(unique_ptr<ReferenceQueue>(new ReferenceQueue(QUEUE_BATCHES)));
+				workers.push_back(thread(partition,this,queues[i].get(),&workerStatistics[i]));
+			}
+			// Stream the trace, sorting the references into per-worker batches
+			BlockCounter referencedBlocks;
+			vector< vector<MemoryReference> > pending(numThreads);
+			vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+			int chunkSize;
+			traceReader.rewind();
+			while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+				for(int i = 0; i < chunkSize; i++) {
+					int64_t memoryBlockNumber = chunk[i].memoryAddress >> offsetBits;
+					int cacheSetNumber = memoryBlockNumber & (cacheSets - 1);
+					int worker = (cacheSetNumber >> groupShift) % numThreads;
+					referencedBlocks.add(memoryBlockNumber);
+					pending[worker].push_back(chunk[i]);
+					if((int)pending[worker].size() == BATCH_SIZE) queues[worker]->push(pending[worker]);
+				}
+			}
+			for(int i = 0; i < numThreads; i++) {	// Hand over the partial batches and finish
+				if(!pending[i].empty()) queues[i]->push(pending[i]);
+				queues[i]->close();
+			}
+			for(int i = 0; i < numThreads; i++) {
+				workers[i].join();
+				statistics.hits += workerStatistics[i].hits;
+				statistics.blocksRead += workerStatistics[i].blocksRead;
+				statistics.dirtyEvictions += workerStatistics[i].dirtyEvictions;
+				statistics.wordsWritten += workerStatistics[i].wordsWritten;
+			}
+			statistics.compulsoryBoundHits = calculateCompulsoryBound(statistics.references,referencedBlocks);
+			return statistics;
+		}
+		
+/*****************************************************************************
+Function name:    calculateOptimalHitCount
+Purpose:          Calculates the number of hits Belady's optimal policy gets
+                  on this cache's geometry, the true upper bound for any
+                  replacement policy given the cache's capacity and
+                  associativity
+Input parameters: traceReader - TraceReader& - the opened and validated trace
+                                               of memory references to simulate
+Return value:     int64_t - the optimal hit count of the trace
+******************************************************************************/
+		int64_t calculateOptimalHitCount(TraceReader& traceReader) {
+			MemorySimulator optimal(memoryBlocks*cacheBlockSize,cacheSize,cacheBlockSize,associativity,OPT);
+			optimal.setWritePolicy(writePolicy,writeAllocation);
+			optimal.setSampling(sampleRate);
+			// OPT places blocks the same way, but has no victim cache, which is not a set of the cache
+			optimal.setOrganization(index,0);
+			// OPT warms its own cache up to the first reference counted, then counts the same references
+			optimal.setRange(countedReference,stopReference);
+			return optimal.simulate(traceReader,false).hits;
+		}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Runs a single memory reference through the cache, for
+                  callers generating references themselves rather than
+                  replaying a trace. OPT needs the next use of every
+                  reference, so it can only be simulated from a trace
+Input parameters: memoryAddress - int64_t - the memory address being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  statistics - SimulationStatistics& - the counts to update
+Return value:     HitMiss - whether the access was a hit or a miss
+******************************************************************************/
+		HitMiss access(int64_t memoryAddress, ReadWrite operation, SimulationStatistics& statistics) {
+			HitMiss status = simulationStep(memoryAddress,operation,statistics);
+			statistics.references++;
+			if(status == HIT) statistics.hits++;
+			return status;
+		}
+
+/*****************************************************************************
+Function name:    accessBatch
+Purpose:          Runs a batch of memory references through the cache with
+                  the simulation step compiled for the cache's replacement
+                  policy and geometry, chosen once for the whole batch.
+                  Nothing is printed or recorded beyond the statistics
+Input parameters: addresses - const uint64_t* - the memory addresses
+                  operations - const uint8_t* - the ReadWrite operation of
+                                                each reference, or NULL if
+                                                they are all reads
+                  count - size_t - the number of references
+                  results - uint8_t* - set to 1 for each hit and 0 for each
+                                       miss, or NULL
+                  statistics - SimulationStatistics& - the counts to update
+Return value:     size_t - the number of references that hit
+******************************************************************************/
+		size_t accessBatch(const uint64_t* addresses, const uint8_t* operations, size_t count, uint8_t* results,
+						   SimulationStatistics& statistics) {
+			// OPT needs the next use of every reference, so it can only be simulated from a trace
+			switch(cacheMemory.policy) {
+				case LRU: return accessGeometry<LRU>(addresses,operations,count,results,statistics);
+				case FIFO: return accessGeometry<FIFO>(addresses,operations,count,results,statistics);
+				case TREE_PLRU: return accessGeometry<TREE_PLRU>(addresses,operations,count,results,statistics);
+				case BIT_PLRU: return accessGeometry<BIT_PLRU>(addresses,operations,count,results,statistics);
+				case SRRIP: return accessGeometry<SRRIP>(addresses,operations,count,results,statistics);
+				case BRRIP: return accessGeometry<BRRIP>(addresses,operations,count,results,statistics);
+				case DRRIP: return accessGeometry<DRRIP>(addresses,operations,count,results,statistics);
+				case RANDOM: return accessGeometry<RANDOM>(addresses,operations,count,results,statistics);
+				case LFU: return accessGeometry<LFU>(addresses,operations,count,results,statistics);
+				default: return 0;
+			}
+		}
+
+/*****************************************************************************
+Function name:    setSeed
+Purpose:          Seeds the random numbers of the RANDOM, BRRIP and DRRIP
+                  policies, so that a simulation can be repeated exactly
+Input parameters: seed - uint64_t - the seed
+Return value:     none
+******************************************************************************/
+		void setSeed(uint64_t seed) {
+			cacheMemory.seedRandom(seed);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printCache
+Purpose:          Prints the state of the cache of the MemorySimulator object
+                  at the current simulation step
+Input parameters: none (values come from MemorySimulator object)
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printCache() {
+			// Print cache contents header
+			cout << "Cache blk #" << setw(12) << "dirty bit" << setw(12) << "valid bit" 
+				 << setw(10) << "tag" << setw(16) << "Data" << endl;
+			cout << string(67,'-') << endl;			// Print line to separate header from data
+			for(int i = 0; i < cacheBlocks; i++) {	// For each cache block in the memory simulator
+				printCacheBlock(i);					// print the cache block
+			}
+			cout << endl;							// Print blank line for spacing
+			return;
+		}
+	private:
+		int cacheSize;								// Stores the size of cache in bytes
+		int cacheBlockSize;							// Stores the size of cache blocks in bytes
+		int associativity;							// Stores the memory's degree of associativity 
+		int cacheBlocks;							// Stores the number of cache blocks
+		int cacheSets;								// Stores the number of cache sets
+		int64_t memoryBlocks;						// Stores the number of memory blocks
+		int totalAddressBits;						// Stores the number of address bits for memory
+		int offsetBits;								// Stores the number of offset bits in the address
+		int indexBits;								// Stores the number of index bits in the address
+		int tagBits;								// Stores the number of tag bits in the address
+		CacheStorage cacheMemory;					// Emulated cache memory device, whose cache sets
+													// are viewed through CacheSet objects
+		bool printSteps;							// Whether to print each simulation step
+		vector<int64_t> nextUses;					// OPT only: the number of the next reference to
+													// the same block for every reference in the trace
+		int64_t nextReference;						// OPT only: the number of the next reference
+		WritePolicy writePolicy;					// Whether writes are written back or through
+		WriteAllocation writeAllocation;			// Whether write misses fill the block
+		int hitLatency;								// Cycles taken by a cache hit
+		int missLatency;							// Cycles taken to detect a cache miss
+		int memoryLatency;							// Cycles taken to read a block from memory
+		Prefetcher prefetcher;						// The hardware prefetcher, if any
+		unordered_map<int64_t,int64_t> prefetchedBlocks;	// Prefetched blocks not used yet, and the
+													// cycle each arrives from memory
+		vector<int64_t> pollutionVictims;			// Blocks recently replaced by prefetches, a
+													// ring of one per cache block in each set
+		vector<int> victimCursors;					// The next ring entry to overwrite in each set
+		int64_t prefetchClock;						// Cycles elapsed, for the prefetch arrivals
+		unique_ptr<MissClassifier> classifier;		// Sorts the misses into the three Cs, if set
+		int classifiedTopCount;						// The blocks and sets with most misses to list
+		unique_ptr<IntervalRecorder> intervals;		// Records the counts of each interval, if set
+		double sampleRate;							// The share of the sets simulated
+		vector<char> sampledSets;					// Whether each set is simulated, or empty if
+													// every set is
+		vector<int64_t> setReferences;				// Set sampling only: references to each set
+		vector<int64_t> setHits;					// Set sampling only: hits in each set
+		int64_t fastForwardReference;				// References before this one only warm the cache
+		int64_t stopReference;						// One past the last reference simulated, or -1
+		bool restored;								// Whether a checkpoint has been restored
+		int64_t restoredReference;					// The restored checkpoint's next reference
+		int64_t restoredCounted;					// And the first reference its statistics count
+		SimulationStatistics restoredStatistics;	// The restored checkpoint's statistics
+		BlockCounter restoredBlocks;				// And its distinct blocks referenced
+		int64_t countedReference;					// First reference counted by the last simulation
+		ostream* checkpointOutput;					// Where to write a checkpoint, or NULL
+		IndexFunction index;						// How a block number picks its cache set
+		unique_ptr<VictimCache> victimCache;		// Holds the blocks just replaced, if set
+/*****************************************************************************
+Function name:    replayReferences
+Purpose:          Replays the next references of the trace with the kernel
+                  specialized for the cache's replacement policy
+Template params:  WARMING - bool - whether the references only warm the cache
+Input parameters: traceReader - TraceReader& - the trace to replay
+                  chunk - vector<MemoryReference>& - buffer for text traces
+                  statistics - SimulationStatistics& - the hit counts to update
+                  referencedBlocks - BlockCounter& - the distinct memory
+                                                     blocks referenced
+                  count - int64_t - the number of references to replay
+Return value:     none
+******************************************************************************/
+		template<bool WARMING>
+		void replayReferences(TraceReader& traceReader, vector<MemoryReference>& chunk,
+							  SimulationStatistics& statistics, BlockCounter& referencedBlocks, int64_t count) {
+			if(count <= 0) return;
+			switch(cacheMemory.policy) {
+				case LRU: replayTrace<LRU,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case FIFO: replayTrace<FIFO,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case OPT: replayTrace<OPT,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case TREE_PLRU: replayTrace<TREE_PLRU,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case BIT_PLRU: replayTrace<BIT_PLRU,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case SRRIP: replayTrace<SRRIP,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case BRRIP: replayTrace<BRRIP,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case DRRIP: replayTrace<DRRIP,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case RANDOM: replayTrace<RANDOM,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+				case LFU: replayTrace<LFU,WARMING>(traceReader,chunk,statistics,referencedBlocks,count); break;
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    replayTrace
+Purpose:          Replays the trace with a simulation kernel compiled for the
+                  cache's geometry if it is one of the common geometries,
+                  with the XOR kernel if the cache is XOR indexed, or with
+                  the general shift and mask kernel otherwise
+Template params:  POLICY - ReplacementPolicy - the cache's replacement policy
+                  WARMING - bool - whether the references only warm the cache
+Input parameters: traceReader - TraceReader& - the trace to replay
+                  chunk - vector<MemoryReference>& - buffer for text traces
+                  statistics - SimulationStatistics& - the hit counts to update
+                  referencedBlocks - BlockCounter& - the distinct memory
+                                                     blocks referenced
+                  count - int64_t - the number of references to replay
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		template<ReplacementPolicy POLICY, bool WARMING>
+		void replayTrace(TraceReader& traceReader, vector<MemoryReference>& chunk,
+						 SimulationStatistics& statistics, BlockCounter& referencedBlocks, int64_t count) {
+			// XOR indexing has its own kernel, leaving the common geometries' kernels untouched
+			if(index == XOR_INDEX) {
+				replayKernel<POLICY,WARMING>(XorGeometry(offsetBits,indexBits),traceReader,chunk,statistics,
+											 referencedBlocks,count);
+			}
+			// Common L1 data cache geometries: 64 byte blocks with 16-32 KB over 4 or 8 ways
+			else if(FixedGeometry<6,6,8>::matches(offsetBits,indexBits,associativity)) {
+				replayKernel<POLICY,WARMING>(FixedGeometry<6,6,8>(),traceReader,chunk,statistics,referencedBlocks,count);
+			}
+			else if(FixedGeometry<6,5,8>::matches(offsetBits,indexBits,associativity)) {
+				replayKernel<POLICY,WARMING>(FixedGeometry<6,5,8>(),traceReader,chunk,statistics,referencedBlocks,count);
+			}
+			else if(FixedGeometry<6,7,4>::matches(offsetBits,indexBits,associativity)) {
+				replayKernel<POLICY,WARMING>(FixedGeometry<6,7,4>(),traceReader,chunk,statistics,referencedBlocks,count);
+			}
+			else if(FixedGeometry<6,6,4>::matches(offsetBits,indexBits,associativity)) {
+				replayKernel<POLICY,WARMING>(FixedGeometry<6,6,4>(),traceReader,chunk,statistics,referencedBlocks,count);
+			}
+			// Small direct mapped and 2-way caches with 32 byte blocks
+			else if(FixedGeometry<5,8,1>::matches(offsetBits,indexBits,associativity)) {
+				replayKernel<POLICY,WARMING>(FixedGeometry<5,8,1>(),traceReader,chunk,statistics,referencedBlocks,count);
+			}
+			else if(FixedGeometry<5,7,2>::matches(offsetBits,indexBits,associativity)) {
+				replayKernel<POLICY,WARMING>(FixedGeometry<5,7,2>(),traceReader,chunk,statistics,referencedBlocks,count);
+			}
+			else {									// Any other geometry uses the runtime kernel
+				replayKernel<POLICY,WARMING>(RuntimeGeometry(offsetBits,indexBits),traceReader,chunk,statistics,
+											 referencedBlocks,count);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    replayKernel
+Purpose:          Simulates and prints the next references of the trace,
+                  updating the running statistics of the simulation. When
+                  warming, the references only update the cache's state
+                  (functional warming), skipping everything else
+Template params:  POLICY - ReplacementPolicy - the cache's replacement policy
+                  WARMING - bool - whether the references only warm the cache
+                  Geometry - class - FixedGeometry or RuntimeGeometry type
+                                     describing how addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  traceReader - TraceReader& - the trace to replay
+                  chunk - vector<MemoryReference>& - buffer for text traces
+                  statistics - SimulationStatistics& - the hit counts to update
+                  referencedBlocks - BlockCounter& - the distinct memory
+                                                     blocks referenced
+                  count - int64_t - the number of references to replay
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		template<ReplacementPolicy POLICY, bool WARMING, class Geometry>
+		void replayKernel(const Geometry& geometry, TraceReader& traceReader,
+						  vector<MemoryReference>& chunk, SimulationStatistics& statistics,
+						  BlockCounter& referencedBlocks, int64_t count) {
+			int chunkSize;							// The number of references in the current chunk
+			int64_t memoryAddress;					// Address and operation of a binary trace record
+			ReadWrite operation = READ;
+			bool sampling = !sampledSets.empty();	// Whether references to other sets are skipped
+			bool recording = (bool)intervals;		// Whether the counts of each interval are recorded
+			if(traceReader.isBinary()) {			// Binary records are replayed straight from the file
+				for(; count > 0 && traceReader.nextRecord(memoryAddress,operation); count--) {
+					if(sampling && !sampleReference(geometry,memoryAddress)) continue;
+					HitMiss status = simulationStep<POLICY>(geometry,memoryAddress,operation,statistics);
+					if(WARMING) continue;
+					if(printSteps) printSimulationStep(memoryAddress,status);
+					if(status == HIT) statistics.hits++;
+					if(sampling) setHits[geometry.setNumber(geometry.blockNumber(memoryAddress))] += (status == HIT);
+					referencedBlocks.add(geometry.blockNumber(memoryAddress));
+					if(recording && intervals->record(geometry.blockNumber(memoryAddress))) {
+						intervals->endInterval(statistics,countValidBlocks());
+					}
+				}
+				return;
+			}
+			while(count > 0 && (chunkSize = traceReader.readChunk(chunk.data(),(int)min(count,(int64_t)TRACE_CHUNK_SIZE))) > 0) {
+				count -= chunkSize;
+				// For each memory reference item in the chunk
+				for(int i = 0; i < chunkSize; i++) {
+					if(sampling && !sampleReference(geometry,chunk[i].memoryAddress)) continue;
+					// Run the simulation one step
+					HitMiss status = simulationStep<POLICY>(geometry,chunk[i].memoryAddress,chunk[i].operation,
+															statistics);
+					if(WARMING) continue;
+					// Print the result of the current simulation step
+					if(printSteps) printSimulationStep(chunk[i].memoryAddress,status);
+					if(status == HIT) statistics.hits++;	// If the operation is a hit, count it
+					if(sampling) {
+						setHits[geometry.setNumber(geometry.blockNumber(chunk[i].memoryAddress))] += (status == HIT);
+					}
+					referencedBlocks.add(geometry.blockNumber(chunk[i].memoryAddress));
+					if(recording && intervals->record(geometry.blockNumber(chunk[i].memoryAddress))) {
+						intervals->endInterval(statistics,countValidBlocks());
+					}
+				}
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    accessGeometry
+Purpose:          Runs a batch of references with the kernel compiled for the
+                  cache's geometry, as replayTrace does for a trace
+Template params:  POLICY - ReplacementPolicy - the cache's replacement policy
+Input parameters: addresses - const uint64_t* - the memory addresses
+                  operations - const uint8_t* - the operations, or NULL
+                  count - size_t - the number of references
+                  results - uint8_t* - set to whether each reference hit,
+                                       or NULL
+                  statistics - SimulationStatistics& - the counts to update
+Return value:     size_t - the number of references that hit
+******************************************************************************/
+		template<ReplacementPolicy POLICY>
+		size_t accessGeometry(const uint64_t* addresses, const uint8_t* operations, size_t count, uint8_t* results,
+							  SimulationStatistics& statistics) {
+			if(index == XOR_INDEX) {
+				return accessKernel<POLICY>(XorGeometry(offsetBits,indexBits),addresses,operations,count,results,
+											statistics);
+			}
+			if(FixedGeometry<6,6,8>::matches(offsetBits,indexBits,associativity)) {
+				return accessKernel<POLICY>(FixedGeometry<6,6,8>(),addresses,operations,count,results,statistics);
+			}
+			if(FixedGeometry<6,5,8>::matches(offsetBits,indexBits,associativity)) {
+				return accessKernel<POLICY>(FixedGeometry<6,5,8>(),addresses,operations,count,results,statistics);
+			}
+			if(FixedGeometry<6,7,4>::matches(offsetBits,indexBits,associativity)) {
+				return accessKernel<POLICY>(FixedGeometry<6,7,4>(),addresses,operations,count,results,statistics);
+			}
+			if(FixedGeometry<6,6,4>::matches(offsetBits,indexBits,associativity)) {
+				return accessKernel<POLICY>(FixedGeometry<6,6,4>(),addresses,operations,count,results,statistics);
+			}
+			if(FixedGeometry<5,8,1>::matches(offsetBits,indexBits,associativity)) {
+				return accessKernel<POLICY>(FixedGeometry<5,8,1>(),addresses,operations,count,results,statistics);
+			}
+			if(FixedGeometry<5,7,2>::matches(offsetBits,indexBits,associativity)) {
+				return accessKernel<POLICY>(FixedGeometry<5,7,2>(),addresses,operations,count,results,statistics);
+			}
+			return accessKernel<POLICY>(RuntimeGeometry(offsetBits,indexBits),addresses,operations,count,results,
+										statistics);
+		}
+
+/*****************************************************************************
+Function name:    accessKernel
+Purpose:          Simulates a batch of references, counting the hits
+Template params:  POLICY - ReplacementPolicy - the cache's replacement policy
+                  Geometry - class - FixedGeometry, RuntimeGeometry or
+                                     XorGeometry type describing how
+                                     addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  addresses - const uint64_t* - the memory addresses
+                  operations - const uint8_t* - the operations, or NULL
+                  count - size_t - the number of references
+                  results - uint8_t* - set to whether each reference hit,
+                                       or NULL
+                  statistics - SimulationStatistics& - the counts to update
+Return value:     size_t - the number of references that hit
+******************************************************************************/
+		template<ReplacementPolicy POLICY, class Geometry>
+		size_t accessKernel(const Geometry& geometry, const uint64_t* addresses, const uint8_t* operations,
+							size_t count, uint8_t* results, SimulationStatistics& statistics) {
+			size_t hits = 0;
+			for(size_t i = 0; i < count; i++) {
+				ReadWrite operation = operations ? (ReadWrite)operations[i] : READ;
+				bool hit = (simulationStep<POLICY>(geometry,(int64_t)addresses[i],operation,statistics) == HIT);
+				hits += hit;
+				if(results) results[i] = hit;
+			}
+			statistics.references += count;
+			statistics.hits += hits;
+			return hits;
+		}
+
+/*****************************************************************************
+Function name:    simulationStep
+Purpose:          Runs the memory simulator one step, performing the given
+                  memory access operation
+Input parameters: memoryAddress - int64_t - the memory address being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  statistics - SimulationStatistics& - the memory traffic
+                                                       counts to update
+Return value:     HitMiss - whether the access results in a hit or a miss in
+                            the cache
+******************************************************************************/
+		HitMiss simulationStep(int64_t memoryAddress, ReadWrite operation, SimulationStatistics& statistics) {
+			if(index == XOR_INDEX) return policyStep(XorGeometry(offsetBits,indexBits),memoryAddress,operation,statistics);
+			return policyStep(RuntimeGeometry(offsetBits,indexBits),memoryAddress,operation,statistics);
+		}
+
+/*****************************************************************************
+Function name:    policyStep
+Purpose:          Runs the memory simulator one step with the simulation step
+                  compiled for the cache's replacement policy
+Template params:  Geometry - class - RuntimeGeometry or XorGeometry type
+                                     describing how addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  memoryAddress - int64_t - the memory address being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  statistics - SimulationStatistics& - the memory traffic
+                                                       counts to update
+Return value:     HitMiss - whether the access results in a hit or a miss in
+                            the cache
+******************************************************************************/
+		template<class Geometry>
+		HitMiss policyStep(const Geometry& geometry, int64_t memoryAddress, ReadWrite operation,
+						   SimulationStatistics& statistics) {
+			switch(cacheMemory.policy) {
+				case LRU: return simulationStep<LRU>(geometry,memoryAddress,operation,statistics);
+				case FIFO: return simulationStep<FIFO>(geometry,memoryAddress,operation,statistics);
+				case OPT: return simulationStep<OPT>(geometry,memoryAddress,operation,statistics);
+				case TREE_PLRU: return simulationStep<TREE_PLRU>(geometry,memoryAddress,operation,statistics);
+				case BIT_PLRU: return simulationStep<BIT_PLRU>(geometry,memoryAddress,operation,statistics);
+				case SRRIP: return simulationStep<SRRIP>(geometry,memoryAddress,operation,statistics);
+				case BRRIP: return simulationStep<BRRIP>(geometry,memoryAddress,operation,statistics);
+				case DRRIP: return simulationStep<DRRIP>(geometry,memoryAddress,operation,statistics);
+				case RANDOM: return simulationStep<RANDOM>(geometry,memoryAddress,operation,statistics);
+				default: return simulationStep<LFU>(geometry,memoryAddress,operation,statistics);
+			}
+		}
+
+/*****************************************************************************
+Function name:    simulationStep
+Purpose:          Runs the memory simulator one step with the address split
+                  and replacement policy fixed at compile time
+Template params:  POLICY - ReplacementPolicy - the cache's replacement policy
+                  Geometry - class - FixedGeometry or RuntimeGeometry type
+                                     describing how addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  memoryAddress - int64_t - the memory address being accessed
+                  operation - ReadWrite - whether the access is a read/write
+                  statistics - SimulationStatistics& - the memory traffic
+                                                       counts to update
+Return value:     HitMiss - whether the access results in a hit or a miss in
+                            the cache
+******************************************************************************/
+		template<ReplacementPolicy POLICY, class Geometry>
+		HitMiss simulationStep(const Geometry& geometry, int64_t memoryAddress, ReadWrite operation,
+							   SimulationStatistics& statistics) {
+			// Calculate the memory block and cache set the operation would access
+			int64_t memoryBlockNumber = geometry.blockNumber(memoryAddress);
+			int cacheSetNumber = geometry.setNumber(memoryBlockNumber);
+			// OPT is told when the block is next referenced, taken from the precomputed index
+			int64_t nextUse = (POLICY == OPT) ? nextUses[nextReference++] : 0;
+			CacheSet cacheSet(cacheMemory,cacheSetNumber);
+			// A write miss goes around the cache to memory without filling the block
+			bool allocate = (operation != WRITE || writeAllocation == WRITE_ALLOCATE);
+			if(operation == WRITE && writePolicy == WRITE_THROUGH) {
+				// A write-through write also goes to memory, leaving the cached copy clean
+				statistics.wordsWritten++;
+				operation = READ;
+			}
+			HitMiss status;
+			CacheBlock evicted;						// The block replaced on a miss, if any
+			if(!allocate) {
+				status = cacheSet.lookup<POLICY,Geometry::ASSOCIATIVITY>(geometry.tag(memoryBlockNumber),
+																		 operation,nextUse);
+				// A write to a block in the victim cache updates it there
+				if(status == MISS && victimCache
+				   && victimCache->update(memoryBlockNumber,operation == WRITE && writePolicy == WRITE_BACK)) {
+					statistics.victimHits++;
+					status = HIT;
+				}
+				else if(status == MISS && writePolicy == WRITE_BACK) statistics.wordsWritten++;
+			}
+			else {
+				// Perform the cache access operation, counting the block read and any dirty block
+				// written back on a miss
+				status = cacheSet.access<POLICY,Geometry::ASSOCIATIVITY>(geometry.tag(memoryBlockNumber),
+																		 operation,nextUse,&evicted);
+				if(status == MISS && victimCache) {
+					status = swapVictim(geometry,memoryBlockNumber,cacheSet,evicted,statistics);
+				}
+				else if(status == MISS) {
+					statistics.blocksRead++;
+					statistics.dirtyEvictions += evicted.dirtyBit;
+				}
+			}
+			// Let the prefetcher see the access and fill the blocks it predicts
+			if(prefetcher.type != NO_PREFETCHER) {
+				prefetchStep(geometry,memoryBlockNumber,status,allocate,evicted,statistics);
+			}
+			if(classifier) classifier->record(memoryBlockNumber,cacheSetNumber,status,statistics);
+			return status;
+		}
+
+/*****************************************************************************
+Function name:    swapVictim
+Purpose:          Completes a miss with a victim cache behind the cache: a
+                  block found in the victim cache moves back into the cache
+                  in place of the block read from memory, and the block the
+                  miss replaced moves into the victim cache, so only the
+                  block it pushes out leaves the cache
+Template params:  Geometry - class - FixedGeometry, RuntimeGeometry or
+                                     XorGeometry type describing how
+                                     addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  memoryBlockNumber - int64_t - the block that missed
+                  cacheSet - CacheSet& - the set it was filled into
+                  evicted - const CacheBlock& - the block the fill replaced
+                  statistics - SimulationStatistics& - the counts to update
+Return value:     HitMiss - HIT if the victim cache held the block, or MISS
+******************************************************************************/
+		template<class Geometry>
+		HitMiss swapVictim(const Geometry& geometry, int64_t memoryBlockNumber, CacheSet& cacheSet,
+						   const CacheBlock& evicted, SimulationStatistics& statistics) {
+			bool dirty;
+			HitMiss status = MISS;
+			if(victimCache->remove(memoryBlockNumber,dirty)) {
+				if(dirty) cacheSet.markDirty(geometry.tag(memoryBlockNumber));
+				statistics.victimHits++;
+				status = HIT;
+			}
+			else statistics.blocksRead++;
+			int64_t pushedBlock;
+			bool pushedDirty;
+			if(evicted.validBit && victimCache->insert(geometry.memoryBlock(evicted.tag,geometry.setNumber(memoryBlockNumber)),
+													  evicted.dirtyBit,pushedBlock,pushedDirty)) {
+				statistics.dirtyEvictions += pushedDirty;
+			}
+			return status;
+		}
+
+/*****************************************************************************
+Function name:    prefetchStep
+Purpose:          Runs the prefetcher after a demand access: accounts for the
+                  access's use of prefetched blocks and the blocks it
+                  replaced, then fills every predicted block not already
+                  cached. Prefetches arrive the memory latency after they are
+                  issued, so a block used sooner is a late prefetch that
+                  stalls the access until it arrives
+Template params:  Geometry - class - FixedGeometry or RuntimeGeometry type
+                                     describing how addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  memoryBlockNumber - int64_t - the block accessed
+                  status - HitMiss - whether the access hit or missed
+                  allocate - bool - whether a miss filled the block
+                  evicted - const CacheBlock& - the block the access replaced
+                  statistics - SimulationStatistics& - the prefetch counts to
+                                                       update
+Return value:     none
+******************************************************************************/
+		template<class Geometry>
+		void prefetchStep(const Geometry& geometry, int64_t memoryBlockNumber, HitMiss status, bool allocate,
+						  const CacheBlock& evicted, SimulationStatistics& statistics) {
+			int cacheSetNumber = geometry.setNumber(memoryBlockNumber);
+			bool prefetchHit = false;				// Whether this is the first use of a prefetch
+			if(status == HIT) {
+				prefetchClock += hitLatency;
+				unordered_map<int64_t,int64_t>::iterator prefetched = prefetchedBlocks.find(memoryBlockNumber);
+				if(prefetched != prefetchedBlocks.end()) {
+					prefetchHit = true;
+					statistics.usefulPrefetches++;
+					if(prefetched->second > prefetchClock) {	// Still on its way from memory
+						statistics.latePrefetches++;
+						statistics.prefetchStallCycles += prefetched->second - prefetchClock;
+						prefetchClock = prefetched->second;
+					}
+					prefetchedBlocks.erase(prefetched);
+				}
+			}
+			else {
+				prefetchClock += missLatency + (allocate ? memoryLatency : 0);
+				// A miss on a block a prefetch replaced is caused by the prefetch
+				int64_t* victims = &pollutionVictims[(size_t)cacheSetNumber*associativity];
+				for(int i = 0; i < associativity; i++) {
+					if(victims[i] == memoryBlockNumber) {
+						statistics.pollutionMisses++;
+						victims[i] = -1;
+						break;
+					}
+				}
+				if(evicted.validBit && prefetchedBlocks.erase(geometry.memoryBlock(evicted.tag,cacheSetNumber))) {
+					statistics.unusedPrefetches++;
+				}
+			}
+			int64_t candidates[MAX_PREFETCH_DEGREE];
+			int numCandidates = prefetcher.predict(memoryBlockNumber,status,prefetchHit,candidates);
+			for(int i = 0; i < numCandidates; i++) {
+				int64_t block = candidates[i];
+				if(block < 0 || block >= memoryBlocks) continue;	// Past either end of memory
+				int setNumber = geometry.setNumber(block);
+				CacheSet cacheSet(cacheMemory,setNumber);
+				if(cacheSet.find(geometry.tag(block)) != -1) continue;
+				CacheBlock replaced = cacheSet.fill(geometry.tag(block),false);
+				statistics.prefetches++;
+				prefetchedBlocks[block] = prefetchClock + memoryLatency;
+				if(!replaced.validBit) continue;
+				int64_t replacedBlock = geometry.memoryBlock(replaced.tag,setNumber);
+				statistics.dirtyEvictions += replaced.dirtyBit;
+				if(prefetchedBlocks.erase(replacedBlock)) statistics.unusedPrefetches++;
+				else {								// Remember the demand block it pushed out
+					pollutionVictims[(size_t)setNumber*associativity + victimCursors[setNumber]] = replacedBlock;
+					victimCursors[setNumber] = (victimCursors[setNumber] + 1) % associativity;
+				}
+			}
+			return;
+		}
+		
+/*****************************************************************************
+Function name:    simulatePartition
+Purpose:          Worker thread of the parallel simulation, simulating every
+                  batch of references handed to it until its queue closes
+Template params:  POLICY - ReplacementPolicy - the cache's replacement policy
+Input parameters: queue - ReferenceQueue* - the worker's queue of references
+                  workerStatistics - SimulationStatistics* - set to the hit
+                                     and traffic counts of the batches
+Return value:     none
+******************************************************************************/
+		template<ReplacementPolicy POLICY>
+		void simulatePartition(ReferenceQueue* queue, SimulationStatistics* workerStatistics) {
+			RuntimeGeometry geometry(offsetBits,indexBits);
+			vector<MemoryReference> batch;
+			SimulationStatistics statistics;			// Counted locally, written once at the end
+			while(queue->pop(batch)) {
+				for(unsigned int i = 0; i < batch.size(); i++) {
+					if(simulationStep<POLICY>(geometry,batch[i].memoryAddress,batch[i].operation,
+											  statistics) == HIT) statistics.hits++;
+				}
+				batch.clear();
+			}
+			*workerStatistics = statistics;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    buildNextUses
+Purpose:          Builds the next use index OPT replaces blocks by: for every
+                  reference, the number of the next reference to the same
+                  memory block, or NEVER_REFERENCED. The block numbers are
+                  read forwards into the index, which is then filled in by
+                  one backward pass remembering the latest reference to each
+                  block seen so far
+Input parameters: traceReader - TraceReader& - the trace to index
+Return value:     none
+******************************************************************************/
+		void buildNextUses(TraceReader& traceReader) {
+			nextUses.clear();
+			if(sampledSets.empty()) nextUses.reserve(traceReader.getNumReferences());
+			vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+			int64_t reference;						// The number of the current reference
+			int chunkSize;
+			traceReader.rewind();
+			while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+				for(int i = 0; i < chunkSize; i++) {
+					int64_t memoryBlockNumber = chunk[i].memoryAddress >> offsetBits;
+					// When sampling, only the sampled sets' references are numbered
+					if(sampledSets.empty() || sampledSets[cacheSetOf(memoryBlockNumber)]) {
+						nextUses.push_back(memoryBlockNumber);
+					}
+				}
+			}
+			unordered_map<int64_t,int64_t> laterReference;	// Earliest reference after the current one
+			for(reference = (int64_t)nextUses.size() - 1; reference >= 0; reference--) {
+				int64_t memoryBlockNumber = nextUses[reference];
+				unordered_map<int64_t,int64_t>::iterator later = laterReference.find(memoryBlockNumber);
+				if(later == laterReference.end()) {	// Not referenced again
+					nextUses[reference] = NEVER_REFERENCED;
+					laterReference[memoryBlockNumber] = reference;
+				}
+				else {
+					nextUses[reference] = later->second;
+					later->second = reference;
+				}
+			}
+			nextReference = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    sampleReference
+Purpose:          Decides whether a reference falls in a sampled set,
+                  counting it if so
+Template params:  Geometry - class - FixedGeometry or RuntimeGeometry type
+                                     describing how addresses are split
+Input parameters: geometry - const Geometry& - the cache's geometry
+                  memoryAddress - int64_t - the memory address referenced
+Return value:     bool - true if the reference is to be simulated
+******************************************************************************/
+		template<class Geometry>
+		bool sampleReference(const Geometry& geometry, int64_t memoryAddress) {
+			int cacheSetNumber = geometry.setNumber(geometry.blockNumber(memoryAddress));
+			if(!sampledSets[cacheSetNumber]) return false;
+			setReferences[cacheSetNumber]++;
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    estimateFromSample
+Purpose:          Scales the counts of a set sampled simulation up to the
+                  whole trace and estimates the error of its hit rate from
+                  how much the sampled sets' misses differ. Misses are
+                  scaled up by the share of sets sampled rather than the
+                  hit rate taken from the sampled references, since a few
+                  very popular blocks can skew the references to a set but
+                  nearly always hit
+Input parameters: statistics - SimulationStatistics& - the sampled counts,
+                                                       scaled in place
+                  referencedBlocks - BlockCounter& - the distinct blocks of
+                                                     the sampled references
+Return value:     none
+******************************************************************************/
+		void estimateFromSample(SimulationStatistics& statistics, BlockCounter& referencedBlocks) {
+			int64_t sampled = 0;
+			vector<int64_t> sampledMisses;			// The misses of each sampled set
+			for(int set = 0; set < cacheSets; set++) {
+				if(!sampledSets[set]) continue;
+				sampled += setReferences[set];
+				sampledMisses.push_back(setReferences[set] - setHits[set]);
+			}
+			statistics.sampledReferences = sampled;
+			statistics.hitRateError = sampleError(sampledMisses,cacheSets,statistics.references);
+			// Every other set is assumed to miss as often as the sampled sets do
+			double scale = (double)cacheSets/sampledMisses.size();
+			statistics.hits = statistics.references - min((int64_t)llround((sampled - statistics.hits)*scale),
+														  statistics.references);
+			statistics.compulsoryBoundHits = statistics.references
+											 - min((int64_t)llround(referencedBlocks.getDistinctBlocks()*scale),
+												   statistics.references);
+			statistics.blocksRead = (int64_t)llround(statistics.blocksRead*scale);
+			statistics.dirtyEvictions = (int64_t)llround(statistics.dirtyEvictions*scale);
+			statistics.wordsWritten = (int64_t)llround(statistics.wordsWritten*scale);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    calculateCompulsoryBound
+Purpose:          Calculates and returns the hit count of a sequence of memory
+                  references if only compulsory misses occurred. No cache of
+                  limited size reaches it in general; OPT's hit count is the
+                  best achievable
+Input parameters: numReferences - int64_t - the number of references
+                  referencedBlocks - BlockCounter& - the distinct memory
+                                                     blocks referenced
+Return value:     int64_t - the compulsory-miss bound of the sequence
+******************************************************************************/
+		int64_t calculateCompulsoryBound(int64_t numReferences, BlockCounter& referencedBlocks) {
+			// The first access to each memory block must always be a miss, and every other
+			// access could at most be a hit
+			return numReferences - referencedBlocks.getDistinctBlocks();
+		}
+
+/*****************************************************************************
+Function name:    countValidBlocks
+Purpose:          Counts the cache blocks holding valid data
+Input parameters: none
+Return value:     int - the number of valid blocks
+******************************************************************************/
+		int countValidBlocks() {
+			int validBlocks = 0;
+			for(int i = 0; i < (cacheBlocks + 63)/64; i++) validBlocks += __builtin_popcountll(cacheMemory.validBits[i]);
+			return validBlocks;
+		}
+
+/*****************************************************************************
+Function name:    describeCheckpoint
+Purpose:          Fills in the header fields of a checkpoint of this cache
+Input parameters: fields - int64_t* - the CHECKPOINT_FIELDS fields to fill in
+                  position - int64_t - the next reference of the trace
+                  firstCounted - int64_t - the first reference counted
+Return value:     none
+******************************************************************************/
+		void describeCheckpoint(int64_t* fields, int64_t position, int64_t firstCounted) {
+			int64_t values[CHECKPOINT_FIELDS] = {memoryBlocks*cacheBlockSize,cacheSize,cacheBlockSize,associativity,
+												 cacheMemory.policy,writePolicy,writeAllocation,index,
+												 (int64_t)sizeof(SimulationStatistics),(int64_t)cacheMemory.getSize(),
+												 position,firstCounted};
+			copy(values,values + CHECKPOINT_FIELDS,fields);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    saveCheckpoint
+Purpose:          Writes a checkpoint of the cache state, the statistics and
+                  the distinct blocks referenced at a point in the trace
+Input parameters: output - ostream& - the checkpoint file
+                  statistics - const SimulationStatistics& - the counts so far
+                  referencedBlocks - const BlockCounter& - the distinct
+                                     blocks the counted references used
+                  position - int64_t - the next reference of the trace
+Return value:     none
+******************************************************************************/
+		void saveCheckpoint(ostream& output, const SimulationStatistics& statistics,
+							const BlockCounter& referencedBlocks, int64_t position) {
+			int64_t fields[CHECKPOINT_FIELDS];
+			describeCheckpoint(fields,position,countedReference);
+			output.write(CHECKPOINT_MAGIC,sizeof(CHECKPOINT_MAGIC));
+			output.write((const char*)&CHECKPOINT_VERSION,sizeof(CHECKPOINT_VERSION));
+			output.write((const char*)fields,sizeof(fields));
+			output.write((const char*)&statistics,sizeof(statistics));
+			cacheMemory.save(output);
+			referencedBlocks.save(output);
+			output.flush();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    cacheSetOf
+Purpose:          Calculates the cache set a memory block is placed in
+Input parameters: memoryBlockNumber - int64_t - the memory block
+Return value:     int - the number of its cache set
+******************************************************************************/
+		int cacheSetOf(int64_t memoryBlockNumber) {
+			if(index == XOR_INDEX) return XorGeometry(offsetBits,indexBits).setNumber(memoryBlockNumber);
+			return RuntimeGeometry(offsetBits,indexBits).setNumber(memoryBlockNumber);
+		}
+
+/*****************************************************************************
+Function name:    cachedBlock
+Purpose:          Calculates the memory block a cache block holds from its
+                  tag and the set it is in
+Input parameters: tag - int64_t - the cache block's tag
+                  cacheSetNumber - int - the cache block's set
+Return value:     int64_t - the number of the memory block
+******************************************************************************/
+		int64_t cachedBlock(int64_t tag, int cacheSetNumber) {
+			if(index == XOR_INDEX) return XorGeometry(offsetBits,indexBits).memoryBlock(tag,cacheSetNumber);
+			return RuntimeGeometry(offsetBits,indexBits).memoryBlock(tag,cacheSetNumber);
+		}
+
+/*****************************************************************************
+Function name:    printCacheBlock
+Purpose:          Prints the contents of a single cache block
+Input parameters: cacheBlockNumber - int - the number of the block to print 
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printCacheBlock(int cacheBlockNumber) {
+			// Calculate the cache set and set offset of the specified block
+			int cacheSetNumber = cacheBlockNumber / associativity;
+			int cacheSetOffset = cacheBlockNumber % associativity;
+			// Get the specified cache block from the calculated cache set in the cache memory vector
+			CacheBlock cacheBlock = CacheSet(cacheMemory,cacheSetNumber).getCacheBlock(cacheSetOffset);
+			// The block holds the memory block whose tag and set number match its own
+			cacheBlock.data = cachedBlock(cacheBlock.tag,cacheSetNumber);
+			string tagString;						// Strings to store tag and data for printing
+			string dataString;
+			if(cacheBlock.validBit == 0) {			// If the cache block is considered invalid
+				tagString = string(tagBits,'x');	// Set the tag string to contain the same number of
+				dataString = "?";					// 'X's as there are tag bits. Also set data to '?'
+			} else {								// Otherwise
+				// Calculate the binary equivalent of the tag and format the data string
+				tagString = toBinary(cacheBlock.tag,tagBits);
+				dataString = "mm blk # " + to_string(cacheBlock.data);
+			}
+			// Print the parameterized contents of the cache block to the console
+			cout << setw(7) << cacheBlockNumber << setw(12) << cacheBlock.dirtyBit << setw(12)
+				 << cacheBlock.validBit << setw(15) << tagString << string(8,' ') << dataString << endl;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printSimulationStep
+Purpose:          Prints the a memory reference and its result (a single
+                  simulation step)
+Input parameters: memoryAddress - int64_t - the memory address being accessed
+                  status - HitMiss - the result of the memory access operation
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printSimulationStep(int64_t memoryAddress, HitMiss status) {
+			// Calculate the memory block and cache set the operation would access
+			int64_t memoryBlockNumber = memoryAddress / cacheBlockSize;
+			int cacheSetNumber = cacheSetOf(memoryBlockNumber);
+			// Generate string for cacheBlockNumber, since it could represent a range
+			string cacheBlockNumber;
+			// If the associativity is 1, there can only be one possible cache block number
+			if(associativity == 1) cacheBlockNumber = to_string(cacheSetNumber);
+			// If the associativity is 2, there is a binary choice of cache block number
+			else if(associativity == 2) cacheBlockNumber = to_string(cacheSetNumber*2)
+									+ " or " + to_string(cacheSetNumber*2 + 1);
+			// If the associativity is > 2, there is a consecutive range of possible cache block numbers
+			else cacheBlockNumber = to_string(cacheSetNumber*associativity)
+									+ " - " + to_string((cacheSetNumber+1)*associativity - 1);
+			// Convert the returned HitMiss status into a string
+			string statusString = (status == HIT) ? "hit" : "miss";
+			
+			// Print the result of the memory simulator step
+			// (ending with '\n' rather than endl, so the output is not flushed for every reference)
+			cout << setw(11) << memoryAddress << setw(17) << memoryBlockNumber << setw(12) << cacheSetNumber 
+				 << setw(15) << cacheBlockNumber << setw(10) << statusString << '\n';
+			return;
+		}
+
+/*****************************************************************************
+Function name:    toBinary
+Purpose:          Converts an integer to a binary number in the specified
+                  number of bits
+Input parameters: value - int64_t - the number to convert to binary
+                  numberOfBits - int - the desired number of bits to output 
+Return value:     string - the binary representation of the input value
+******************************************************************************/
+		string toBinary(int64_t value, int numberOfBits) {
+			string binary = "";						// Create an empty string
+			for(int i = 0; i < numberOfBits; i++) {	// For every desired bit
+				int currentBit = (value >> i) % 2;	// Calculate the bit at the current bit offset
+				// Convert the bit to a string and append it to the front of the string
+				binary = to_string(currentBit) + binary;
+			}
+			return binary;							// Return the string
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       SkewedCache
+Purpose:          The blocks of a skewed-associative cache: each way is a bank
+                  of rows indexed by its own hash of the block number, so
+                  blocks that share a row in one way are spread over
+                  different rows in the others. A zcache walks further for
+                  its replacement candidates: the blocks in a block's rows
+                  could move to their rows in the other ways, and the blocks
+                  there could move on, so replacing the oldest of all of them
+                  relocates each block on the path up by one step. A walk of
+                  one level is a plain skewed cache. Replacement is LRU or
+                  FIFO, which compare candidates by their last use or fill
+******************************************************************************/
+class SkewedCache {
+	public:
+		int64_t relocations;						// Blocks moved to make room for a fill
+
+/*****************************************************************************
+Function name:    SkewedCache (constructor)
+Purpose:          Creates an empty skewed cache
+Input parameters: rows - int - the rows of each way, a power of two
+                  associativity - int - the number of ways
+                  policy - ReplacementPolicy - LRU or FIFO
+                  walkLevels - int - the levels of candidates searched on a
+                                     fill, 1 for a skewed cache
+Return value:     none
+******************************************************************************/
+		SkewedCache(int rows, int associativity, ReplacementPolicy policy, int walkLevels)
+			: blocks((size_t)rows*associativity,-1), dirtyBits((size_t)rows*associativity,0),
+			  lastUses((size_t)rows*associativity,0) {
+			this->rows = rows;
+			this->associativity = associativity;
+			this->policy = policy;
+			this->walkLevels = walkLevels;
+			rowMask = rows - 1;
+			clock = 0;
+			relocations = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    lookup
+Purpose:          Searches every way for a memory block, updating its last
+                  use (and dirty bit on a write) if it is found
+Input parameters: memoryBlockNumber - int64_t - the memory block to find
+                  operation - ReadWrite - whether the access is a read/write
+Return value:     HitMiss - whether the block was found
+******************************************************************************/
+		HitMiss lookup(int64_t memoryBlockNumber, ReadWrite operation) {
+			int slot = findSlot(memoryBlockNumber);
+			if(slot == -1) return MISS;
+			if(operation == WRITE) dirtyBits[slot] = 1;
+			if(policy == LRU) lastUses[slot] = ++clock;
+			return HIT;
+		}
+
+/*****************************************************************************
+Function name:    fill
+Purpose:          Fills a memory block that is not in the cache into an empty
+                  candidate slot if there is one, or else in place of the
+                  oldest candidate, relocating the blocks on its path
+Input parameters: memoryBlockNumber - int64_t - the memory block to fill
+                  dirty - bool - whether the filled block is dirty
+                  evictedBlockNumber - int64_t& - set to the memory block
+                                                  that was replaced, if any
+Return value:     CacheBlock - the block that was replaced (its valid bit is
+                               0 if an empty slot was filled)
+******************************************************************************/
+		CacheBlock fill(int64_t memoryBlockNumber, bool dirty, int64_t& evictedBlockNumber) {
+			int candidates[MAX_ZCACHE_CANDIDATES];	// The slots searched, level by level
+			int parents[MAX_ZCACHE_CANDIDATES];		// The candidate whose block would move into each
+			int numCandidates = 0;
+			int chosen = -1;						// An empty candidate, or else the oldest
+			for(int way = 0; way < associativity && numCandidates < MAX_ZCACHE_CANDIDATES; way++) {
+				candidates[numCandidates] = slotOf(memoryBlockNumber,way);
+				parents[numCandidates++] = -1;
+			}
+			for(int level = 1, levelStart = 0; ; level++) {
+				int levelEnd = numCandidates;
+				for(int i = levelStart; i < levelEnd; i++) {
+					if(blocks[candidates[i]] == -1) {
+						chosen = i;
+						break;
+					}
+					if(chosen == -1 || lastUses[candidates[i]] < lastUses[candidates[chosen]]) chosen = i;
+				}
+				if(blocks[candidates[chosen]] == -1 || level == walkLevels) break;
+				// The next level holds the other slots the blocks of this level could move to, less
+				// any slot already on the path, which would move a block twice
+				for(int i = levelStart; i < levelEnd; i++) {
+					int64_t block = blocks[candidates[i]];
+					int way = candidates[i]/rows;
+					for(int other = 0; other < associativity && numCandidates < MAX_ZCACHE_CANDIDATES; other++) {
+						int slot = slotOf(block,other);
+						int onPath = (other == way) ? i : parents[i];
+						while(onPath != -1 && candidates[onPath] != slot) onPath = parents[onPath];
+						if(other == way || onPath != -1) continue;
+						candidates[numCandidates] = slot;
+						parents[numCandidates++] = i;
+					}
+				}
+				levelStart = levelEnd;
+			}
+			CacheBlock evicted;
+			int slot = candidates[chosen];
+			if(blocks[slot] != -1) {
+				evicted.validBit = 1;
+				evicted.dirtyBit = dirtyBits[slot];
+				evictedBlockNumber = blocks[slot];
+			}
+			// Move each block on the path into the slot freed below it
+			for(; parents[chosen] != -1; chosen = parents[chosen]) {
+				int from = candidates[parents[chosen]];
+				blocks[slot] = blocks[from];
+				dirtyBits[slot] = dirtyBits[from];
+				lastUses[slot] = lastUses[from];
+				slot = from;
+				relocations++;
+			}
+			blocks[slot] = memoryBlockNumber;
+			dirtyBits[slot] = dirty;
+			lastUses[slot] = ++clock;
+			return evicted;
+		}
+
+/*****************************************************************************
+Function name:    invalidate
+Purpose:          Removes a memory block from the cache if it is there
+Input parameters: memoryBlockNumber - int64_t - the memory block to remove
+                  dirty - bool& - set to whether the removed block was dirty
+Return value:     bool - true if the block was in the cache, false if not
+******************************************************************************/
+		bool invalidate(int64_t memoryBlockNumber, bool& dirty) {
+			int slot = findSlot(memoryBlockNumber);
+			if(slot == -1) return false;
+			dirty = dirtyBits[slot];
+			blocks[slot] = -1;
+			return true;
+		}
+	private:
+		vector<int64_t> blocks;						// The block in each slot, or -1 if empty, with
+													// the rows of each way together
+		vector<char> dirtyBits;						// Whether each slot's block is dirty
+		vector<uint64_t> lastUses;					// When each slot was last filled (or used, LRU)
+		int rows;									// The number of rows of each way
+		int rowMask;								// Selects a row from a hash
+		int associativity;							// The number of ways
+		ReplacementPolicy policy;					// LRU or FIFO
+		int walkLevels;								// The levels of candidates searched on a fill
+		uint64_t clock;								// Counts the fills and uses
+
+/*****************************************************************************
+Function name:    slotOf
+Purpose:          Calculates the slot a memory block may use in one way, from
+                  a splitmix64 hash of the block number salted by the way
+Input parameters: memoryBlockNumber - int64_t - the memory block
+                  way - int - the way
+Return value:     int - the slot, the way's first slot plus the row
+******************************************************************************/
+		int slotOf(int64_t memoryBlockNumber, int way) {
+			uint64_t value = (uint64_t)memoryBlockNumber*0x9E3779B97F4A7C15ULL + (uint64_t)(way + 1)*0xBF58476D1CE4E5B9ULL;
+			value = (value ^ (value >> 30))*0xBF58476D1CE4E5B9ULL;
+			value = (value ^ (value >> 27))*0x94D049BB133111EBULL;
+			return way*rows + (int)((value ^ (value >> 31)) & rowMask);
+		}
+
+/*****************************************************************************
+Function name:    findSlot
+Purpose:          Finds the slot holding a memory block
+Input parameters: memoryBlockNumber - int64_t - the memory block to find
+Return value:     int - the slot, or -1 if the block is not in the cache
+******************************************************************************/
+		int findSlot(int64_t memoryBlockNumber) {
+			for(int way = 0; way < associativity; way++) {
+				int slot = slotOf(memoryBlockNumber,way);
+				if(blocks[slot] == memoryBlockNumber) return slot;
+			}
+			return -1;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CacheLevel
+Purpose:          Models one cache of a cache hierarchy, which is addressed
+                  by memory block number so that a block missing in one level
+                  is passed to the next without splitting its address again
+******************************************************************************/
+class CacheLevel {
+	public:
+		string name;								// The name of the level, for example "L2"
+		int cacheSize;								// The size of the cache in bytes
+		int associativity;							// The number of cache blocks per set
+		ReplacementPolicy policy;					// The cache's replacement policy
+		InclusionPolicy inclusion;					// How the level relates to the levels above
+		WritePolicy writePolicy;					// Whether writes are written back or through
+		WriteAllocation writeAllocation;			// Whether write misses fill the block
+		int hitLatency;								// Cycles taken by a hit in the level
+		int missLatency;							// Cycles taken to detect a miss in the level
+		int64_t accesses;							// The number of blocks searched for
+		int64_t hits;								// The number of blocks found
+		int64_t dirtyEvictions;						// Dirty blocks written back to the level below
+		int64_t backInvalidations;					// Blocks removed above when this level evicted
+		IndexFunction index;						// Where a block may be placed in the level
+		int64_t victimHits;							// Blocks found in the victim cache, if any
+
+/*****************************************************************************
+Function name:    CacheLevel (constructor)
+Purpose:          Creates an empty write-back, write-allocate level of a cache
+                  hierarchy taking 1 cycle to hit or miss
+Input parameters: name - string - the name of the level
+                  cacheSize - int - the size of the cache in bytes
+                  cacheBlockSize - int - the size of the cache blocks in bytes
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - the cache's replacement policy
+                  inclusion - InclusionPolicy - how the level relates to the
+                                                levels above it
+Return value:     none
+******************************************************************************/
+		CacheLevel(string name, int cacheSize, int cacheBlockSize, int associativity,
+				   ReplacementPolicy policy, InclusionPolicy inclusion)
+			: cacheMemory(cacheSize/cacheBlockSize/associativity,associativity,policy) {
+			this->name = name;
+			this->cacheSize = cacheSize;
+			this->associativity = associativity;
+			this->policy = policy;
+			this->inclusion = inclusion;
+			writePolicy = WRITE_BACK;
+			writeAllocation = WRITE_ALLOCATE;
+			hitLatency = missLatency = 1;
+			indexBits = log2(cacheSize/cacheBlockSize/associativity);
+			setMask = ((int64_t)1 << indexBits) - 1;
+			accesses = hits = dirtyEvictions = backInvalidations = 0;
+			index = MODULO_INDEX;
+			victimHits = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    setOrganization
+Purpose:          Sets where blocks may be placed in the level: a set chosen
+                  by the low block number bits (MODULO) or by them XORed with
+                  the bits above (XOR), or a row of each way chosen by the
+                  way's own hash (SKEWED), searched further by relocating
+                  blocks (ZCACHE). A victim cache of the blocks just replaced
+                  may sit behind the level, and a block found there swaps
+                  with the block the level replaces for it
+Input parameters: index - IndexFunction - how blocks are placed
+                  victimEntries - int - the victim cache's blocks, 0 for none
+Return value:     none
+******************************************************************************/
+		void setOrganization(IndexFunction index, int victimEntries) {
+			this->index = index;
+			skewedCache.reset();
+			if(index == SKEWED_INDEX || index == ZCACHE_INDEX) {
+				skewedCache.reset(new SkewedCache((int)(setMask + 1),associativity,policy,
+												  (index == ZCACHE_INDEX) ? ZCACHE_WALK_LEVELS : 1));
+			}
+			victimCache.reset(victimEntries > 0 ? new VictimCache(victimEntries) : NULL);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getVictimEntries
+Purpose:          Gets the number of blocks in the level's victim cache
+Input parameters: none
+Return value:     int - the victim cache's blocks, or 0 if it has none
+******************************************************************************/
+		int getVictimEntries() {
+			return victimCache ? victimCache->getEntries() : 0;
+		}
+
+/*****************************************************************************
+Function name:    getRelocations
+Purpose:          Gets the number of blocks a zcache level moved to make room
+                  for the blocks filled into it
+Input parameters: none
+Return value:     int64_t - the number of relocations
+******************************************************************************/
+		int64_t getRelocations() {
+			return skewedCache ? skewedCache->relocations : 0;
+		}
+
+/*****************************************************************************
+Function name:    lookup
+Purpose:          Searches the level for a memory block, updating the block's
+                  priority (and dirty bit on a write) if it is found. A block
+                  found in the victim cache moves back into the level
+Input parameters: memoryBlockNumber - int64_t - the memory block to find
+                  operation - ReadWrite - whether the access is a read/write
+Return value:     HitMiss - whether the block was found
+******************************************************************************/
+		HitMiss lookup(int64_t memoryBlockNumber, ReadWrite operation) {
+			HitMiss status;
+			if(skewedCache) status = skewedCache->lookup(memoryBlockNumber,operation);
+			else status = CacheSet(cacheMemory,setOf(memoryBlockNumber)).lookup(memoryBlockNumber >> indexBits,operation);
+			bool dirty;
+			if(status == HIT || !victimCache || !victimCache->remove(memoryBlockNumber,dirty)) return status;
+			victimHits++;
+			// The block replaced takes the victim cache entry just freed, so none is pushed out
+			int64_t evictedBlockNumber, pushedBlockNumber;
+			bool pushedDirty;
+			CacheBlock evicted = fillLevel(memoryBlockNumber,dirty || operation == WRITE,evictedBlockNumber);
+			if(evicted.validBit) {
+				victimCache->insert(evictedBlockNumber,evicted.dirtyBit,pushedBlockNumber,pushedDirty);
+			}
+			return HIT;
+		}
+
+/*****************************************************************************
+Function name:    fill
+Purpose:          Fills a memory block that is not in the level, replacing
+                  the block chosen by the level's replacement policy
+Input parameters: memoryBlockNumber - int64_t - the memory block to fill
+                  dirty - bool - whether the filled block is dirty
+                  evictedBlockNumber - int64_t& - set to the memory block
+                                                  that was replaced, if any
+Return value:     CacheBlock - the block that was replaced (its valid bit is
+                               0 if an empty block was filled)
+******************************************************************************/
+		CacheBlock fill(int64_t memoryBlockNumber, bool dirty, int64_t& evictedBlockNumber) {
+			CacheBlock evicted = fillLevel(memoryBlockNumber,dirty,evictedBlockNumber);
+			if(!victimCache || !evicted.validBit) return evicted;
+			// The replaced block moves into the victim cache, and only a block it pushes out leaves
+			bool pushedDirty;
+			evicted.validBit = victimCache->insert(evictedBlockNumber,evicted.dirtyBit,evictedBlockNumber,pushedDirty);
+			evicted.dirtyBit = pushedDirty;
+			return evicted;
+		}
+
+/*****************************************************************************
+Function name:    invalidate
+Purpose:          Removes a memory block from the level if it is there
+Input parameters: memoryBlockNumber - int64_t - the memory block to remove
+                  dirty - bool& - set to whether the removed block was dirty
+Return value:     bool - true if the block was in the level, false if not
+******************************************************************************/
+		bool invalidate(int64_t memoryBlockNumber, bool& dirty) {
+			bool found;
+			if(skewedCache) found = skewedCache->invalidate(memoryBlockNumber,dirty);
+			else found = CacheSet(cacheMemory,setOf(memoryBlockNumber)).invalidate(memoryBlockNumber >> indexBits,dirty);
+			return found || (victimCache && victimCache->remove(memoryBlockNumber,dirty));
+		}
+	private:
+		CacheStorage cacheMemory;					// The state of every block of the level
+		int indexBits;								// The number of set index bits
+		int64_t setMask;							// Selects the set index of a block number
+		unique_ptr<SkewedCache> skewedCache;		// The blocks of a skewed or zcache level, which
+													// then does not use the cache memory
+		unique_ptr<VictimCache> victimCache;		// Holds the blocks just replaced, if set
+
+/*****************************************************************************
+Function name:    setOf
+Purpose:          Calculates the set a memory block is placed in
+Input parameters: memoryBlockNumber - int64_t - the memory block
+Return value:     int - the number of its set
+******************************************************************************/
+		int setOf(int64_t memoryBlockNumber) {
+			if(index == XOR_INDEX) return (int)((memoryBlockNumber ^ (memoryBlockNumber >> indexBits)) & setMask);
+			return (int)(memoryBlockNumber & setMask);
+		}
+
+/*****************************************************************************
+Function name:    fillLevel
+Purpose:          Fills a memory block into the level itself, leaving the
+                  victim cache alone
+Input parameters: memoryBlockNumber - int64_t - the memory block to fill
+                  dirty - bool - whether the filled block is dirty
+                  evictedBlockNumber - int64_t& - set to the memory block
+                                                  that was replaced, if any
+Return value:     CacheBlock - the block that was replaced (its valid bit is
+                               0 if an empty block was filled)
+******************************************************************************/
+		CacheBlock fillLevel(int64_t memoryBlockNumber, bool dirty, int64_t& evictedBlockNumber) {
+			if(skewedCache) return skewedCache->fill(memoryBlockNumber,dirty,evictedBlockNumber);
+			int setNumber = setOf(memoryBlockNumber);
+			CacheBlock evicted = CacheSet(cacheMemory,setNumber).fill(memoryBlockNumber >> indexBits,dirty);
+			// The tag is the same for both index functions, which differ only in the set
+			if(index == XOR_INDEX) evictedBlockNumber = evicted.tag << indexBits | ((setNumber ^ evicted.tag) & setMask);
+			else evictedBlockNumber = evicted.tag << indexBits | setNumber;
+			return evicted;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       AddressTranslator
+Purpose:          The virtual memory front end of a cache hierarchy: TLBs,
+                  each a cache level holding page numbers, in front of a
+                  radix page table. A reference missing in every TLB walks
+                  the page table from the root table down to the entry that
+                  maps its page, and the caller reads those entries through
+                  its data caches. Page table pages and mapped pages are
+                  given physical memory the first time they are touched, one
+                  after the other. TLBs of the same shape holding the page
+                  numbers of each larger page size run alongside, so the
+                  savings huge pages would bring can be estimated
+******************************************************************************/
+class AddressTranslator {
+	public:
+/*****************************************************************************
+Function name:    AddressTranslator (constructor)
+Purpose:          Creates a translator with no TLBs and nothing mapped
+Input parameters: pageSize - int - the index of the page size in
+                                   PAGE_SIZE_NAMES
+Return value:     none
+******************************************************************************/
+		AddressTranslator(int pageSize) {
+			this->pageSize = pageSize;
+			nextPhysicalAddress = 0;
+			tablePages = mappedPages = 0;
+			lastPageNumber = -1;
+			lastPageAddress = 0;
+			walks = walkReferences = walkCycles = lookupCycles = 0;
+			for(int size = 0; size < NUM_PAGE_SIZES; size++) hugeWalks[size] = hugeLookupCycles[size] = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    addTlb
+Purpose:          Adds a TLB below the current lowest one
+Input parameters: name - string - the name of the TLB
+                  entries - int - the number of page translations held
+                  associativity - int - the number of entries per set
+                  policy - ReplacementPolicy - the TLB's replacement policy
+Return value:     CacheLevel& - the new TLB, so its latencies can be set
+******************************************************************************/
+		CacheLevel& addTlb(string name, int entries, int associativity, ReplacementPolicy policy) {
+			tlbs.push_back(unique_ptr<CacheLevel>(new CacheLevel(name,entries,1,associativity,policy,NINE)));
+			for(int size = pageSize + 1; size < NUM_PAGE_SIZES; size++) {
+				hugeTlbs[size].push_back(unique_ptr<CacheLevel>(new CacheLevel(name,entries,1,associativity,
+																				policy,NINE)));
+			}
+			return *tlbs.back();
+		}
+
+/*****************************************************************************
+Function name:    translate
+Purpose:          Translates a virtual address, looking its page up in the
+                  TLBs and listing the page table entries to read if every
+                  TLB misses
+Input parameters: virtualAddress - int64_t - the address referenced
+                  physicalAddress - int64_t& - set to the physical address
+                  entryAddresses - int64_t* - set to the physical address of
+                                   each page table entry read, root first
+                                   (room for PAGE_TABLE_LEVELS is needed)
+                  cycles - int64_t& - the total cycles, to add the TLB
+                                      latencies to
+Return value:     int - the number of page table entries to read, 0 if a
+                        TLB held the translation
+******************************************************************************/
+		int translate(int64_t virtualAddress, int64_t& physicalAddress, int64_t* entryAddresses, int64_t& cycles) {
+			for(int size = pageSize + 1; size < NUM_PAGE_SIZES; size++) {
+				if(!lookup(hugeTlbs[size],virtualAddress >> PAGE_SIZE_BITS[size],hugeLookupCycles[size])) {
+					hugeWalks[size]++;
+				}
+			}
+			int pageBits = PAGE_SIZE_BITS[pageSize];
+			int64_t pageNumber = virtualAddress >> pageBits;
+			int64_t tlbCycles = 0;
+			bool found = lookup(tlbs,pageNumber,tlbCycles);
+			lookupCycles += tlbCycles;
+			cycles += tlbCycles;
+			if(pageNumber != lastPageNumber) {		// Consecutive references mostly share a page
+				lastPageNumber = pageNumber;
+				lastPageAddress = physicalPage(PAGE_TABLE_LEVELS,pageNumber,pageBits);
+			}
+			physicalAddress = lastPageAddress | (virtualAddress & (((int64_t)1 << pageBits) - 1));
+			if(found) return 0;
+			// Read one entry per level, from the root table down to the entry mapping the page
+			int depth = walkDepth(pageSize);
+			for(int level = 0; level < depth; level++) {
+				int indexShift = PAGE_SIZE_BITS[0] + PAGE_TABLE_INDEX_BITS*(PAGE_TABLE_LEVELS - 1 - level);
+				int64_t table = physicalPage(level,virtualAddress >> (indexShift + PAGE_TABLE_INDEX_BITS),
+											 PAGE_SIZE_BITS[0]);
+				int64_t index = (virtualAddress >> indexShift) & ((1 << PAGE_TABLE_INDEX_BITS) - 1);
+				entryAddresses[level] = table + index*PAGE_TABLE_ENTRY_SIZE;
+			}
+			walks++;
+			walkReferences += depth;
+			return depth;
+		}
+
+/*****************************************************************************
+Function name:    recordWalk
+Purpose:          Adds the cycles the data caches took to read the entries
+                  of a page walk
+Input parameters: cycles - int64_t - the cycles taken by the walk
+Return value:     none
+******************************************************************************/
+		void recordWalk(int64_t cycles) {
+			walkCycles += cycles;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printStatistics
+Purpose:          Prints the hit rate of every TLB, the page walks and the
+                  cycles spent translating, and estimates the cycles each
+                  larger page size would save. Walks with huge pages are
+                  assumed to cost the same per entry read as the walks
+                  simulated, and the data caches to behave the same
+Input parameters: references - int64_t - the references simulated
+                  totalCycles - int64_t - the cycles taken by every reference
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printStatistics(int64_t references, int64_t totalCycles) {
+			cout << "\nAddress translation with " << PAGE_SIZE_NAMES[pageSize] << " pages: " << mappedPages
+				 << " pages and " << tablePages << " page table pages touched, " << walkDepth(pageSize)
+				 << " entries read per walk" << endl;
+			cout << setw(6) << "TLB" << setw(10) << "entries" << setw(6) << "ways" << setw(10) << "policy"
+				 << setw(9) << "latency" << setw(13) << "accesses" << setw(13) << "hits" << setw(11) << "hit rate"
+				 << endl;
+			cout << string(78,'-') << endl;			// Print line to separate header from data
+			for(unsigned int level = 0; level < tlbs.size(); level++) {
+				CacheLevel& tlb = *tlbs[level];
+				cout << setw(6) << tlb.name << setw(10) << tlb.cacheSize << setw(6) << tlb.associativity
+					 << setw(10) << policyName(tlb.policy)
+					 << setw(9) << to_string(tlb.hitLatency) + "/" + to_string(tlb.missLatency)
+					 << setw(13) << tlb.accesses << setw(13) << tlb.hits
+					 << setw(10) << (tlb.accesses ? (float)tlb.hits/tlb.accesses*100 : 0.0f) << "%" << endl;
+			}
+			double entryCycles = walkReferences ? (double)walkCycles/walkReferences : 0;
+			int64_t translationCycles = lookupCycles + walkCycles;
+			cout << "\nPage walks = " << walks << " (" << (double)walks*1000/references << " per 1000 references), "
+				 << walkReferences << " page table entries read at " << entryCycles << " cycles each" << endl;
+			cout << "Translation cycles = " << lookupCycles << " in TLBs + " << walkCycles << " walking = "
+				 << (double)translationCycles/references << " cycles per reference ("
+				 << (double)translationCycles/totalCycles*100 << "% of all cycles)" << endl;
+			for(int size = pageSize + 1; size < NUM_PAGE_SIZES; size++) {
+				double hugeCycles = hugeLookupCycles[size] + hugeWalks[size]*walkDepth(size)*entryCycles;
+				cout << "With " << PAGE_SIZE_NAMES[size] << " pages: " << hugeWalks[size] << " page walks, about "
+					 << llround(hugeCycles) << " translation cycles, saving "
+					 << (translationCycles - hugeCycles)/totalCycles*100 << "% of all cycles" << endl;
+			}
+			return;
+		}
+	private:
+		int pageSize;								// The index of the page size
+		vector<unique_ptr<CacheLevel>> tlbs;		// The TLBs, first level first
+		vector<unique_ptr<CacheLevel>> hugeTlbs[NUM_PAGE_SIZES];	// TLBs of the same shape holding
+													// each larger page size
+		unordered_map<int64_t,int64_t> physicalPages;	// The physical address of every page table
+													// page and mapped page, by level and number
+		int64_t nextPhysicalAddress;				// The lowest physical address not yet given out
+		int64_t tablePages;							// The page table pages touched
+		int64_t mappedPages;						// The pages touched
+		int64_t lastPageNumber;						// The last page translated, or -1 if none
+		int64_t lastPageAddress;					// The physical address of the last page
+		int64_t walks;								// The page walks taken
+		int64_t walkReferences;						// The page table entries read
+		int64_t walkCycles;							// Cycles spent reading page table entries
+		int64_t lookupCycles;						// Cycles spent searching the TLBs
+		int64_t hugeWalks[NUM_PAGE_SIZES];			// The walks with each larger page size
+		int64_t hugeLookupCycles[NUM_PAGE_SIZES];	// The TLB cycles with each larger page size
+
+/*****************************************************************************
+Function name:    lookup
+Purpose:          Searches TLBs for a page number, from the first down,
+                  filling it into the TLBs it missed in
+Input parameters: levels - vector<unique_ptr<CacheLevel>>& - the TLBs
+                  pageNumber - int64_t - the page number to find
+                  cycles - int64_t& - the cycles to add the TLB latencies
+                                      to, those of the configured TLBs
+Return value:     bool - true if a TLB held the page number
+******************************************************************************/
+		bool lookup(vector<unique_ptr<CacheLevel>>& levels, int64_t pageNumber, int64_t& cycles) {
+			int numLevels = (int)levels.size();
+			int hitLevel = numLevels;
+			for(int level = 0; level < numLevels; level++) {
+				CacheLevel& tlb = *levels[level];
+				tlb.accesses++;
+				if(tlb.lookup(pageNumber,READ) == HIT) {
+					tlb.hits++;
+					cycles += tlbs[level]->hitLatency;
+					hitLevel = level;
+					break;
+				}
+				cycles += tlbs[level]->missLatency;
+			}
+			for(int level = hitLevel - 1; level >= 0; level--) {
+				int64_t evictedPageNumber;
+				levels[level]->fill(pageNumber,false,evictedPageNumber);
+			}
+			return hitLevel < numLevels;
+		}
+
+/*****************************************************************************
+Function name:    physicalPage
+Purpose:          Gets the physical address of a page table page or mapped
+                  page, giving it the next free, aligned physical memory the
+                  first time it is touched
+Input parameters: level - int - the page table level of a table page, or
+                                PAGE_TABLE_LEVELS for a mapped page
+                  number - int64_t - the virtual address bits above the
+                                     ones the page spans
+                  pageBits - int - the address bits the page spans
+Return value:     int64_t - the physical address of the page
+******************************************************************************/
+		int64_t physicalPage(int level, int64_t number, int pageBits) {
+			int64_t key = ((int64_t)level << 58) | number;	// Numbers are below 2^50
+			unordered_map<int64_t,int64_t>::iterator page = physicalPages.find(key);
+			if(page != physicalPages.end()) return page->second;
+			int64_t size = (int64_t)1 << pageBits;
+			int64_t address = (nextPhysicalAddress + size - 1) & ~(size - 1);
+			nextPhysicalAddress = address + size;
+			if(level < PAGE_TABLE_LEVELS) tablePages++;
+			else mappedPages++;
+			physicalPages[key] = address;
+			return address;
+		}
+
+/*****************************************************************************
+Function name:    walkDepth
+Purpose:          Gets the page table entries read to map a page size, one
+                  fewer for every level the page spans above a base page
+Input parameters: size - int - the index of the page size
+Return value:     int - the number of entries read by a walk
+******************************************************************************/
+		int walkDepth(int size) {
+			return PAGE_TABLE_LEVELS - (PAGE_SIZE_BITS[size] - PAGE_SIZE_BITS[0])/PAGE_TABLE_INDEX_BITS;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CacheHierarchy
+Purpose:          Simulates a hierarchy of caches (an optional L1 instruction
+                  cache beside the first data level, then any number of
+                  unified levels) sharing one block size. Each address is
+                  split into its block number once, and a block missing in a
+                  level is searched for in the next, then filled into the
+                  levels it missed in on the way back up. Each level below
+                  the first is inclusive (evicting a block removes it from
+                  every level above), exclusive (only holding blocks evicted
+                  from above, which move back up on a hit) or NINE. Every
+                  level has its own write policy and latencies, from which
+                  the memory traffic and average memory access time follow.
+                  With TLBs, addresses are virtual and are translated first,
+                  with the entries read by page walks going through the
+                  data levels like any other reference
+******************************************************************************/
+class CacheHierarchy {
+	public:
+/*****************************************************************************
+Function name:    CacheHierarchy (constructor)
+Purpose:          Creates a hierarchy with no levels
+Input parameters: cacheBlockSize - int - the block size of every level
+Return value:     none
+******************************************************************************/
+		CacheHierarchy(int cacheBlockSize) {
+			this->cacheBlockSize = cacheBlockSize;
+			offsetBits = log2(cacheBlockSize);
+			memoryLatency = 100;
+			references = cycles = memoryReads = memoryWrites = memoryWordWrites = walkReferences = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    addLevel
+Purpose:          Adds a unified (or the first data) level below the current
+                  lowest level
+Input parameters: name - string - the name of the level
+                  cacheSize - int - the size of the cache in bytes
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - the cache's replacement policy
+                  inclusion - InclusionPolicy - how the level relates to the
+                                                levels above it (ignored for
+                                                the first level)
+Return value:     CacheLevel& - the new level, so its write policy and
+                                latencies can be set
+******************************************************************************/
+		CacheLevel& addLevel(string name, int cacheSize, int associativity, ReplacementPolicy policy,
+							 InclusionPolicy inclusion) {
+			levels.push_back(unique_ptr<CacheLevel>(new CacheLevel(name,cacheSize,cacheBlockSize,
+																	associativity,policy,inclusion)));
+			return *levels.back();
+		}
+
+/*****************************************************************************
+Function name:    addInstructionCache
+Purpose:          Adds an L1 instruction cache beside the first level, which
+                  then only serves reads and writes
+Input parameters: name - string - the name of the level
+                  cacheSize - int - the size of the cache in bytes
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - the cache's replacement policy
+Return value:     CacheLevel& - the new level, so its latencies can be set
+******************************************************************************/
+		CacheLevel& addInstructionCache(string name, int cacheSize, int associativity, ReplacementPolicy policy) {
+			instructionCache.reset(new CacheLevel(name,cacheSize,cacheBlockSize,associativity,policy,NINE));
+			return *instructionCache;
+		}
+
+/*****************************************************************************
+Function name:    setMemoryLatency
+Purpose:          Sets the cycles taken to read a block from main memory
+Input parameters: memoryLatency - int - the memory latency in cycles
+Return value:     none
+******************************************************************************/
+		void setMemoryLatency(int memoryLatency) {
+			this->memoryLatency = memoryLatency;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Simulates one memory reference on the hierarchy, first
+                  translating its address if virtual memory is simulated
+Input parameters: memoryAddress - int64_t - the address being referenced
+                  operation - ReadWrite - a read, write or instruction fetch
+Return value:     none
+******************************************************************************/
+		void access(int64_t memoryAddress, ReadWrite operation) {
+			references++;
+			if(translator) memoryAddress = translate(memoryAddress);
+			accessBlock(memoryAddress >> offsetBits,operation);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    enableTranslation
+Purpose:          Treats every address as virtual, translating it through
+                  TLBs and a page table whose entries are read through the
+                  data caches
+Input parameters: pageSize - int - the index of the page size in
+                                   PAGE_SIZE_NAMES
+Return value:     AddressTranslator& - the translator, so TLBs can be added
+******************************************************************************/
+		AddressTranslator& enableTranslation(int pageSize) {
+			translator.reset(new AddressTranslator(pageSize));
+			return *translator;
+		}
+
+/*****************************************************************************
+Function name:    simulate
+Purpose:          Streams every reference of a trace through the hierarchy
+Input parameters: traceReader - TraceReader& - the validated trace to simulate
+Return value:     none
+******************************************************************************/
+		void simulate(TraceReader& traceReader) {
+			int64_t memoryAddress = 0;				// Always set by nextRecord, but GCC cannot
+			ReadWrite operation = READ;				// tell once it is inlined
+			traceReader.rewind();
+			if(traceReader.isBinary()) {			// Binary records decode straight into the hierarchy
+				while(traceReader.nextRecord(memoryAddress,operation)) access(memoryAddress,operation);
+				return;
+			}
+			vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+			int chunkSize;
+			while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+				for(int i = 0; i < chunkSize; i++) access(chunk[i].memoryAddress,chunk[i].operation);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printStatistics
+Purpose:          Prints the configuration and hit rate of every level, the
+                  traffic between the lowest level and main memory, and the
+                  average memory access time
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void printStatistics() {
+			cout << "Cache hierarchy simulation of " << references << " memory references, "
+				 << cacheBlockSize << " byte blocks" << endl;
+			cout << setw(6) << "level" << setw(10) << "cache" << setw(6) << "ways" << setw(10) << "policy"
+				 << setw(11) << "inclusion" << setw(8) << "write" << setw(9) << "latency"
+				 << setw(13) << "accesses" << setw(13) << "hits" << setw(11) << "hit rate"
+				 << setw(12) << "dirty evict" << setw(15) << "invalidations" << endl;
+			cout << string(124,'-') << endl;		// Print line to separate header from data
+			if(instructionCache) printLevel(*instructionCache,false);
+			for(unsigned int level = 0; level < levels.size(); level++) printLevel(*levels[level],level > 0);
+			if(instructionCache) printOrganization(*instructionCache);
+			for(unsigned int level = 0; level < levels.size(); level++) printOrganization(*levels[level]);
+			int64_t bytesRead = memoryReads*cacheBlockSize;
+			int64_t bytesWritten = memoryWrites*cacheBlockSize + memoryWordWrites*WRITE_WORD_SIZE;
+			cout << "\nMemory reads = " << memoryReads << " blocks, memory writes = " << memoryWrites
+				 << " blocks + " << memoryWordWrites << " words (latency " << memoryLatency << " cycles)" << endl;
+			cout << "Memory traffic = " << bytesRead << " bytes read + " << bytesWritten << " bytes written = "
+				 << (float)(bytesRead + bytesWritten)/references << " bytes per reference" << endl;
+			cout << "Average memory access time = " << (double)cycles/references << " cycles" << endl;
+			if(translator) {
+				cout << "(The level counts include the " << walkReferences << " page table entries read, "
+					 << "and the time the translations)" << endl;
+				translator->printStatistics(references,cycles);
+			}
+			return;
+		}
+	private:
+		int cacheBlockSize;							// The block size of every level in bytes
+		int offsetBits;								// The number of block offset bits
+		vector<unique_ptr<CacheLevel>> levels;		// The data / unified levels, L1 first
+		unique_ptr<CacheLevel> instructionCache;	// The L1 instruction cache, or empty if none
+		int memoryLatency;							// Cycles taken to read a block from memory
+		int64_t references;							// The number of references simulated
+		int64_t cycles;								// The total latency of every reference
+		int64_t memoryReads;						// Blocks read from main memory
+		int64_t memoryWrites;						// Dirty blocks written back to main memory
+		int64_t memoryWordWrites;					// Writes that reached memory without a block
+		unique_ptr<AddressTranslator> translator;	// Translates virtual addresses, if set
+		int64_t walkReferences;						// Page table entries read through the caches
+
+/*****************************************************************************
+Function name:    accessBlock
+Purpose:          Simulates one access to a memory block on the hierarchy,
+                  adding the latency of every level searched (and of memory
+                  if the block is read from it) to the total cycles
+Input parameters: memoryBlockNumber - int64_t - the block being accessed
+                  operation - ReadWrite - a read, write or instruction fetch
+Return value:     none
+******************************************************************************/
+		void accessBlock(int64_t memoryBlockNumber, ReadWrite operation) {
+			int numLevels = (int)levels.size();
+			bool writing = (operation == WRITE);
+			// Search down the hierarchy until a level holds the block. The write lands in the
+			// first level holding the block after the access, so a write-back level marks it
+			// dirty straight away if no level above it will be filled
+			int hitLevel = numLevels;
+			bool dirty = false;						// Whether a block moved up from below is dirty
+			bool filledAbove = false;				// Whether a level above will be filled
+			for(int level = 0; level < numLevels; level++) {
+				CacheLevel& cache = getLevel(level,operation);
+				cache.accesses++;
+				bool found;
+				if(level > 0 && cache.inclusion == EXCLUSIVE && filledAbove) {
+					// Exclusive levels give the block up to the level above
+					found = cache.invalidate(memoryBlockNumber,dirty);
+				}
+				else {
+					bool landsHere = writing && !filledAbove && cache.writePolicy == WRITE_BACK;
+					found = cache.lookup(memoryBlockNumber,landsHere ? WRITE : READ) == HIT;
+				}
+				if(found) {
+					cache.hits++;
+					cycles += cache.hitLatency;
+					hitLevel = level;
+					break;
+				}
+				cycles += cache.missLatency;
+				filledAbove = filledAbove || allocates(level,cache,writing);
+			}
+			// Find the highest level the block is filled into, which takes the written data
+			int topLevel = hitLevel;
+			for(int level = hitLevel - 1; level >= 0; level--) {
+				if(allocates(level,getLevel(level,operation),writing)) topLevel = level;
+			}
+			if(hitLevel == numLevels && topLevel < numLevels) {
+				memoryReads++;						// The block is read from memory
+				cycles += memoryLatency;
+			}
+			// Fill the block into the levels it missed in, from the bottom up, skipping the
+			// exclusive levels which only take blocks evicted from above
+			for(int level = hitLevel - 1; level >= 0; level--) {
+				CacheLevel& cache = getLevel(level,operation);
+				if(!allocates(level,cache,writing)) continue;
+				bool fillDirty = (level == topLevel)
+								 && (dirty || (writing && cache.writePolicy == WRITE_BACK));
+				fill(level,cache,memoryBlockNumber,fillDirty);
+			}
+			// A write that did not land in a write-back level carries on towards memory
+			if(writing && (topLevel == numLevels || getLevel(topLevel,operation).writePolicy == WRITE_THROUGH)) {
+				writeThrough(topLevel + 1,memoryBlockNumber);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    translate
+Purpose:          Translates a virtual address, reading the page table
+                  entries of any page walk through the data caches
+Input parameters: virtualAddress - int64_t - the address referenced
+Return value:     int64_t - the physical address
+******************************************************************************/
+		int64_t translate(int64_t virtualAddress) {
+			int64_t physicalAddress;
+			int64_t entryAddresses[PAGE_TABLE_LEVELS];
+			int walkLength = translator->translate(virtualAddress,physicalAddress,entryAddresses,cycles);
+			if(walkLength > 0) {
+				int64_t walkStart = cycles;
+				for(int i = 0; i < walkLength; i++) {
+					accessBlock(entryAddresses[i] >> offsetBits,READ);
+					walkReferences++;
+				}
+				translator->recordWalk(cycles - walkStart);
+			}
+			return physicalAddress;
+		}
+
+/*****************************************************************************
+Function name:    getLevel
+Purpose:          Gets the cache a reference uses at a depth of the hierarchy
+Input parameters: level - int - the depth of the level (0 for L1)
+                  operation - ReadWrite - the reference's operation, since
+                                          fetches use the instruction cache
+Return value:     CacheLevel& - the level
+******************************************************************************/
+		CacheLevel& getLevel(int level, ReadWrite operation) {
+			if(level == 0 && operation == FETCH && instructionCache) return *instructionCache;
+			return *levels[level];
+		}
+
+/*****************************************************************************
+Function name:    allocates
+Purpose:          Returns if a level takes a block that missed in it
+Input parameters: level - int - the depth of the level (0 for L1)
+                  cache - CacheLevel& - the level
+                  writing - bool - whether the reference is a write
+Return value:     bool - true if the block is filled into the level
+******************************************************************************/
+		bool allocates(int level, CacheLevel& cache, bool writing) {
+			if(level > 0 && cache.inclusion == EXCLUSIVE) return false;
+			return !writing || cache.writeAllocation == WRITE_ALLOCATE;
+		}
+
+/*****************************************************************************
+Function name:    writeThrough
+Purpose:          Passes a write on from a write-through level (or around the
+                  levels that did not allocate it) until it reaches a
+                  write-back level holding the block, or main memory.
+                  Written through data never fills a block
+Input parameters: level - int - the depth of the first level to try
+                  memoryBlockNumber - int64_t - the memory block written
+Return value:     none
+******************************************************************************/
+		void writeThrough(int level, int64_t memoryBlockNumber) {
+			for(; level < (int)levels.size(); level++) {
+				CacheLevel& cache = *levels[level];
+				if(cache.writePolicy == WRITE_BACK && cache.lookup(memoryBlockNumber,WRITE) == HIT) return;
+			}
+			memoryWordWrites++;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    fill
+Purpose:          Fills a block into a level, then passes the block it
+                  replaces on: removing it from the levels above if the level
+                  is inclusive, then handing it to the level below if that
+                  level is exclusive or the block is dirty
+Input parameters: level - int - the depth of the level (0 for L1)
+                  cache - CacheLevel& - the level to fill
+                  memoryBlockNumber - int64_t - the memory block to fill
+                  dirty - bool - whether the filled block is dirty
+Return value:     none
+******************************************************************************/
+		void fill(int level, CacheLevel& cache, int64_t memoryBlockNumber, bool dirty) {
+			int64_t evictedBlockNumber;
+			CacheBlock evicted = cache.fill(memoryBlockNumber,dirty,evictedBlockNumber);
+			if(!evicted.validBit) return;			// An empty block was filled
+			bool evictedDirty = evicted.dirtyBit;
+			// Back-invalidate the block from every level above an inclusive level, picking up
+			// any newer dirty copy on the way
+			if(level > 0 && cache.inclusion == INCLUSIVE) {
+				for(int above = 0; above < level; above++) {
+					bool aboveDirty = false;
+					if(levels[above]->invalidate(evictedBlockNumber,aboveDirty)) cache.backInvalidations++;
+					evictedDirty = evictedDirty || aboveDirty;
+				}
+				bool fetchedDirty = false;
+				if(instructionCache && instructionCache->invalidate(evictedBlockNumber,fetchedDirty)) {
+					cache.backInvalidations++;
+				}
+			}
+			if(evictedDirty) cache.dirtyEvictions++;
+			if(level + 1 == (int)levels.size()) {	// The lowest level writes back to memory
+				if(evictedDirty) memoryWrites++;
+				return;
+			}
+			CacheLevel& below = *levels[level + 1];
+			if(below.inclusion != EXCLUSIVE && !evictedDirty) return;
+			// Update the copy below if there is one (always, for an inclusive level), otherwise
+			// allocate the block there
+			if(below.lookup(evictedBlockNumber,evictedDirty ? WRITE : READ) == MISS) {
+				fill(level + 1,below,evictedBlockNumber,evictedDirty);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printLevel
+Purpose:          Prints one row of the hierarchy statistics
+Input parameters: cache - CacheLevel& - the level to print
+                  showInclusion - bool - whether the inclusion policy applies
+Return value:     none
+******************************************************************************/
+		void printLevel(CacheLevel& cache, bool showInclusion) {
+			string write = string(cache.writePolicy == WRITE_BACK ? "WB" : "WT")
+						   + (cache.writeAllocation == WRITE_ALLOCATE ? "+WA" : "+NWA");
+			cout << setw(6) << cache.name << setw(10) << cache.cacheSize << setw(6) << cache.associativity
+				 << setw(10) << policyName(cache.policy)
+				 << setw(11) << (showInclusion ? INCLUSION_NAMES[cache.inclusion] : "-") << setw(8) << write
+				 << setw(9) << to_string(cache.hitLatency) + "/" + to_string(cache.missLatency)
+				 << setw(13) << cache.accesses << setw(13) << cache.hits
+				 << setw(10) << (cache.accesses ? (float)cache.hits/cache.accesses*100 : 0.0f) << "%"
+				 << setw(12) << cache.dirtyEvictions << setw(15) << cache.backInvalidations << endl;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printOrganization
+Purpose:          Prints how a level places its blocks, if not by the low
+                  bits of the block number, and how many of its hits came
+                  from the ways and how many from its victim cache
+Input parameters: cache - CacheLevel& - the level to print
+Return value:     none
+******************************************************************************/
+		void printOrganization(CacheLevel& cache) {
+			if(cache.index == MODULO_INDEX && cache.getVictimEntries() == 0) return;
+			cout << cache.name << ": " << INDEX_NAMES[cache.index] << " index";
+			if(cache.index == ZCACHE_INDEX) cout << ", " << cache.getRelocations() << " relocations";
+			cout << ", " << cache.hits - cache.victimHits << " hits in the ways";
+			if(cache.getVictimEntries() > 0) {
+				cout << ", " << cache.victimHits << " in a " << cache.getVictimEntries() << " block victim cache ("
+					 << (cache.hits ? (float)cache.victimHits/cache.hits*100 : 0) << "% of hits)";
+			}
+			cout << ", " << cache.accesses - cache.hits << " misses" << endl;
+			return;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CoreCache
+Purpose:          Models the private cache of one core of a multi-core
+                  system, keeping the coherence state of every block beside
+                  the cache storage. Blocks are addressed by their slot, the
+                  cache-wide number of the block holding them
+******************************************************************************/
+class CoreCache {
+	public:
+		int64_t references;							// The number of references made by the core
+		int64_t hits;								// The number of those that hit
+		int64_t coherenceMisses;					// Misses on blocks another core's write removed
+		int64_t falseSharingMisses;					// Coherence misses on words no other core wrote
+		int64_t upgrades;							// Write hits on shared blocks, which remove
+													// every other copy
+		int64_t invalidations;						// Blocks removed by other cores' writes
+		int64_t writebacks;							// Dirty blocks written back to memory
+
+/*****************************************************************************
+Function name:    CoreCache (constructor)
+Purpose:          Creates an empty private cache
+Input parameters: cacheSize - int - the size of the cache in bytes
+                  cacheBlockSize - int - the size of the cache blocks in bytes
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - the cache's replacement policy
+Return value:     none
+******************************************************************************/
+		CoreCache(int cacheSize, int cacheBlockSize, int associativity, ReplacementPolicy policy)
+			: cacheMemory(cacheSize/cacheBlockSize/associativity,associativity,policy),
+			  states(cacheSize/cacheBlockSize,STATE_INVALID) {
+			this->associativity = associativity;
+			indexBits = log2(cacheSize/cacheBlockSize/associativity);
+			setMask = ((int64_t)1 << indexBits) - 1;
+			references = hits = coherenceMisses = falseSharingMisses = 0;
+			upgrades = invalidations = writebacks = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    find
+Purpose:          Finds a memory block in the cache without changing its
+                  priority, as a snoop from another core does
+Input parameters: memoryBlockNumber - int64_t - the memory block to find
+Return value:     int - the slot holding the block, or -1 if it is not cached
+******************************************************************************/
+		int find(int64_t memoryBlockNumber) {
+			int setNumber = (int)(memoryBlockNumber & setMask);
+			int offset = CacheSet(cacheMemory,setNumber).find(memoryBlockNumber >> indexBits);
+			return (offset == -1) ? -1 : setNumber*associativity + offset;
+		}
+
+/*****************************************************************************
+Function name:    lookup
+Purpose:          Searches the cache for a memory block on behalf of its own
+                  core, updating the block's priority if it is found
+Input parameters: memoryBlockNumber - int64_t - the memory block to find
+Return value:     int - the slot holding the block, or -1 on a miss
+******************************************************************************/
+		int lookup(int64_t memoryBlockNumber) {
+			int setNumber = (int)(memoryBlockNumber & setMask);
+			CacheSet cacheSet(cacheMemory,setNumber);
+			if(cacheSet.lookup(memoryBlockNumber >> indexBits,READ) == MISS) return -1;
+			return setNumber*associativity + cacheSet.find(memoryBlockNumber >> indexBits);
+		}
+
+/*****************************************************************************
+Function name:    fill
+Purpose:          Fills a memory block that is not cached, replacing the
+                  block chosen by the replacement policy
+Input parameters: memoryBlockNumber - int64_t - the memory block to fill
+                  state - CoherenceState - the filled block's state
+Return value:     CoherenceState - the state of the block replaced, STATE_INVALID
+                                   if an empty block was filled
+******************************************************************************/
+		CoherenceState fill(int64_t memoryBlockNumber, CoherenceState state) {
+			int setNumber = (int)(memoryBlockNumber & setMask);
+			CacheSet cacheSet(cacheMemory,setNumber);
+			CacheBlock evicted = cacheSet.fill(memoryBlockNumber >> indexBits,state == STATE_MODIFIED);
+			int slot = setNumber*associativity + cacheSet.find(memoryBlockNumber >> indexBits);
+			CoherenceState evictedState = evicted.validBit ? states[slot] : STATE_INVALID;
+			states[slot] = state;
+			return evictedState;
+		}
+
+/*****************************************************************************
+Function name:    invalidate
+Purpose:          Removes a cached memory block, making its block the next
+                  to be replaced
+Input parameters: memoryBlockNumber - int64_t - the memory block to remove
+                  slot - int - the slot holding the block
+Return value:     none
+******************************************************************************/
+		void invalidate(int64_t memoryBlockNumber, int slot) {
+			bool dirty;
+			CacheSet(cacheMemory,(int)(memoryBlockNumber & setMask)).invalidate(memoryBlockNumber >> indexBits,dirty);
+			states[slot] = STATE_INVALID;
+			invalidations++;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    getState
+Purpose:          Gets the coherence state of a cached block
+Input parameters: slot - int - the slot holding the block
+Return value:     CoherenceState - the block's state
+******************************************************************************/
+		CoherenceState getState(int slot) {
+			return states[slot];
+		}
+
+/*****************************************************************************
+Function name:    setState
+Purpose:          Sets the coherence state of a cached block
+Input parameters: slot - int - the slot holding the block
+                  state - CoherenceState - the block's new state
+Return value:     none
+******************************************************************************/
+		void setState(int slot, CoherenceState state) {
+			states[slot] = state;
+			return;
+		}
+	private:
+		CacheStorage cacheMemory;					// The tags and replacement state of the cache
+		vector<CoherenceState> states;				// The coherence state of each slot
+		int associativity;							// The number of cache blocks per set
+		int indexBits;								// The number of set index bits
+		int64_t setMask;							// Selects the set index of a block number
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       MultiCoreSystem
+Purpose:          Simulates the private caches of every core of a trace, kept
+                  coherent by a snooping MESI or MOESI protocol on a shared
+                  bus. Read misses take a copy from the other caches (a dirty
+                  copy is supplied cache-to-cache, MESI writing it back to
+                  memory and MOESI keeping it owned), and writes to blocks
+                  other cores hold invalidate their copies. Every cache line
+                  invalidated is tracked to count coherence misses: a miss by
+                  a core whose copy was invalidated is a true sharing miss
+                  if another core has written the word it accesses since,
+                  and a false sharing miss if only other words of the line
+                  were written
+******************************************************************************/
+class MultiCoreSystem {
+	public:
+/*****************************************************************************
+Function name:    MultiCoreSystem (constructor)
+Purpose:          Creates a system of cores with identical empty caches
+Input parameters: numCores - int - the number of cores
+                  cacheSize - int - the size of each cache in bytes
+                  cacheBlockSize - int - the size of the cache blocks in bytes
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - the caches' replacement policy
+                  protocol - CoherenceProtocol - the coherence protocol
+Return value:     none
+******************************************************************************/
+		MultiCoreSystem(int numCores, int cacheSize, int cacheBlockSize, int associativity,
+						ReplacementPolicy policy, CoherenceProtocol protocol) {
+			for(int core = 0; core < numCores; core++) {
+				cores.push_back(unique_ptr<CoreCache>(new CoreCache(cacheSize,cacheBlockSize,associativity,policy)));
+			}
+			this->cacheSize = cacheSize;
+			this->cacheBlockSize = cacheBlockSize;
+			this->associativity = associativity;
+			this->policy = policy;
+			this->protocol = protocol;
+			offsetBits = log2(cacheBlockSize);
+			// Sharing is tracked per word, or per 64th of the block for blocks over 64 words
+			wordShift = max(log2(WRITE_WORD_SIZE),offsetBits - 6);
+			references = busReads = busReadExclusives = busUpgrades = 0;
+			cacheTransfers = memoryReads = memoryWrites = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Simulates one memory reference by one core, snooping the
+                  other caches on a miss or on a write to a shared block
+Input parameters: core - int - the core making the reference
+                  memoryAddress - int64_t - the address being referenced
+                  operation - ReadWrite - a read or write (instruction
+                                          fetches are treated as reads)
+Return value:     none
+******************************************************************************/
+		void access(int core, int64_t memoryAddress, ReadWrite operation) {
+			int64_t memoryBlockNumber = memoryAddress >> offsetBits;
+			uint64_t word = (uint64_t)1 << ((memoryAddress & (cacheBlockSize - 1)) >> wordShift);
+			bool writing = (operation == WRITE);
+			CoreCache& cache = *cores[core];
+			cache.references++;
+			references++;
+			int slot = cache.lookup(memoryBlockNumber);
+			if(slot != -1) {
+				cache.hits++;
+				if(!writing) return;
+				// Writing a block other caches may share first removes their copies
+				CoherenceState state = cache.getState(slot);
+				if(state == STATE_SHARED || state == STATE_OWNED) {
+					cache.upgrades++;
+					busUpgrades++;
+					invalidateOthers(core,memoryBlockNumber);
+				}
+				cache.setState(slot,STATE_MODIFIED);
+				recordWrite(core,memoryBlockNumber,word);
+				return;
+			}
+			// A miss on a block another core's write removed is a coherence miss
+			unordered_map<int64_t,LineSharing>::iterator line = lines.find(memoryBlockNumber);
+			if(line != lines.end() && (line->second.staleCores >> core & 1)) {
+				cache.coherenceMisses++;
+				line->second.coherenceMisses++;
+				if(!(line->second.writtenWords[core] & word)) {
+					cache.falseSharingMisses++;
+					line->second.falseSharingMisses++;
+				}
+				line->second.staleCores &= ~((uint64_t)1 << core);
+			}
+			bool shared = false;					// Whether another cache keeps a copy
+			bool supplied = false;					// Whether another cache supplies the block
+			if(writing) {							// Read for ownership
+				busReadExclusives++;
+				supplied = invalidateOthers(core,memoryBlockNumber);
+			}
+			else {
+				busReads++;
+				for(int other = 0; other < (int)cores.size(); other++) {
+					int otherSlot = (other == core) ? -1 : cores[other]->find(memoryBlockNumber);
+					if(otherSlot == -1) continue;
+					shared = true;
+					CoherenceState state = cores[other]->getState(otherSlot);
+					if(state == STATE_MODIFIED && protocol == MOESI) cores[other]->setState(otherSlot,STATE_OWNED);
+					else if(state == STATE_MODIFIED) {	// MESI writes the dirty block back as it shares it
+						cores[other]->writebacks++;
+						memoryWrites++;
+						cores[other]->setState(otherSlot,STATE_SHARED);
+					}
+					else if(state == STATE_EXCLUSIVE) cores[other]->setState(otherSlot,STATE_SHARED);
+					supplied = supplied || state == STATE_MODIFIED || state == STATE_OWNED;
+				}
+			}
+			if(supplied) cacheTransfers++;
+			else memoryReads++;
+			CoherenceState evicted = cache.fill(memoryBlockNumber,writing ? STATE_MODIFIED : shared ? STATE_SHARED : STATE_EXCLUSIVE);
+			if(evicted == STATE_MODIFIED || evicted == STATE_OWNED) {
+				cache.writebacks++;
+				memoryWrites++;
+			}
+			if(writing) recordWrite(core,memoryBlockNumber,word);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    simulate
+Purpose:          Streams every reference of a trace through the caches of
+                  the cores making them
+Input parameters: traceReader - TraceReader& - the validated trace to simulate
+Return value:     none
+******************************************************************************/
+		void simulate(TraceReader& traceReader) {
+			vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+			int chunkSize;
+			traceReader.rewind();
+			while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+				for(int i = 0; i < chunkSize; i++) access(chunk[i].core,chunk[i].memoryAddress,chunk[i].operation);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printStatistics
+Purpose:          Prints the hits and coherence activity of every core, the
+                  bus and memory traffic, and the cache lines with the most
+                  false sharing
+Input parameters: hotLines - int - the number of lines to list, or 0 for
+                                   every line that was invalidated
+Return value:     none
+******************************************************************************/
+		void printStatistics(int hotLines) {
+			cout << "Coherent multi-core simulation of " << references << " memory references, "
+				 << PROTOCOL_NAMES[protocol] << " over " << cores.size() << " private " << cacheSize << " byte "
+				 << associativity << "-way " << policyName(policy) << " caches, " << cacheBlockSize
+				 << " byte blocks" << endl;
+			cout << setw(5) << "core" << setw(13) << "references" << setw(13) << "hits" << setw(11) << "hit rate"
+				 << setw(11) << "coherence" << setw(15) << "false sharing" << setw(10) << "upgrades"
+				 << setw(13) << "invalidated" << setw(12) << "writebacks" << endl;
+			cout << string(103,'-') << endl;		// Print line to separate header from data
+			int64_t coherenceMisses = 0;
+			int64_t falseSharingMisses = 0;
+			int64_t invalidations = 0;
+			for(unsigned int core = 0; core < cores.size(); core++) {
+				CoreCache& cache = *cores[core];
+				cout << setw(5) << core << setw(13) << cache.references << setw(13) << cache.hits
+					 << setw(10) << (cache.references ? (float)cache.hits/cache.references*100 : 0.0f) << "%"
+					 << setw(11) << cache.coherenceMisses << setw(15) << cache.falseSharingMisses
+					 << setw(10) << cache.upgrades << setw(13) << cache.invalidations
+					 << setw(12) << cache.writebacks << endl;
+				coherenceMisses += cache.coherenceMisses;
+				falseSharingMisses += cache.falseSharingMisses;
+				invalidations += cache.invalidations;
+			}
+			cout << "\nBus reads = " << busReads << ", read-exclusives = " << busReadExclusives
+				 << ", upgrades = " << busUpgrades << ", invalidations = " << invalidations << endl;
+			cout << "Cache-to-cache transfers = " << cacheTransfers << ", memory reads = " << memoryReads
+				 << " blocks, memory writes = " << memoryWrites << " blocks" << endl;
+			cout << "Coherence misses = " << coherenceMisses << " (" << coherenceMisses - falseSharingMisses
+				 << " true sharing, " << falseSharingMisses << " false sharing)" << endl;
+			printHotLines(hotLines);
+			return;
+		}
+	private:
+		// The sharing history of a cache line that has been invalidated in some core's cache:
+		// the cores whose copy was invalidated and that have not missed on the line since, and
+		// for each of them, the words of the line other cores have written since
+		struct LineSharing {
+			int64_t invalidations = 0;
+			int64_t coherenceMisses = 0;
+			int64_t falseSharingMisses = 0;
+			uint64_t sharingCores = 0;				// Every core that invalidated or lost the line
+			uint64_t staleCores = 0;
+			vector<uint64_t> writtenWords;			// One word mask per core
+		};
+		vector<unique_ptr<CoreCache>> cores;		// The private cache of each core
+		unordered_map<int64_t,LineSharing> lines;	// The sharing history of invalidated lines
+		int cacheSize;								// The size of each cache in bytes
+		int cacheBlockSize;							// The block size in bytes
+		int associativity;							// The number of cache blocks per set
+		ReplacementPolicy policy;					// The caches' replacement policy
+		CoherenceProtocol protocol;					// The coherence protocol
+		int offsetBits;								// The number of block offset bits
+		int wordShift;								// Shift from a block offset to its word
+		int64_t references;							// The number of references simulated
+		int64_t busReads;							// Read misses snooped on the bus
+		int64_t busReadExclusives;					// Write misses snooped on the bus
+		int64_t busUpgrades;						// Write hits on shared blocks
+		int64_t cacheTransfers;						// Misses supplied by another core's cache
+		int64_t memoryReads;						// Misses supplied by main memory
+		int64_t memoryWrites;						// Dirty blocks written back to main memory
+
+/*****************************************************************************
+Function name:    invalidateOthers
+Purpose:          Removes every other core's copy of a block before a core
+                  writes it, recording the cores that lost their copy
+Input parameters: core - int - the core about to write the block
+                  memoryBlockNumber - int64_t - the memory block written
+Return value:     bool - true if another copy was dirty, so that it supplies
+                         the block (MESI also writes it back to memory)
+******************************************************************************/
+		bool invalidateOthers(int core, int64_t memoryBlockNumber) {
+			bool supplied = false;
+			for(int other = 0; other < (int)cores.size(); other++) {
+				int otherSlot = (other == core) ? -1 : cores[other]->find(memoryBlockNumber);
+				if(otherSlot == -1) continue;
+				CoherenceState state = cores[other]->getState(otherSlot);
+				if(state == STATE_MODIFIED || state == STATE_OWNED) {
+					supplied = true;
+					if(protocol == MESI) {
+						cores[other]->writebacks++;
+						memoryWrites++;
+					}
+				}
+				cores[other]->invalidate(memoryBlockNumber,otherSlot);
+				LineSharing& line = lines[memoryBlockNumber];
+				if(line.writtenWords.empty()) line.writtenWords.resize(cores.size());
+				line.invalidations++;
+				line.sharingCores |= ((uint64_t)1 << core) | ((uint64_t)1 << other);
+				line.staleCores |= (uint64_t)1 << other;
+				line.writtenWords[other] = 0;		// Nothing written since the copy was lost yet
+			}
+			return supplied;
+		}
+
+/*****************************************************************************
+Function name:    recordWrite
+Purpose:          Records a write to a word of a line for every other core
+                  whose copy of the line was invalidated, so that their next
+                  misses on the line can be told apart as true or false
+                  sharing
+Input parameters: core - int - the core writing
+                  memoryBlockNumber - int64_t - the memory block written
+                  word - uint64_t - the mask of the word written
+Return value:     none
+******************************************************************************/
+		void recordWrite(int core, int64_t memoryBlockNumber, uint64_t word) {
+			unordered_map<int64_t,LineSharing>::iterator line = lines.find(memoryBlockNumber);
+			if(line == lines.end()) return;
+			uint64_t staleCores = line->second.staleCores & ~((uint64_t)1 << core);
+			while(staleCores != 0) {				// For each stale core, lowest first
+				line->second.writtenWords[__builtin_ctzll(staleCores)] |= word;
+				staleCores &= staleCores - 1;
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printHotLines
+Purpose:          Prints the invalidated cache lines with the most false
+                  sharing misses (then the most coherence misses and the most
+                  invalidations), with the cores sharing each
+Input parameters: hotLines - int - the number of lines to list, or 0 for all
+Return value:     none
+******************************************************************************/
+		void printHotLines(int hotLines) {
+			vector< pair<int64_t,const LineSharing*> > ranked;
+			for(unordered_map<int64_t,LineSharing>::iterator line = lines.begin(); line != lines.end(); ++line) {
+				ranked.push_back(make_pair(line->first,&line->second));
+			}
+			sort(ranked.begin(),ranked.end(),compareLines);
+			if(hotLines > 0 && (int)ranked.size() > hotLines) ranked.resize(hotLines);
+			cout << "\nFalse sharing hot lines (" << ranked.size() << " of " << lines.size() << " invalidated lines)" << endl;
+			cout << setw(20) << "line address" << setw(15) << "invalidations" << setw(11) << "coherence"
+				 << setw(15) << "false sharing" << "  cores" << endl;
+			cout << string(68,'-') << endl;		// Print line to separate header from data
+			for(unsigned int i = 0; i < ranked.size(); i++) {
+				const LineSharing& line = *ranked[i].second;
+				string sharers;						// The cores sharing the line, e.g. "0,2,3"
+				for(uint64_t cores = line.sharingCores; cores != 0; cores &= cores - 1) {
+					sharers += (sharers.empty() ? "" : ",") + to_string(__builtin_ctzll(cores));
+				}
+				cout << setw(20) << ranked[i].first*cacheBlockSize << setw(15) << line.invalidations
+					 << setw(11) << line.coherenceMisses << setw(15) << line.falseSharingMisses
+					 << "  " << sharers << endl;
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    compareLines
+Purpose:          Orders cache lines for the hot line report, most false
+                  sharing misses first, ties broken by coherence misses, then
+                  invalidations, then address
+Input parameters: first - const pair<int64_t,const LineSharing*>& - a line
+                  second - const pair<int64_t,const LineSharing*>& - a line
+Return value:     bool - true if the first line is listed before the second
+******************************************************************************/
+		static bool compareLines(const pair<int64_t,const LineSharing*>& first,
+								 const pair<int64_t,const LineSharing*>& second) {
+			if(first.second->falseSharingMisses != second.second->falseSharingMisses) {
+				return first.second->falseSharingMisses > second.second->falseSharingMisses;
+			}
+			if(first.second->coherenceMisses != second.second->coherenceMisses) {
+				return first.second->coherenceMisses > second.second->coherenceMisses;
+			}
+			if(first.second->invalidations != second.second->invalidations) {
+				return first.second->invalidations > second.second->invalidations;
+			}
+			return first.first < second.first;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       StackDistanceAnalyzer
+Purpose:          Computes the LRU hit counts of every cache size of a given
+                  block size in a single pass over a trace. Fully associative
+                  caches use Mattson stack distances (counted with a Fenwick
+                  tree over access times, renumbered whenever it fills so it
+                  stays a few times the number of distinct blocks), and
+                  set-associative caches use a per-set LRU stack for every
+                  power of two number of sets
+******************************************************************************/
+class StackDistanceAnalyzer {
+	public:
+/*****************************************************************************
+Function name:    StackDistanceAnalyzer (constructor)
+Purpose:          Creates an analyzer for caches up to the given size
+Input parameters: cacheBlockSize - int - the block size of every cache
+                  maxCacheSize - int - the largest cache size to report
+                  maxAssociativity - int - the largest set associativity to
+                                           report (fully associative caches
+                                           are always reported)
+                  rate - double - the share of the blocks to analyze (below
+                                  1 for a SHARDS estimate of the fully
+                                  associative caches only)
+Return value:     none
+******************************************************************************/
+		StackDistanceAnalyzer(int cacheBlockSize, int maxCacheSize, int maxAssociativity, double rate) {
+			this->cacheBlockSize = cacheBlockSize;
+			offsetBits = log2(cacheBlockSize);
+			maxBlocks = maxCacheSize/cacheBlockSize;
+			this->maxAssociativity = min(maxAssociativity,maxBlocks);
+			maxIndexBits = log2(maxBlocks);			// Direct mapped caches have the most sets
+			references = 0;
+			sampledReferences = 0;
+			coldMisses = 0;
+			lastTime = 0;
+			sampleRate = 1;							// Every block is analyzed unless sampling
+			sampleThreshold = (uint64_t)1 << SAMPLE_HASH_BITS;
+			accessTimes.assign(MIN_ACCESS_TIMES + 1,0);	// Fenwick tree indexed from 1
+			distanceCounts.assign(maxBlocks,0);
+			if(rate < 1) {							// No set stacks, which are never sampled
+				setSampling(rate);
+				return;
+			}
+			// One stack of maxAssociativity entries per set, for every power of two number of sets
+			setStacks.resize(maxIndexBits + 1);
+			setDistanceCounts.resize(maxIndexBits + 1);
+			for(int indexBits = 0; indexBits <= maxIndexBits; indexBits++) {
+				setStacks[indexBits].assign((size_t)this->maxAssociativity << indexBits,-1);
+				setDistanceCounts[indexBits].assign(this->maxAssociativity,0);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Records one memory reference
+Input parameters: memoryAddress - int64_t - the memory address being accessed
+Return value:     none
+******************************************************************************/
+		void access(int64_t memoryAddress) {
+			int64_t memoryBlockNumber = memoryAddress >> offsetBits;
+			references++;
+			bool sampling = (sampleRate < 1);
+			int group = 0;							// The sample group the block belongs to
+			if(sampling) {
+				uint64_t hash = samplingHash(memoryBlockNumber);
+				if(hash >= sampleThreshold) return;	// Not a sampled block
+				group = hash % SAMPLE_GROUPS;
+				groupReferences[group]++;
+			}
+			sampledReferences++;
+			if(lastTime + 1 >= (int64_t)accessTimes.size()) renumberAccessTimes();
+			int64_t time = ++lastTime;				// Access times start at 1 (Fenwick indexing)
+			// The fully associative stack distance is the number of distinct blocks accessed since
+			// the block's last access, which are exactly the blocks whose latest access is later
+			unordered_map<int64_t,int64_t>::iterator last = lastAccess.find(memoryBlockNumber);
+			if(last == lastAccess.end()) {
+				coldMisses++;						// First access misses in every cache
+				lastAccess[memoryBlockNumber] = time;
+			}
+			else {
+				int64_t distance = countAccessTimes(time - 1) - countAccessTimes(last->second);
+				// Only the sampled share of the blocks in between was seen
+				if(sampling) distance = (int64_t)(distance/sampleRate);
+				if(distance < maxBlocks) distanceCounts[distance]++;
+				if(sampling && distance < maxBlocks) {
+					// Count the hit under the smallest reported cache size that holds the block
+					groupDistanceCounts[group][(distance == 0) ? 0 : log2(distance) + 1]++;
+				}
+				addAccessTime(last->second,-1);		// The block's previous access is no longer its latest
+				last->second = time;
+			}
+			addAccessTime(time,1);
+			if(sampling) return;					// Set-associative caches are not sampled
+			// Update the LRU stack of the block's set for every number of sets
+			for(int indexBits = 0; indexBits <= maxIndexBits; indexBits++) {
+				int cacheSetNumber = memoryBlockNumber & ((1 << indexBits) - 1);
+				int64_t* stack = &setStacks[indexBits][(size_t)cacheSetNumber*maxAssociativity];
+				int depth = 0;						// Position of the block in the set's stack
+				while(depth < maxAssociativity && stack[depth] != memoryBlockNumber) depth++;
+				if(depth < maxAssociativity) setDistanceCounts[indexBits][depth]++;
+				else depth = maxAssociativity - 1;	// Not in the stack, so drop the bottom entry
+				// Move the block to the top of the stack
+				for(; depth > 0; depth--) stack[depth] = stack[depth - 1];
+				stack[0] = memoryBlockNumber;
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printMissRatioCurve
+Purpose:          Prints the hit and miss ratio of every cache size and
+                  associativity covered by the analysis
+Input parameters: none (values come from the StackDistanceAnalyzer object)
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printMissRatioCurve() {
+			if(sampleRate < 1) {
+				printSampledMissRatioCurve();
+				return;
+			}
+			cout << "Miss ratio curve (LRU, " << cacheBlockSize << " byte blocks, "
+				 << references << " references, " << coldMisses << " compulsory misses)" << endl;
+			cout << setw(12) << "cache size" << setw(8) << "ways" << setw(10) << "sets"
+				 << setw(16) << "hits" << setw(14) << "miss ratio" << endl;
+			cout << string(60,'-') << endl;			// Print line to separate header from data
+			long long fullyAssociativeHits = 0;		// Running sum of the stack distance histogram
+			int countedDistances = 0;
+			for(int blocks = 1; blocks <= maxBlocks; blocks *= 2) {
+				// Set-associative caches of this size, from direct mapped up to maxAssociativity
+				for(int associativity = 1; associativity <= min(blocks,maxAssociativity); associativity *= 2) {
+					int indexBits = log2(blocks/associativity);
+					long long hits = 0;
+					for(int depth = 0; depth < associativity; depth++) hits += setDistanceCounts[indexBits][depth];
+					printMissRatio(blocks,to_string(associativity),blocks/associativity,hits);
+				}
+				// A fully associative cache of this size hits every reference with a smaller distance
+				for(; countedDistances < blocks; countedDistances++) {
+					fullyAssociativeHits += distanceCounts[countedDistances];
+				}
+				printMissRatio(blocks,"full",1,fullyAssociativeHits);
+			}
+			cout << endl;
+			return;
+		}
+	private:
+		int cacheBlockSize;							// The block size of every cache in bytes
+		int offsetBits;								// The number of offset bits in the address
+		double sampleRate;							// The share of the blocks analyzed
+		uint64_t sampleThreshold;					// Blocks whose hash is below this are sampled
+		long long sampledReferences;				// The references to sampled blocks so far
+		vector<long long> groupReferences;			// Sampling only: references in each group
+		vector< vector<long long> > groupDistanceCounts;	// Sampling only: each group's hits by the
+													// smallest cache size (a power of two) hit
+		int maxBlocks;								// The number of blocks in the largest cache
+		int maxAssociativity;						// The largest set associativity to report
+		int maxIndexBits;							// Index bits of the cache with the most sets
+		long long references;						// The number of references analyzed so far
+		long long coldMisses;						// The number of first references to a block
+		vector<int64_t> accessTimes;				// Fenwick tree marking the latest access time
+													// of every block seen so far
+		int64_t lastTime;							// The latest access time handed out
+		unordered_map<int64_t,int64_t> lastAccess;	// The latest access time of each memory block
+		vector<long long> distanceCounts;			// Fully associative stack distance histogram
+		vector< vector<int64_t> > setStacks;		// Per-set LRU stacks, for each number of index bits
+		vector< vector<long long> > setDistanceCounts;	// Per-set stack distance histograms
+
+/*****************************************************************************
+Function name:    setSampling
+Purpose:          Analyzes only a hashed sample of the memory blocks (SHARDS),
+                  scaling their stack distances up by the sampling rate.
+                  Every reference to a sampled block is analyzed, so reuse
+                  is measured exactly for the blocks in the sample. Only
+                  fully associative caches are reported, since a block's
+                  depth in its set cannot be scaled down to a few ways
+Input parameters: rate - double - the share of the blocks to analyze
+Return value:     none
+******************************************************************************/
+		void setSampling(double rate) {
+			sampleRate = rate;
+			sampleThreshold = (uint64_t)(rate*((uint64_t)1 << SAMPLE_HASH_BITS));
+			groupReferences.assign(SAMPLE_GROUPS,0);
+			groupDistanceCounts.assign(SAMPLE_GROUPS,vector<long long>(maxIndexBits + 2,0));
+			return;
+		}
+
+/*****************************************************************************
+Function name:    addAccessTime
+Purpose:          Adds to the mark at an access time in the Fenwick tree
+Input parameters: time - int64_t - the access time to update
+                  change - int - +1 to mark the time, -1 to unmark it
+Return value:     none
+******************************************************************************/
+		void addAccessTime(int64_t time, int change) {
+			for(; time < (int64_t)accessTimes.size(); time += time & -time) accessTimes[time] += change;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    countAccessTimes
+Purpose:          Counts the marked access times up to and including a time
+Input parameters: time - int64_t - the last access time to count
+Return value:     int64_t - the number of marked access times
+******************************************************************************/
+		int64_t countAccessTimes(int64_t time) {
+			int64_t count = 0;
+			for(; time > 0; time -= time & -time) count += accessTimes[time];
+			return count;
+		}
+
+/*****************************************************************************
+Function name:    renumberAccessTimes
+Purpose:          Makes room for more access times once the Fenwick tree is
+                  full. Only each block's latest access is marked, so those
+                  times are renumbered 1, 2, 3... in the same order (each
+                  time's new number is the count of marked times up to it),
+                  which keeps every stack distance, and the tree is rebuilt
+                  with room for three times as many new accesses. It so stays
+                  proportional to the distinct blocks however long the
+                  trace, at an amortized O(log blocks) per access
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void renumberAccessTimes() {
+			int64_t size = (int64_t)accessTimes.size();
+			// Undo the tree's sums, newest node first, leaving just the marks
+			for(int64_t time = size - 1; time >= 1; time--) {
+				int64_t parent = time + (time & -time);
+				if(parent < size) accessTimes[parent] -= accessTimes[time];
+			}
+			for(int64_t time = 1; time < size; time++) accessTimes[time] += accessTimes[time - 1];
+			for(unordered_map<int64_t,int64_t>::iterator last = lastAccess.begin(); last != lastAccess.end(); ++last) {
+				last->second = accessTimes[last->second];
+			}
+			lastTime = (int64_t)lastAccess.size();
+			// Mark every time up to lastTime, then build the tree in place by passing each node's
+			// count up to the node covering it
+			accessTimes.assign(max(4*lastTime,MIN_ACCESS_TIMES) + 1,0);
+			for(int64_t time = 1; time <= lastTime; time++) accessTimes[time] = 1;
+			for(int64_t time = 1; time < (int64_t)accessTimes.size(); time++) {
+				int64_t parent = time + (time & -time);
+				if(parent < (int64_t)accessTimes.size()) accessTimes[parent] += accessTimes[time];
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printSampledMissRatioCurve
+Purpose:          Prints the miss ratio of every fully associative cache size
+                  of at least 1 / rate blocks, estimated from a sample of the
+                  blocks, with a confidence interval found from how much the
+                  sample's groups differ
+Input parameters: none (values come from the StackDistanceAnalyzer object)
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printSampledMissRatioCurve() {
+			// A few very popular blocks in or out of the sample can leave it with more or fewer
+			// references than the rate expects. Like SHARDS_adj, the difference is put down to
+			// those blocks, which hit in any cache, so it is added to the smallest cache's hits
+			double expectedReferences = references*sampleRate;
+			double adjustment = expectedReferences - sampledReferences;
+			cout << "Miss ratio curve (LRU, " << cacheBlockSize << " byte blocks, " << references << " references, "
+				 << "SHARDS sample of " << sampleRate*100 << "% of blocks: " << sampledReferences << " references, ~"
+				 << llround(coldMisses/sampleRate) << " compulsory misses)" << endl;
+			cout << setw(12) << "cache size" << setw(8) << "ways" << setw(10) << "sets"
+				 << setw(16) << "hits" << setw(14) << "miss ratio" << setw(12) << "+/- (95%)" << endl;
+			cout << string(72,'-') << endl;			// Print line to separate header from data
+			long long sampledHits = 0;				// Running sum of the stack distance histogram
+			int countedDistances = 0;
+			vector<long long> groupHits(SAMPLE_GROUPS,0);
+			vector<int64_t> groupMisses(SAMPLE_GROUPS);
+			for(int blocks = 1, sizeIndex = 0; blocks <= maxBlocks; blocks *= 2, sizeIndex++) {
+				for(; countedDistances < blocks; countedDistances++) sampledHits += distanceCounts[countedDistances];
+				for(int group = 0; group < SAMPLE_GROUPS; group++) {
+					groupHits[group] += groupDistanceCounts[group][sizeIndex];
+					groupMisses[group] = groupReferences[group] - groupHits[group];
+				}
+				// Distances are only known to within 1 / rate blocks, too coarse for smaller caches
+				if(blocks*sampleRate < 1) continue;
+				long long hits = llround((sampledHits + adjustment)/sampleRate);
+				hits = max(min(hits,references),0LL);
+				cout << setw(12) << blocks*cacheBlockSize << setw(8) << "full" << setw(10) << 1 << setw(16) << hits
+					 << setw(13) << (float)(references - hits)/references*100 << "%" << setw(11)
+					 << sampleError(groupMisses,SAMPLE_GROUPS/sampleRate,references) << "%" << endl;
+			}
+			cout << endl;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    printMissRatio
+Purpose:          Prints one line of the miss ratio curve
+Input parameters: blocks - int - the number of blocks in the cache
+                  associativity - string - the cache's associativity
+                  sets - int - the number of sets in the cache
+                  hits - long long - the number of hits in the cache
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+		void printMissRatio(int blocks, string associativity, int sets, long long hits) {
+			cout << setw(12) << blocks*cacheBlockSize << setw(8) << associativity << setw(10) << sets
+				 << setw(16) << hits << setw(13) << (float)(references - hits)/references*100 << "%" << endl;
+			return;
+		}
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       WorkStealingPool
+Purpose:          Runs a batch of independent tasks on a fixed set of worker
+                  threads. Each worker has its own task queue and takes work
+                  from the back of it, and when it runs dry it steals from
+                  the front of the other workers' queues
+******************************************************************************/
+class WorkStealingPool {
+	public:
+/*****************************************************************************
+Function name:    WorkStealingPool (constructor)
+Purpose:          Creates a pool with the given number of workers
+Input parameters: numWorkers - int - the number of worker threads (at least 1)
+Return value:     none
+******************************************************************************/
+		WorkStealingPool(int numWorkers) {
+			for(int i = 0; i < max(numWorkers,1); i++) queues.push_back(unique_ptr<WorkQueue>(new WorkQueue));
+			nextQueue = 0;
+			return;
+		}
+
+/*****************************************************************************
+Function name:    submit
+Purpose:          Adds a task to the pool, spreading tasks over the workers'
+                  queues in turn
+Input parameters: task - function<void()> - the task to run
+Return value:     none
+******************************************************************************/
+		void submit(function<void()> task) {
+			WorkQueue& queue = *queues[nextQueue];
+			nextQueue = (nextQueue + 1) % queues.size();
+			lock_guard<mutex> lock(queue.lock);
+			queue.tasks.push_back(task);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    run
+Purpose:          Runs every submitted task on the workers and waits for all
+                  of them to finish
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void run() {
+			vector<thread> workers;
+			for(unsigned int i = 0; i < queues.size(); i++) {
+				workers.push_back(thread(&WorkStealingPool::workerLoop,this,i));
+			}
+			for(unsigned int i = 0; i < workers.size(); i++) workers[i].join();
+			return;
+		}
+	private:
+		// A worker's queue of tasks, guarded by its own lock so workers rarely contend
+		struct WorkQueue {
+			mutex lock;
+			deque< function<void()> > tasks;
+		};
+		vector< unique_ptr<WorkQueue> > queues;		// One task queue per worker
+		unsigned int nextQueue;						// The queue the next submitted task goes to
+
+/*****************************************************************************
+Function name:    workerLoop
+Purpose:          Runs tasks from the worker's own queue, then from the other
+                  queues, until every queue is empty. Tasks never submit more
+                  tasks, so once all queues are empty the batch is done
+Input parameters: worker - int - the index of the worker's own queue
+Return value:     none
+******************************************************************************/
+		void workerLoop(int worker) {
+			function<void()> task;
+			while(takeTask(worker,task)) task();
+			return;
+		}
+
+/*****************************************************************************
+Function name:    takeTask
+Purpose:          Takes the newest task from the worker's own queue, or else
+                  steals the oldest task from another worker's queue
+Input parameters: worker - int - the index of the worker's own queue
+                  task - function<void()>& - set to the task taken
+Return value:     bool - true if a task was taken, false if none are left
+******************************************************************************/
+		bool takeTask(int worker, function<void()>& task) {
+			for(unsigned int i = 0; i < queues.size(); i++) {
+				WorkQueue& queue = *queues[(worker + i) % queues.size()];
+				lock_guard<mutex> lock(queue.lock);
+				if(queue.tasks.empty()) continue;
+				if(i == 0) {						// Own queue: take from the back
+					task = queue.tasks.back();
+					queue.tasks.pop_back();
+				}
+				else {								// Another worker's queue: steal from the front
+					task = queue.tasks.front();
+					queue.tasks.pop_front();
+				}
+				return true;
+			}
+			return false;
+		}
+};
+
+/*****************************************************************************
+Function name:    isPowerOfTwo
+Purpose:          Returns if the input is a power of two within the given limits
+Input parameters: value - int64_t - the input to check
+                  minimumVal - int64_t - the smallest allowed value
+                  maximumVal - int64_t - the largest allowed value
+Return value:     bool - true if the input is an allowed power of two
+******************************************************************************/
+bool isPowerOfTwo(int64_t value, int64_t minimumVal, int64_t maximumVal) {
+	return value >= minimumVal && value <= maximumVal && value > 0 && (value & (value - 1)) == 0;
+}
+
+#ifdef MEM_SIMULATOR_LIBRARY
+}
+#endif
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CacheSimulator::Implementation
+Purpose:          The cache behind the library interface of mem_simulator.h:
+                  a memory simulator and the counts of its references
+******************************************************************************/
+class CacheSimulator::Implementation {
+	public:
+		MemorySimulator simulator;					// The simulated cache
+		SimulationStatistics statistics;			// The counts since the last reset
+		int64_t rejected;							// References rejected since the last reset
+		uint64_t memorySize;						// Every address simulated is below this size
+		int cacheBlockSize;							// The size of the cache blocks in bytes
+
+/*****************************************************************************
+Function name:    Implementation (constructor)
+Purpose:          Creates an empty cache from a validated configuration
+Input parameters: configuration - const CacheConfiguration& - the cache
+                  policy - ReplacementPolicy - its parsed replacement policy
+Return value:     none
+******************************************************************************/
+		Implementation(const CacheConfiguration& configuration, ReplacementPolicy policy)
+			: simulator(configuration.memorySize,configuration.cacheSize,configuration.cacheBlockSize,
+						configuration.associativity,policy) {
+			rejected = 0;
+			memorySize = (uint64_t)configuration.memorySize;
+			cacheBlockSize = configuration.cacheBlockSize;
+			return;
+		}
+};
+
+/*****************************************************************************
+Function name:    CacheSimulator (constructor)
+Purpose:          Creates a library cache simulator with no cache configured
+Input parameters: none
+Return value:     none
+******************************************************************************/
+CacheSimulator::CacheSimulator() {
+	implementation = NULL;
+	return;
+}
+
+/*****************************************************************************
+Function name:    ~CacheSimulator (destructor)
+Purpose:          Frees the configured cache
+Input parameters: none
+Return value:     none
+******************************************************************************/
+CacheSimulator::~CacheSimulator() {
+	delete implementation;
+	return;
+}
+
+/*****************************************************************************
+Function name:    configure
+Purpose:          Creates an empty cache with the same limits as the command
+                  line, replacing any cache configured before
+Input parameters: configuration - const CacheConfiguration& - the cache
+                  error - string& - set to a description of any error
+Return value:     bool - true if the configuration is valid, false if not
+******************************************************************************/
+bool CacheSimulator::configure(const CacheConfiguration& configuration, string& error) {
+	ReplacementPolicy policy = LRU;					// Each is set by its parse, but GCC cannot tell
+	WritePolicy writePolicy = WRITE_BACK;			// through the conditions below
+	WriteAllocation writeAllocation = WRITE_ALLOCATE;
+	IndexFunction index = MODULO_INDEX;
+	PrefetcherType prefetcher = NO_PREFETCHER;
+	if(!isPowerOfTwo(configuration.memorySize,4,MAX_MEMORY_SIZE)
+	   || !isPowerOfTwo(configuration.cacheSize,2,min(configuration.memorySize,(int64_t)MAX_CACHE_SIZE))
+	   || !isPowerOfTwo(configuration.cacheBlockSize,2,configuration.cacheSize)
+	   || !isPowerOfTwo(configuration.associativity,1,configuration.cacheSize/configuration.cacheBlockSize)) {
+		error = "Sizes must be powers of two with block size <= cache size <= memory size <= 2^62, "
+				"cache size <= 2^30 and associativity <= cache size / block size";
+		return false;
+	}
+	if(!configuration.policy || !parsePolicy(configuration.policy,policy) || policy == OPT) {
+		error = "The replacement policy must be one of the simulator's policies other than OPT";
+		return false;
+	}
+	if(!configuration.writePolicy || !parseWritePolicy(configuration.writePolicy,writePolicy)
+	   || !configuration.writeAllocation || !parseWriteAllocation(configuration.writeAllocation,writeAllocation)) {
+		error = "The write policy must be WB or WT, and the write allocation WA or NWA";
+		return false;
+	}
+	if(!configuration.index || !parseIndexFunction(configuration.index,index)
+	   || (index != MODULO_INDEX && index != XOR_INDEX)) {
+		error = "The index function must be MODULO or XOR";
+		return false;
+	}
+	if(!configuration.prefetcher || !parsePrefetcher(configuration.prefetcher,prefetcher)
+	   || configuration.prefetchDegree < 1 || configuration.prefetchDegree > MAX_PREFETCH_DEGREE
+	   || configuration.prefetchDistance < 1) {
+		error = "The prefetcher must be NONE, NEXT-LINE, STRIDE or STREAM, with a degree of 1 to 16 and a "
+				"distance of at least 1";
+		return false;
+	}
+	if(configuration.victimEntries < 0 || configuration.victimEntries > MAX_VICTIM_ENTRIES
+	   || (configuration.victimEntries > 0 && prefetcher != NO_PREFETCHER)) {
+		error = "The victim cache must hold 0 to 64 blocks, and cannot be used with a prefetcher";
+		return false;
+	}
+	if(configuration.hitLatency < 0 || configuration.missLatency < 0 || configuration.memoryLatency < 0) {
+		error = "Latencies cannot be negative";
+		return false;
+	}
+	delete implementation;
+	implementation = new Implementation(configuration,policy);
+	MemorySimulator& simulator = implementation->simulator;
+	simulator.setSeed(configuration.seed);
+	simulator.setWritePolicy(writePolicy,writeAllocation);
+	simulator.setLatencies(configuration.hitLatency,configuration.missLatency,configuration.memoryLatency);
+	simulator.setOrganization(index,configuration.victimEntries);
+	simulator.setPrefetcher(prefetcher,configuration.prefetchDegree,configuration.prefetchDistance);
+	return true;
+}
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Simulates a batch of references in order, rejecting any
+                  whose address is not below the memory size
+Input parameters: addresses - const uint64_t* - the byte addresses
+                  operations - const uint8_t* - the operations, or NULL if
+                                                every reference is a read
+                  count - size_t - the number of references
+                  results - uint8_t* - set to 1 for each hit and 0 for each
+                                       miss or rejected reference, or NULL
+Return value:     size_t - the number of references in the batch that hit
+******************************************************************************/
+size_t CacheSimulator::access(const uint64_t* addresses, const uint8_t* operations, size_t count, uint8_t* results) {
+	if(!implementation) return 0;
+	MemorySimulator& simulator = implementation->simulator;
+	uint64_t memorySize = implementation->memorySize;
+	// The memory size is a power of two, so every address is below it exactly when their OR is
+	uint64_t addressBits = 0;
+	for(size_t i = 0; i < count; i++) addressBits |= addresses[i];
+	if(addressBits < memorySize) return simulator.accessBatch(addresses,operations,count,results,implementation->statistics);
+	// Otherwise simulate the runs of references between the rejected ones
+	size_t hits = 0;
+	size_t start = 0;
+	for(size_t i = 0; i <= count; i++) {
+		if(i < count && addresses[i] < memorySize) continue;
+		if(i > start) {
+			hits += simulator.accessBatch(addresses + start,operations ? operations + start : NULL,i - start,
+										  results ? results + start : NULL,implementation->statistics);
+		}
+		if(i < count) {
+			if(results) results[i] = 0;
+			implementation->rejected++;
+		}
+		start = i + 1;
+	}
+	return hits;
+}
+
+/*****************************************************************************
+Function name:    getStatistics
+Purpose:          Gets the counts of the references simulated so far
+Input parameters: none
+Return value:     CacheStatistics - the counts, hit rate and access time
+******************************************************************************/
+CacheStatistics CacheSimulator::getStatistics() const {
+	CacheStatistics result;
+	if(!implementation) return result;
+	const SimulationStatistics& statistics = implementation->statistics;
+	MemorySimulator& simulator = implementation->simulator;
+	result.references = statistics.references;
+	result.hits = statistics.hits;
+	result.victimHits = statistics.victimHits;
+	result.blocksRead = statistics.blocksRead;
+	result.dirtyEvictions = statistics.dirtyEvictions;
+	result.wordsWritten = statistics.wordsWritten;
+	result.prefetches = statistics.prefetches;
+	result.usefulPrefetches = statistics.usefulPrefetches;
+	result.rejected = implementation->rejected;
+	result.bytesRead = simulator.getBytesRead(statistics);
+	result.bytesWritten = simulator.getBytesWritten(statistics);
+	if(statistics.references > 0) {
+		result.hitRate = (double)statistics.hits/statistics.references*100;
+		result.averageAccessTime = simulator.getAverageAccessTime(statistics);
+	}
+	return result;
+}
+
+/*****************************************************************************
+Function name:    resetStatistics
+Purpose:          Zeroes the counts, keeping the cache's contents
+Input parameters: none
+Return value:     none
+******************************************************************************/
+void CacheSimulator::resetStatistics() {
+	if(implementation) {
+		implementation->statistics = SimulationStatistics();
+		implementation->rejected = 0;
+	}
+	return;
+}
+
+// The command line tools and main, which the library leaves to the program using it
+#ifndef MEM_SIMULATOR_LIBRARY
+/*****************************************************************************
+Function name:    convertTrace
+Purpose:          Converts a text memory reference file into the binary trace
+                  format
+Input parameters: inputFile - string - the text trace to read
+                  outputFile - string - the binary trace to write
+                  deltaEncoded - bool - whether to delta/varint encode records
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int convertTrace(string inputFile, string outputFile, bool deltaEncoded) {
+	TraceReader traceReader;						// Streams references out of the text trace
+	TraceWriter traceWriter;						// Encodes them into the binary trace
+	string error;
+	if(!traceReader.open(inputFile)) {
+		cerr << "Error: Input file: \"" << inputFile << "\" not found" << endl;
+		return 1;
+	}
+	// Any supported address is accepted, since the memory size is not known yet
+	if(!traceReader.validate(MAX_MEMORY_SIZE,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	// Records keeping instruction fetches have one bit less for the address
+	if(traceReader.hasFetches() && traceReader.getHighestAddress() >= MAX_FETCH_TRACE_ADDRESS) {
+		cerr << "Error: Traces with instruction fetches need every address below " << MAX_FETCH_TRACE_ADDRESS
+			 << " to be converted" << endl;
+		return 1;
+	}
+	if(!traceWriter.open(outputFile,deltaEncoded,traceReader.hasFetches(),traceReader.getNumCores() > 1)) {
+		cerr << "Error: Output file: \"" << outputFile << "\" could not be created" << endl;
+		return 1;
+	}
+	vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+	int chunkSize;
+	while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+		for(int i = 0; i < chunkSize; i++) {
+			traceWriter.write(chunk[i].memoryAddress,chunk[i].operation,chunk[i].core);
+		}
+	}
+	if(!traceWriter.close()) {
+		cerr << "Error: Output file: \"" << outputFile << "\" could not be written" << endl;
+		return 1;
+	}
+	cout << "Converted " << traceReader.getNumReferences() << " memory references" << endl;
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    sweepTrace
+Purpose:          Prints the LRU miss ratio curve of a trace for every cache
+                  size of one block size, from a single pass over the trace
+Input parameters: inputFile - string - the trace to analyze (text or binary)
+                  cacheBlockSize - int - the block size of every cache
+                  maxCacheSize - int - the largest cache size to report
+                  maxAssociativity - int - the largest set associativity
+                  sampleRate - double - the share of the blocks to analyze
+                                        (below 1 for a SHARDS estimate of the
+                                        fully associative caches)
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int sweepTrace(string inputFile, int cacheBlockSize, int maxCacheSize, int maxAssociativity, double sampleRate) {
+	TraceReader traceReader;						// Streams references out of the trace
+	string error;
+	if(cacheBlockSize < 1 || maxCacheSize < cacheBlockSize || maxAssociativity < 1
+	   || (cacheBlockSize & (cacheBlockSize - 1)) || (maxCacheSize & (maxCacheSize - 1))) {
+		cerr << "Error: Sizes must be powers of two, with the block size at most the cache size" << endl;
+		return 1;
+	}
+	if(!(sampleRate > 0 && sampleRate <= 1)) {
+		cerr << "Error: The sampling rate must be above 0 and at most 1" << endl;
+		return 1;
+	}
+	if(!traceReader.open(inputFile)) {
+		cerr << "Error: Input file: \"" << inputFile << "\" not found" << endl;
+		return 1;
+	}
+	if(!traceReader.validate(MAX_MEMORY_SIZE,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	StackDistanceAnalyzer analyzer(cacheBlockSize,maxCacheSize,maxAssociativity,sampleRate);
+	vector<MemoryReference> chunk(TRACE_CHUNK_SIZE);
+	int chunkSize;
+	while((chunkSize = traceReader.readChunk(chunk.data(),TRACE_CHUNK_SIZE)) > 0) {
+		for(int i = 0; i < chunkSize; i++) analyzer.access(chunk[i].memoryAddress);
+	}
+	analyzer.printMissRatioCurve();
+	return 0;
+}
+
+/*****************************************************************************
+Struct name:      BatchConfiguration
+Purpose:          Stores one cache configuration of a batch simulation and
+                  the results of simulating it
+******************************************************************************/
+struct BatchConfiguration {
+	int64_t memorySize;								// The size of main memory in bytes
+	int cacheSize;									// The size of the cache in bytes
+	int cacheBlockSize;								// The size of the cache blocks in bytes
+	int associativity;								// The degree of set-associativity
+	ReplacementPolicy policy;						// The cache's replacement policy
+	SimulationStatistics statistics;				// The results of the simulation
+	double seconds;									// The time taken to simulate the configuration
+};
+
+/*****************************************************************************
+Function name:    readBatchConfigurations
+Purpose:          Reads a file of cache configurations, one per line in the
+                  form "memory size, cache size, block size, associativity,
+                  policy (L, F, O or a name)" separated by spaces. Blank lines and lines
+                  starting with '#' are ignored
+Input parameters: configFile - string - the name of the configuration file
+                  configurations - vector<BatchConfiguration>& - filled with
+                                   the configurations read from the file
+Return value:     bool - true if every configuration is valid, false if not
+******************************************************************************/
+bool readBatchConfigurations(string configFile, vector<BatchConfiguration>& configurations) {
+	ifstream inputFile(configFile);
+	if(!inputFile) {
+		cerr << "Error: Configuration file: \"" << configFile << "\" not found" << endl;
+		return false;
+	}
+	string line;
+	for(int lineNumber = 1; getline(inputFile,line); lineNumber++) {
+		istringstream fields(line);
+		string policy;
+		BatchConfiguration configuration = BatchConfiguration();
+		if(!(fields >> policy) || policy[0] == '#') continue;	// Skip blank and comment lines
+		fields.clear();
+		fields.str(line);
+		fields >> configuration.memorySize >> configuration.cacheSize >> configuration.cacheBlockSize
+			   >> configuration.associativity >> policy;
+		int cacheBlocks = (configuration.cacheBlockSize > 0)
+						  ? configuration.cacheSize/configuration.cacheBlockSize : 0;
+		// Apply the same limits as the interactive prompts
+		if(fields.fail() || !parsePolicy(policy,configuration.policy)
+		   || !isPowerOfTwo(configuration.memorySize,4,MAX_MEMORY_SIZE)
+		   || !isPowerOfTwo(configuration.cacheSize,2,min(configuration.memorySize,(int64_t)MAX_CACHE_SIZE))
+		   || !isPowerOfTwo(configuration.cacheBlockSize,2,configuration.cacheSize)
+		   || !isPowerOfTwo(configuration.associativity,1,cacheBlocks)) {
+			cerr << "Error: Invalid configuration on line " << lineNumber << " of \"" << configFile << "\"" << endl;
+			return false;
+		}
+		configurations.push_back(configuration);
+	}
+	if(configurations.empty()) {
+		cerr << "Error: Configuration file must contain at least 1 configuration." << endl;
+		return false;
+	}
+	return true;
+}
+
+/*****************************************************************************
+Function name:    batchSimulate
+Purpose:          Simulates a trace on every cache configuration of a batch
+                  concurrently and prints a report of the results. The trace
+                  is mapped once and shared read-only by all of the workers,
+                  while each simulation has its own cache state and counters
+Input parameters: inputFile - string - the trace to simulate (text or binary)
+                  configFile - string - the file of cache configurations
+                  numThreads - int - the number of worker threads
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int batchSimulate(string inputFile, string configFile, int numThreads) {
+	vector<BatchConfiguration> configurations;
+	if(!readBatchConfigurations(configFile,configurations)) return 1;
+	// Every address must fit in the smallest main memory of the batch
+	int64_t smallestMemory = configurations[0].memorySize;
+	for(unsigned int i = 0; i < configurations.size(); i++) {
+		smallestMemory = min(smallestMemory,configurations[i].memorySize);
+	}
+	TraceReader traceReader;						// Owns the mapping shared by every worker
+	string error;
+	if(!traceReader.open(inputFile)) {
+		cerr << "Error: Input file: \"" << inputFile << "\" not found" << endl;
+		return 1;
+	}
+	if(!traceReader.validate(smallestMemory,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	WorkStealingPool pool(numThreads);
+	for(unsigned int i = 0; i < configurations.size(); i++) {
+		BatchConfiguration* configuration = &configurations[i];
+		pool.submit([configuration,&traceReader]() {
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			TraceReader workerReader;				// The worker's own cursor into the shared trace
+			workerReader.share(traceReader);
+			MemorySimulator simulator(configuration->memorySize,configuration->cacheSize,
+									  configuration->cacheBlockSize,configuration->associativity,
+									  configuration->policy);
+			configuration->statistics = simulator.simulate(workerReader,false);
+			configuration->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		});
+	}
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	pool.run();
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	// Print the results of every configuration in the order they were given
+	cout << "Batch simulation of " << traceReader.getNumReferences() << " memory references, "
+		 << configurations.size() << " configurations on " << max(numThreads,1) << " threads" << endl;
+	cout << setw(8) << "memory" << setw(8) << "cache" << setw(7) << "block" << setw(6) << "ways"
+		 << setw(10) << "policy" << setw(12) << "hits" << setw(11) << "hit rate" << setw(18) << "compulsory bound"
+		 << setw(11) << "seconds" << endl;
+	cout << string(91,'-') << endl;					// Print line to separate header from data
+	for(unsigned int i = 0; i < configurations.size(); i++) {
+		BatchConfiguration& configuration = configurations[i];
+		SimulationStatistics& statistics = configuration.statistics;
+		cout << setw(8) << configuration.memorySize << setw(8) << configuration.cacheSize
+			 << setw(7) << configuration.cacheBlockSize << setw(6) << configuration.associativity
+			 << setw(10) << policyName(configuration.policy) << setw(12) << statistics.hits
+			 << setw(10) << (float)statistics.hits/statistics.references*100 << "%"
+			 << setw(17) << (float)statistics.compulsoryBoundHits/statistics.references*100 << "%"
+			 << setw(11) << configuration.seconds << endl;
+	}
+	cout << "\nTotal time = " << seconds << " seconds ("
+		 << (double)traceReader.getNumReferences()*configurations.size()/seconds/1e6
+		 << " million references per second)" << endl;
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    parallelSimulate
+Purpose:          Simulates a trace on a single cache configuration with the
+                  cache sets split between worker threads, then prints the
+                  hit rates and the final state of the cache
+Input parameters: inputFile - string - the trace to simulate (text or binary)
+                  configuration - BatchConfiguration& - the cache to simulate
+                  numThreads - int - the number of worker threads
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int parallelSimulate(string inputFile, BatchConfiguration& configuration, int numThreads) {
+	TraceReader traceReader;
+	string error;
+	if(!traceReader.open(inputFile)) {
+		cerr << "Error: Input file: \"" << inputFile << "\" not found" << endl;
+		return 1;
+	}
+	if(!traceReader.validate(configuration.memorySize,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	MemorySimulator simulator(configuration.memorySize,configuration.cacheSize,configuration.cacheBlockSize,
+							  configuration.associativity,configuration.policy);
+	simulator.printMemoryInfo();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	SimulationStatistics statistics = simulator.simulateParallel(traceReader,numThreads);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "Compulsory-miss bound = " << statistics.compulsoryBoundHits << "/" << statistics.references
+		 << " = " << (float)statistics.compulsoryBoundHits/statistics.references*100 << "%" << endl;
+	cout << "Actual hit rate = " << statistics.hits << "/" << statistics.references
+		 << " = " << (float)statistics.hits/statistics.references*100 << "%" << endl;
+	simulator.printTraffic(statistics);
+	cout << "Simulated in " << seconds << " seconds on " << max(numThreads,1) << " threads" << endl << endl;
+	simulator.printCache();
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    parseLatencies
+Purpose:          Reads a level's latencies in the form "hit" or "hit/miss",
+                  where the miss latency defaults to the hit latency
+Input parameters: text - string - the latencies, for example "4" or "12/6"
+                  hitLatency - int& - set to the hit latency in cycles
+                  missLatency - int& - set to the miss latency in cycles
+Return value:     bool - true if the text holds valid latencies, false if not
+******************************************************************************/
+bool parseLatencies(string text, int& hitLatency, int& missLatency) {
+	char* end;
+	long hit = strtol(text.c_str(),&end,10);
+	long miss = hit;
+	if(end == text.c_str() || hit < 0 || hit > INT_MAX) return false;
+	if(*end == '/') {
+		const char* missText = end + 1;
+		miss = strtol(missText,&end,10);
+		if(end == missText || miss < 0 || miss > INT_MAX) return false;
+	}
+	if(*end != '\0') return false;
+	hitLatency = hit;
+	missLatency = miss;
+	return true;
+}
+
+/*****************************************************************************
+Function name:    parseVictimEntries
+Purpose:          Reads a level's victim cache in the form "VICTIM=n"
+Input parameters: text - string - the victim cache, for example "VICTIM=8"
+                  victimEntries - int& - set to the victim cache's blocks
+Return value:     bool - true if the text holds a valid victim cache, false
+                         if not
+******************************************************************************/
+bool parseVictimEntries(string text, int& victimEntries) {
+	if(strncasecmp(text.c_str(),"VICTIM=",7) != 0) return false;
+	char* end;
+	long entries = strtol(text.c_str() + 7,&end,10);
+	if(end == text.c_str() + 7 || *end != '\0' || entries < 1 || entries > MAX_VICTIM_ENTRIES) return false;
+	victimEntries = entries;
+	return true;
+}
+
+/*****************************************************************************
+Struct name:      TlbConfiguration
+Purpose:          Stores one TLB read from a hierarchy configuration file
+******************************************************************************/
+struct TlbConfiguration {
+	string name;									// The name of the TLB
+	int entries;									// The number of page translations held
+	int associativity;								// The number of entries per set
+	ReplacementPolicy policy;						// The TLB's replacement policy
+	int hitLatency;									// Cycles taken by a hit in the TLB
+	int missLatency;								// Cycles taken to detect a miss in the TLB
+};
+
+/*****************************************************************************
+Function name:    readHierarchyConfiguration
+Purpose:          Reads a file of cache hierarchy levels, one per line from
+                  the first level down in the form "name, cache size, block
+                  size, associativity, policy" followed by any of: an
+                  inclusion policy (INCLUSIVE, EXCLUSIVE or NINE, default
+                  NINE), a write policy (WB or WT, default WB), an allocation
+                  policy (WA or NWA, default WA), the latencies in cycles
+                  ("hit" or "hit/miss", default 1), an index function
+                  (MODULO, XOR, SKEWED or ZCACHE, default MODULO, the last
+                  two with LRU or FIFO) and a victim cache ("VICTIM=n", up to
+                  64 blocks, default none), separated by spaces. A
+                  level named L1I is an instruction cache beside the first
+                  data level, and a line "MEMORY latency" sets the memory
+                  latency (default 100). Every level must have the same block
+                  size. Lines "TLB name, entries, associativity, policy"
+                  with optional latencies add TLBs, first level first, which
+                  make every address virtual, and a line "PAGE size" sets
+                  their page size (4K, 2M or 1G, default 4K). Blank lines and
+                  lines starting with '#' are ignored
+Input parameters: configFile - string - the name of the configuration file
+                  hierarchy - unique_ptr<CacheHierarchy>& - set to the
+                              hierarchy described by the file
+Return value:     bool - true if every level is valid, false if not
+******************************************************************************/
+bool readHierarchyConfiguration(string configFile, unique_ptr<CacheHierarchy>& hierarchy) {
+	ifstream inputFile(configFile);
+	if(!inputFile) {
+		cerr << "Error: Configuration file: \"" << configFile << "\" not found" << endl;
+		return false;
+	}
+	string line;
+	int hierarchyBlockSize = 0;						// The block size of the first level read
+	int dataLevels = 0;
+	bool instructionCache = false;
+	int memoryLatency = 100;
+	vector<TlbConfiguration> tlbs;
+	int pageSize = 0;								// 4 KB pages by default
+	for(int lineNumber = 1; getline(inputFile,line); lineNumber++) {
+		istringstream fields(line);
+		string name, policyText, option;
+		int cacheSize = 0, cacheBlockSize = 0, associativity = 0;
+		int hitLatency = 1, missLatency = 1;
+		ReplacementPolicy policy = LRU;
+		InclusionPolicy inclusion = NINE;
+		WritePolicy writePolicy = WRITE_BACK;
+		WriteAllocation writeAllocation = WRITE_ALLOCATE;
+		IndexFunction index = MODULO_INDEX;
+		int victimEntries = 0;
+		if(!(fields >> name) || name[0] == '#') continue;	// Skip blank and comment lines
+		if(strcasecmp(name.c_str(),"MEMORY") == 0) {
+			if(!(fields >> memoryLatency) || memoryLatency < 0 || fields >> option) {
+				cerr << "Error: Invalid memory latency on line " << lineNumber << " of \"" << configFile
+					 << "\"" << endl;
+				return false;
+			}
+			continue;
+		}
+		if(strcasecmp(name.c_str(),"PAGE") == 0) {
+			if(!(fields >> option) || !parsePageSize(option,pageSize) || fields >> option) {
+				cerr << "Error: Invalid page size on line " << lineNumber << " of \"" << configFile
+					 << "\"" << endl;
+				return false;
+			}
+			continue;
+		}
+		if(strcasecmp(name.c_str(),"TLB") == 0) {
+			TlbConfiguration tlb;
+			tlb.hitLatency = tlb.missLatency = 1;
+			fields >> tlb.name >> tlb.entries >> tlb.associativity >> policyText;
+			bool validTlb = !fields.fail() && parsePolicy(policyText,tlb.policy) && tlb.policy != OPT
+							&& (!(fields >> option) || parseLatencies(option,tlb.hitLatency,tlb.missLatency))
+							&& !(fields >> option);
+			// The sets are indexed by the low bits of the page number
+			if(!validTlb || tlb.associativity < 1 || tlb.entries % tlb.associativity != 0
+			   || !isPowerOfTwo(tlb.entries/tlb.associativity,1,MAX_CACHE_SIZE)) {
+				cerr << "Error: Invalid TLB on line " << lineNumber << " of \"" << configFile << "\"" << endl;
+				return false;
+			}
+			tlbs.push_back(tlb);
+			continue;
+		}
+		fields >> cacheSize >> cacheBlockSize >> associativity >> policyText;
+		bool validOptions = !fields.fail();
+		while(validOptions && fields >> option) {	// The optional settings, in any order
+			validOptions = parseInclusion(option,inclusion) || parseWritePolicy(option,writePolicy)
+						   || parseWriteAllocation(option,writeAllocation)
+						   || parseLatencies(option,hitLatency,missLatency) || parseIndexFunction(option,index)
+						   || parseVictimEntries(option,victimEntries);
+		}
+		int cacheBlocks = (cacheBlockSize > 0) ? cacheSize/cacheBlockSize : 0;
+		bool isInstructionCache = strcasecmp(name.c_str(),"L1I") == 0;
+		// OPT is not supported, since each level's next uses depend on the levels above it, and
+		// skewed levels only compare their candidates' last uses or fills
+		bool skewed = (index == SKEWED_INDEX || index == ZCACHE_INDEX);
+		if(!validOptions || !parsePolicy(policyText,policy) || policy == OPT
+		   || (skewed && policy != LRU && policy != FIFO)
+		   || !isPowerOfTwo(cacheSize,2,MAX_CACHE_SIZE)
+		   || !isPowerOfTwo(cacheBlockSize,2,cacheSize)
+		   || !isPowerOfTwo(associativity,1,cacheBlocks)
+		   || (hierarchyBlockSize != 0 && cacheBlockSize != hierarchyBlockSize)
+		   || (isInstructionCache && instructionCache)) {
+			cerr << "Error: Invalid level on line " << lineNumber << " of \"" << configFile << "\"" << endl;
+			return false;
+		}
+		if(hierarchyBlockSize == 0) {
+			hierarchyBlockSize = cacheBlockSize;
+			hierarchy.reset(new CacheHierarchy(cacheBlockSize));
+		}
+		CacheLevel* level;
+		if(isInstructionCache) {
+			level = &hierarchy->addInstructionCache(name,cacheSize,associativity,policy);
+			instructionCache = true;
+		}
+		else {
+			level = &hierarchy->addLevel(name,cacheSize,associativity,policy,inclusion);
+			dataLevels++;
+		}
+		level->writePolicy = writePolicy;
+		level->writeAllocation = writeAllocation;
+		level->hitLatency = hitLatency;
+		level->missLatency = missLatency;
+		level->setOrganization(index,victimEntries);
+	}
+	if(dataLevels == 0) {
+		cerr << "Error: Configuration file must contain at least 1 data or unified level." << endl;
+		return false;
+	}
+	hierarchy->setMemoryLatency(memoryLatency);
+	if(!tlbs.empty()) {
+		AddressTranslator& translator = hierarchy->enableTranslation(pageSize);
+		for(unsigned int i = 0; i < tlbs.size(); i++) {
+			CacheLevel& tlb = translator.addTlb(tlbs[i].name,tlbs[i].entries,tlbs[i].associativity,tlbs[i].policy);
+			tlb.hitLatency = tlbs[i].hitLatency;
+			tlb.missLatency = tlbs[i].missLatency;
+		}
+	}
+	return true;
+}
+
+/*****************************************************************************
+Function name:    hierarchySimulate
+Purpose:          Simulates a trace on a multi-level cache hierarchy and
+                  prints the hit rate of every level
+Input parameters: inputFile - string - the trace to simulate (text or binary)
+                  configFile - string - the file of hierarchy levels
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int hierarchySimulate(string inputFile, string configFile) {
+	unique_ptr<CacheHierarchy> hierarchy;
+	if(!readHierarchyConfiguration(configFile,hierarchy)) return 1;
+	TraceReader traceReader;
+	string error;
+	if(!traceReader.open(inputFile)) {
+		cerr << "Error: Input file: \"" << inputFile << "\" not found" << endl;
+		return 1;
+	}
+	if(!traceReader.validate(MAX_MEMORY_SIZE,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	hierarchy->simulate(traceReader);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	hierarchy->printStatistics();
+	cout << "Simulated in " << seconds << " seconds" << endl;
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    coherenceSimulate
+Purpose:          Simulates the private caches of every core of a multi-core
+                  trace under a coherence protocol and prints the results
+Input parameters: inputFile - string - the trace to simulate (text or binary)
+                  protocol - CoherenceProtocol - the coherence protocol
+                  cacheSize - int - the size of each core's cache in bytes
+                  cacheBlockSize - int - the size of the cache blocks in bytes
+                  associativity - int - the number of cache blocks per set
+                  policy - ReplacementPolicy - the caches' replacement policy
+                  hotLines - int - the number of false sharing hot lines to
+                                   list, or 0 for every invalidated line
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int coherenceSimulate(string inputFile, CoherenceProtocol protocol, int cacheSize, int cacheBlockSize,
+					  int associativity, ReplacementPolicy policy, int hotLines) {
+	TraceReader traceReader;
+	string error;
+	if(!traceReader.open(inputFile)) {
+		cerr << "Error: Input file: \"" << inputFile << "\" not found" << endl;
+		return 1;
+	}
+	if(!traceReader.validate(MAX_MEMORY_SIZE,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	MultiCoreSystem system(traceReader.getNumCores(),cacheSize,cacheBlockSize,associativity,policy,protocol);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	system.simulate(traceReader);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	system.printStatistics(hotLines);
+	cout << "Simulated in " << seconds << " seconds" << endl;
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    generateTrace
+Purpose:          Writes a synthetic trace to a delta encoded binary trace
+                  file
+Input parameters: pattern - TracePattern - the access pattern to generate
+                  numReferences - int64_t - the references to generate
+                  footprint - int64_t - the bytes of memory referenced
+                  outputFile - string - the binary trace to create
+                  elementSize - int - the bytes in each element (the stride)
+                  writePercent - int - the percentage of writes
+                  seed - uint64_t - the seed of the random choices
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int generateTrace(TracePattern pattern, int64_t numReferences, int64_t footprint, string outputFile,
+				  int elementSize, int writePercent, uint64_t seed) {
+	TraceGenerator generator(pattern,footprint,elementSize,writePercent,seed);
+	TraceWriter traceWriter;
+	if(!traceWriter.open(outputFile,true)) {
+		cerr << "Error: Output file: \"" << outputFile << "\" could not be created" << endl;
+		return 1;
+	}
+	int64_t memoryAddress;
+	ReadWrite operation;
+	for(int64_t i = 0; i < numReferences; i++) {
+		generator.next(memoryAddress,operation);
+		traceWriter.write(memoryAddress,operation);
+	}
+	if(!traceWriter.close()) {
+		cerr << "Error: Output file: \"" << outputFile << "\" could not be written" << endl;
+		return 1;
+	}
+	cout << "Generated " << numReferences << " " << PATTERN_NAMES[pattern] << " memory references" << endl;
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    runBenchmark
+Purpose:          Times one benchmark, repeating passes over its references
+                  until it has run for long enough to measure, and prints
+                  its row of the benchmark table
+Input parameters: name - const string& - the benchmark's name
+                  filter - const string& - only benchmarks whose names
+                                           contain this text are run
+                  numReferences - int64_t - the references in one pass
+                  pass - function<int64_t()> - runs one pass and returns its
+                                               hits
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+void runBenchmark(const string& name, const string& filter, int64_t numReferences, function<int64_t()> pass) {
+	if(name.find(filter) == string::npos) return;
+	int64_t hits = 0;
+	int64_t passes = 0;
+	double seconds;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	do {
+		hits += pass();
+		passes++;
+		seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	} while(seconds < MIN_BENCHMARK_SECONDS);
+	double references = (double)numReferences*passes;
+	cout << left << setw(56) << name << right << setw(12) << seconds/references*1e9 << setw(14)
+		 << (int64_t)(references/seconds) << setw(10) << passes << setw(12) << hits/references*100 << "%" << endl;
+	return;
+}
+
+/*****************************************************************************
+Function name:    benchmarkSimulator
+Purpose:          Measures the references per second simulated by the cache
+                  set access, the simulation step and whole-trace replay,
+                  over every replacement policy, several associativities
+                  and set counts and every synthetic trace pattern
+Input parameters: numReferences - int64_t - the references in each pass
+                  filter - string - only benchmarks whose names contain this
+                                    text are run
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int benchmarkSimulator(int64_t numReferences, string filter) {
+	const int BLOCK_SIZE = 64;						// Block size of every benchmarked cache
+	const int WAYS[3] = {1,4,16};					// Associativities of the cache set benchmarks
+	const int SETS[3] = {64,1024,16384};			// Set counts of the cache set benchmarks
+	const int STEP_CACHE_SIZE = 32768;				// Cache of the simulation step and replay
+	const int STEP_WAYS = 8;						// benchmarks, run over a footprint 32 times
+	const int64_t STEP_FOOTPRINT = 32*STEP_CACHE_SIZE;	// its size
+	const int64_t MEMORY_SIZE = (int64_t)1 << 32;
+	char traceFile[] = "/tmp/mem_simulator_bench_XXXXXX";
+	int fileDescriptor = mkstemp(traceFile);
+	if(fileDescriptor < 0) {
+		cerr << "Error: The benchmark trace could not be created" << endl;
+		return 1;
+	}
+	close(fileDescriptor);
+	string error;
+	cout << left << setw(56) << "Benchmark" << right << setw(12) << "ns/ref" << setw(14) << "refs/s"
+		 << setw(10) << "passes" << setw(13) << "hit rate" << endl;
+	cout << string(105,'-') << endl;				// Print line to separate header from data
+	vector<int> setNumbers(numReferences);
+	vector<int64_t> tags(numReferences);
+	vector<int64_t> addresses(numReferences);
+	vector<ReadWrite> operations(numReferences);
+	// The cache set is driven directly by Zipfian references over four times its capacity
+	for(int policy = 0; policy < NUM_POLICIES; policy++) {
+		if(policy == OPT) continue;					// OPT needs next uses from a trace
+		for(int ways = 0; ways < 3; ways++) {
+			for(int sets = 0; sets < 3; sets++) {
+				string name = string("CacheSet::access/") + POLICY_NAMES[policy] + "/" + to_string(WAYS[ways])
+							  + "-way/" + to_string(SETS[sets]) + "-sets";
+				if(name.find(filter) == string::npos) continue;
+				TraceGenerator generator(ZIPFIAN,4*(int64_t)SETS[sets]*WAYS[ways]*BLOCK_SIZE,BLOCK_SIZE,25,1);
+				for(int64_t i = 0; i < numReferences; i++) {
+					generator.next(addresses[i],operations[i]);
+					int64_t memoryBlockNumber = addresses[i]/BLOCK_SIZE;
+					setNumbers[i] = (int)(memoryBlockNumber & (SETS[sets] - 1));
+					tags[i] = memoryBlockNumber >> log2(SETS[sets]);
+				}
+				CacheStorage storage(SETS[sets],WAYS[ways],(ReplacementPolicy)policy);
+				runBenchmark(name,filter,numReferences,[&]() {
+					int64_t hits = 0;
+					for(int64_t i = 0; i < numReferences; i++) {
+						CacheSet cacheSet(storage,setNumbers[i]);
+						hits += (cacheSet.access(tags[i],operations[i]) == HIT);
+					}
+					return hits;
+				});
+			}
+		}
+	}
+	// The simulation step adds the address split, write policy and traffic counts
+	for(int pattern = 0; pattern < NUM_PATTERNS; pattern++) {
+		TraceGenerator generator((TracePattern)pattern,STEP_FOOTPRINT,BLOCK_SIZE,25,1);
+		for(int64_t i = 0; i < numReferences; i++) generator.next(addresses[i],operations[i]);
+		for(int policy = 0; policy < NUM_POLICIES; policy++) {
+			if(policy == OPT) continue;
+			string name = string("MemorySimulator::simulationStep/") + PATTERN_NAMES[pattern] + "/"
+						  + POLICY_NAMES[policy];
+			if(name.find(filter) == string::npos) continue;
+			MemorySimulator simulator(MEMORY_SIZE,STEP_CACHE_SIZE,BLOCK_SIZE,STEP_WAYS,(ReplacementPolicy)policy);
+			runBenchmark(name,filter,numReferences,[&]() {
+				SimulationStatistics statistics;
+				for(int64_t i = 0; i < numReferences; i++) simulator.access(addresses[i],operations[i],statistics);
+				return statistics.hits;
+			});
+		}
+	}
+	// The library's batched access chooses the policy and geometry once for every batch
+	vector<uint64_t> batchAddresses(numReferences);
+	vector<uint8_t> batchOperations(numReferences);
+	for(int pattern = 0; pattern < NUM_PATTERNS; pattern++) {
+		TraceGenerator generator((TracePattern)pattern,STEP_FOOTPRINT,BLOCK_SIZE,25,1);
+		for(int64_t i = 0; i < numReferences; i++) {
+			generator.next(addresses[i],operations[i]);
+			batchAddresses[i] = addresses[i];
+			batchOperations[i] = operations[i];
+		}
+		for(int policy = 0; policy < NUM_POLICIES; policy++) {
+			if(policy == OPT) continue;
+			string name = string("CacheSimulator::access/") + PATTERN_NAMES[pattern] + "/" + POLICY_NAMES[policy];
+			if(name.find(filter) == string::npos) continue;
+			CacheConfiguration configuration;
+			configuration.memorySize = MEMORY_SIZE;
+			configuration.cacheSize = STEP_CACHE_SIZE;
+			configuration.cacheBlockSize = BLOCK_SIZE;
+			configuration.associativity = STEP_WAYS;
+			configuration.policy = POLICY_NAMES[policy];
+			CacheSimulator simulator;
+			string error;
+			simulator.configure(configuration,error);
+			runBenchmark(name,filter,numReferences,[&]() {
+				return (int64_t)simulator.access(batchAddresses.data(),batchOperations.data(),numReferences,NULL);
+			});
+		}
+	}
+	// Replay adds reading the trace file and counting the distinct blocks for the compulsory-miss bound
+	const ReplacementPolicy REPLAY_POLICIES[2] = {LRU,OPT};
+	for(int pattern = 0; pattern < NUM_PATTERNS; pattern++) {
+		for(int policy = 0; policy < 2; policy++) {
+			string name = string("MemorySimulator::simulate/") + PATTERN_NAMES[pattern] + "/"
+						  + POLICY_NAMES[REPLAY_POLICIES[policy]];
+			if(name.find(filter) == string::npos) continue;
+			TraceGenerator generator((TracePattern)pattern,STEP_FOOTPRINT,BLOCK_SIZE,25,1);
+			TraceWriter traceWriter;
+			TraceReader traceReader;
+			bool written = traceWriter.open(traceFile,true);
+			for(int64_t i = 0; i < numReferences; i++) {
+				generator.next(addresses[i],operations[i]);
+				traceWriter.write(addresses[i],operations[i]);
+			}
+			written = traceWriter.close() && written;
+			if(!written || !traceReader.open(traceFile) || !traceReader.validate(MEMORY_SIZE,error)) {
+				cerr << "Error: The benchmark trace could not be written" << endl;
+				unlink(traceFile);
+				return 1;
+			}
+			MemorySimulator simulator(MEMORY_SIZE,STEP_CACHE_SIZE,BLOCK_SIZE,STEP_WAYS,REPLAY_POLICIES[policy]);
+			runBenchmark(name,filter,numReferences,[&]() {
+				return simulator.simulate(traceReader,false).hits;
+			});
+		}
+	}
+	unlink(traceFile);
+	return 0;
+}
+
+/*****************************************************************************
+Struct name:      SimulationOptions
+Purpose:          Stores the settings of a non-interactive simulation, read
+                  from the command line and / or a configuration file
+******************************************************************************/
+struct SimulationOptions {
+	int64_t memorySize = 32768;						// The size of main memory in bytes
+	int cacheSize = 1024;							// The size of the cache in bytes
+	int cacheBlockSize = 16;						// The size of the cache blocks in bytes
+	int associativity = 1;							// The degree of set-associativity
+	ReplacementPolicy policy = LRU;					// The cache's replacement policy
+	string traceFile;								// The trace to simulate (text or binary)
+	string format = "text";							// Output format: text, csv or json
+	bool printSteps = false;						// Whether to print the per-reference table
+	bool quiet = false;								// Whether to print only the hit rates
+	bool optimal = false;							// Whether to replay the trace under OPT as well,
+													// for the best achievable hit rate
+	int numThreads = 1;								// Worker threads (set-partitioned if above 1)
+	uint64_t seed = 1;								// Seed of the random replacement policies
+	WritePolicy writePolicy = WRITE_BACK;			// Whether writes are written back or through
+	WriteAllocation writeAllocation = WRITE_ALLOCATE;	// Whether write misses fill the block
+	int hitLatency = 1;								// Cycles taken by a cache hit
+	int missLatency = -1;							// Cycles taken to detect a miss (-1 for the
+													// hit latency)
+	int memoryLatency = 100;						// Cycles taken to read a block from memory
+	PrefetcherType prefetcher = NO_PREFETCHER;		// The hardware prefetcher, if any
+	int prefetchDegree = 1;							// The blocks requested by one prediction
+	int prefetchDistance = 1;						// How far ahead the first requested block is
+	int classifyTop = 0;							// Blocks and sets with most misses to list when
+													// classifying misses (0 to not classify)
+	double sampleRate = 1;							// The share of the cache sets simulated
+	int intervalLength = 0;							// References per recorded interval (0 for none)
+	string intervalFile;							// Where to write the intervals, if not with the
+													// results
+	int64_t fastForward = 0;						// References that only warm the cache
+	int64_t stopReference = -1;						// References simulated in all (-1 for every one)
+	string checkpointFile;							// Where to save the state at the end, if anywhere
+	string restoreFile;								// The checkpoint to resume from, if any
+	IndexFunction index = MODULO_INDEX;				// How a block number picks its cache set
+	int victimEntries = 0;							// Blocks in the victim cache (0 for none)
+};
+
+/*****************************************************************************
+Function name:    setOption
+Purpose:          Sets one simulation option from its name and text value
+Input parameters: name - string - the option's name (without leading dashes)
+                  value - string - the option's value
+                  options - SimulationOptions& - the options to update
+                  error - string& - set to a description of any error
+Return value:     bool - true if the option was set, false if not
+******************************************************************************/
+bool setOption(string name, string value, SimulationOptions& options, string& error) {
+	char* end;										// Checks that numeric values are whole numbers
+	long long number = strtoll(value.c_str(),&end,10);
+	bool isNumber = !value.empty() && *end == '\0' && number >= INT_MIN && number <= INT_MAX;
+	bool isSize = !value.empty() && *end == '\0';	// Memory sizes may exceed an int
+	ReplacementPolicy policy;
+	WritePolicy writePolicy;
+	WriteAllocation writeAllocation;
+	PrefetcherType prefetcher;
+	IndexFunction index;
+	if(name == "trace") options.traceFile = value;
+	else if(name == "format" && (value == "text" || value == "csv" || value == "json")) options.format = value;
+	else if(name == "policy" && parsePolicy(value,policy)) options.policy = policy;
+	else if(name == "write" && parseWritePolicy(value,writePolicy)) options.writePolicy = writePolicy;
+	else if(name == "allocate" && parseWriteAllocation(value,writeAllocation)) options.writeAllocation = writeAllocation;
+	else if(name == "prefetch" && parsePrefetcher(value,prefetcher)) options.prefetcher = prefetcher;
+	else if(name == "index" && parseIndexFunction(value,index)) options.index = index;
+	else if(name == "steps" && (value == "on" || value == "off")) options.printSteps = (value == "on");
+	else if(name == "quiet" && (value == "on" || value == "off")) options.quiet = (value == "on");
+	else if(name == "optimal" && (value == "on" || value == "off")) options.optimal = (value == "on");
+	else if(isSize && name == "memory") options.memorySize = number;
+	else if(isNumber && name == "cache") options.cacheSize = number;
+	else if(isNumber && name == "block") options.cacheBlockSize = number;
+	else if(isNumber && name == "ways") options.associativity = number;
+	else if(isNumber && name == "threads" && number >= 1) options.numThreads = number;
+	else if(isSize && name == "seed" && number >= 0) options.seed = number;
+	else if(isNumber && name == "hit-latency" && number >= 0) options.hitLatency = number;
+	else if(isNumber && name == "miss-latency" && number >= 0) options.missLatency = number;
+	else if(isNumber && name == "memory-latency" && number >= 0) options.memoryLatency = number;
+	else if(isNumber && name == "prefetch-degree" && number >= 1 && number <= MAX_PREFETCH_DEGREE) {
+		options.prefetchDegree = number;
+	}
+	else if(isNumber && name == "prefetch-distance" && number >= 1) options.prefetchDistance = number;
+	else if(isNumber && name == "classify" && number >= 0) options.classifyTop = number;
+	else if(isNumber && name == "interval" && number >= 0) options.intervalLength = number;
+	else if(isNumber && name == "victim" && number >= 0 && number <= MAX_VICTIM_ENTRIES) {
+		options.victimEntries = number;
+	}
+	else if(name == "interval-file") options.intervalFile = value;
+	else if(isSize && name == "fast-forward" && number >= 0) options.fastForward = number;
+	else if(isSize && name == "stop" && number >= 0) options.stopReference = number;
+	else if(name == "checkpoint") options.checkpointFile = value;
+	else if(name == "restore") options.restoreFile = value;
+	else if(name == "sample" && strtod(value.c_str(),&end) > 0 && strtod(value.c_str(),NULL) <= 1 && *end == '\0') {
+		options.sampleRate = strtod(value.c_str(),NULL);
+	}
+	else {
+		error = "Invalid option: " + name + " = " + value;
+		return false;
+	}
+	return true;
+}
+
+/*****************************************************************************
+Function name:    readConfigFile
+Purpose:          Reads simulation options from a file of "name = value"
+                  lines, using the same names as the command line options.
+                  Blank lines and lines starting with '#' are ignored
+Input parameters: configFile - string - the name of the configuration file
+                  options - SimulationOptions& - the options to update
+                  error - string& - set to a description of any error
+Return value:     bool - true if every option was read, false if not
+******************************************************************************/
+bool readConfigFile(string configFile, SimulationOptions& options, string& error) {
+	ifstream inputFile(configFile);
+	if(!inputFile) {
+		error = "Configuration file: \"" + configFile + "\" not found";
+		return false;
+	}
+	string line;
+	for(int lineNumber = 1; getline(inputFile,line); lineNumber++) {
+		size_t first = line.find_first_not_of(" \t\r");
+		if(first == string::npos || line[first] == '#') continue;	// Skip blank and comment lines
+		size_t equals = line.find('=');
+		if(equals == string::npos) {
+			error = "Expected \"name = value\" on line " + to_string(lineNumber) + " of \"" + configFile + "\"";
+			return false;
+		}
+		// Trim the spaces around the name and the value
+		string name = line.substr(first,equals - first);
+		string value = line.substr(equals + 1);
+		name.erase(name.find_last_not_of(" \t") + 1);
+		value.erase(0,value.find_first_not_of(" \t"));
+		value.erase(value.find_last_not_of(" \t\r") + 1);
+		if(!setOption(name,value,options,error)) {
+			error += " on line " + to_string(lineNumber) + " of \"" + configFile + "\"";
+			return false;
+		}
+	}
+	return true;
+}
+
+/*****************************************************************************
+Function name:    parseCommandLine
+Purpose:          Reads simulation options from the command line. Options are
+                  applied in order, so options after '--config' override the
+                  values in the configuration file
+Input parameters: argc - int - the number of command line arguments
+                  argv - char*[] - the command line arguments
+                  options - SimulationOptions& - the options to update
+                  error - string& - set to a description of any error
+Return value:     bool - true if every option was read, false if not
+******************************************************************************/
+bool parseCommandLine(int argc, char* argv[], SimulationOptions& options, string& error) {
+	for(int i = 1; i < argc; i++) {
+		string argument = argv[i];
+		// Switches without a value
+		if(argument == "--steps" || argument == "--quiet" || argument == "--optimal" || argument == "--no-steps") {
+			setOption(argument.substr(argument.rfind('-') + 1),(argument == "--no-steps") ? "off" : "on",
+					  options,error);
+			continue;
+		}
+		if(argument.compare(0,2,"--") != 0 || i + 1 == argc) {
+			error = "Expected an option and a value at \"" + argument + "\"";
+			return false;
+		}
+		string value = argv[++i];
+		if(argument == "--config") {
+			if(!readConfigFile(value,options,error)) return false;
+		}
+		else if(!setOption(argument.substr(2),value,options,error)) return false;
+	}
+	if(options.traceFile.empty()) {
+		error = "No trace file given (--trace)";
+		return false;
+	}
+	// Apply the same limits as the interactive prompts
+	if(!isPowerOfTwo(options.memorySize,4,MAX_MEMORY_SIZE)
+	   || !isPowerOfTwo(options.cacheSize,2,min(options.memorySize,(int64_t)MAX_CACHE_SIZE))
+	   || !isPowerOfTwo(options.cacheBlockSize,2,options.cacheSize)
+	   || !isPowerOfTwo(options.associativity,1,options.cacheSize/options.cacheBlockSize)) {
+		error = "Sizes must be powers of two with block size <= cache size <= memory size <= 2^62, "
+				"cache size <= 2^30 and associativity <= cache size / block size";
+		return false;
+	}
+	if(options.printSteps && (options.format != "text" || options.numThreads > 1)) {
+		error = "The per-reference table (--steps) needs text output and a single thread";
+		return false;
+	}
+	if(options.sampleRate < 1 && (options.printSteps || options.prefetcher != NO_PREFETCHER
+									|| options.classifyTop > 0 || options.intervalLength > 0)) {
+		error = "Set sampling (--sample) cannot be used with --steps, prefetchers, --classify or --interval, "
+				"which follow references across every set";
+		return false;
+	}
+	bool checkpointing = !options.checkpointFile.empty() || !options.restoreFile.empty();
+	if(options.sampleRate < 1 && (checkpointing || options.fastForward > 0 || options.stopReference >= 0)) {
+		error = "Set sampling (--sample) cannot be used with --fast-forward, --stop, --checkpoint or --restore";
+		return false;
+	}
+	// The prefetcher's and the miss classifier's tables are not part of a checkpoint, and the miss
+	// classifier would count the misses of the references warming the cache
+	if(options.prefetcher != NO_PREFETCHER && checkpointing) {
+		error = "Prefetchers cannot be used with --checkpoint or --restore, which do not save their tables";
+		return false;
+	}
+	if(options.classifyTop > 0 && (checkpointing || options.fastForward > 0)) {
+		error = "Miss classification (--classify) cannot be used with --fast-forward, --checkpoint or --restore";
+		return false;
+	}
+	// Skewed caches have no sets for the kernels, the prefetcher or the classifier to work on
+	if(options.index == SKEWED_INDEX || options.index == ZCACHE_INDEX) {
+		error = "The SKEWED and ZCACHE index functions are only supported by hierarchy levels; "
+				"use MODULO or XOR (--index)";
+		return false;
+	}
+	// The victim cache is shared by every set, is not part of a checkpoint, and would take the
+	// blocks a prefetch replaces
+	if(options.victimEntries > 0 && (options.sampleRate < 1 || checkpointing
+									 || options.prefetcher != NO_PREFETCHER)) {
+		error = "A victim cache (--victim) cannot be used with --sample, --checkpoint, --restore or prefetchers";
+		return false;
+	}
+	if(options.stopReference >= 0 && options.fastForward > options.stopReference) {
+		error = "The fast-forward (--fast-forward) cannot go past the stop point (--stop)";
+		return false;
+	}
+	if(!options.intervalFile.empty() && options.intervalLength == 0) {
+		error = "An interval file (--interval-file) needs the interval length (--interval)";
+		return false;
+	}
+	if(options.prefetcher != NO_PREFETCHER && options.policy == OPT) {
+		error = "OPT cannot be used with a prefetcher, since prefetched blocks have no known next use";
+		return false;
+	}
+	return true;
+}
+
+/*****************************************************************************
+Function name:    runWithOptions
+Purpose:          Runs a simulation without any prompts and prints the results
+                  in the requested format
+Input parameters: options - SimulationOptions& - the simulation settings
+Return value:     int - returns 0 on success, 1 on any error
+******************************************************************************/
+int runWithOptions(SimulationOptions& options) {
+	TraceReader traceReader;
+	string error;
+	if(!traceReader.open(options.traceFile)) {
+		cerr << "Error: Input file: \"" << options.traceFile << "\" not found" << endl;
+		return 1;
+	}
+	if(!traceReader.validate(options.memorySize,error)) {
+		cerr << "Error: " << error << endl;
+		return 1;
+	}
+	MemorySimulator simulator(options.memorySize,options.cacheSize,options.cacheBlockSize,
+							  options.associativity,options.policy);
+	simulator.setSeed(options.seed);
+	simulator.setWritePolicy(options.writePolicy,options.writeAllocation);
+	simulator.setLatencies(options.hitLatency,(options.missLatency < 0) ? options.hitLatency : options.missLatency,
+						   options.memoryLatency);
+	simulator.setPrefetcher(options.prefetcher,options.prefetchDegree,options.prefetchDistance);
+	simulator.setOrganization(options.index,options.victimEntries);
+	simulator.setMissClassification(options.classifyTop);
+	simulator.setSampling(options.sampleRate);
+	simulator.setIntervals(options.intervalLength);
+	simulator.setRange(options.fastForward,options.stopReference);
+	bool text = (options.format == "text");
+	if(!options.restoreFile.empty()) {			// Resume from the checkpoint's state and position
+		ifstream restoreInput(options.restoreFile,ios::binary);
+		if(!restoreInput) {
+			cerr << "Error: Checkpoint file: \"" << options.restoreFile << "\" not found" << endl;
+			return 1;
+		}
+		if(!simulator.restoreCheckpoint(restoreInput,error)) {
+			cerr << "Error: " << error << " (\"" << options.restoreFile << "\")" << endl;
+			return 1;
+		}
+		if(simulator.getFirstReference() > traceReader.getNumReferences()) {
+			cerr << "Error: The checkpoint was taken after reference " << simulator.getFirstReference()
+				 << ", past the end of the trace" << endl;
+			return 1;
+		}
+	}
+	ofstream checkpointOutput;
+	if(!options.checkpointFile.empty()) {
+		checkpointOutput.open(options.checkpointFile,ios::binary);
+		if(!checkpointOutput) {
+			cerr << "Error: Checkpoint file: \"" << options.checkpointFile << "\" cannot be written" << endl;
+			return 1;
+		}
+		simulator.setCheckpoint(&checkpointOutput);
+	}
+	int64_t lastReference = traceReader.getNumReferences();
+	if(options.stopReference >= 0) lastReference = min(options.stopReference,lastReference);
+	if(max(options.fastForward,simulator.getFirstReference()) >= lastReference) {
+		// Nothing is left to count, which only makes sense to warm the cache up to a checkpoint
+		if(!checkpointOutput.is_open()) {
+			cerr << "Error: No references are left to simulate after the fast-forward or checkpoint" << endl;
+			return 1;
+		}
+		simulator.simulate(traceReader,false);
+		if(!checkpointOutput.flush()) {
+			cerr << "Error: Checkpoint file: \"" << options.checkpointFile << "\" cannot be written" << endl;
+			return 1;
+		}
+		if(text && !options.quiet) {
+			cout << "Checkpoint after reference " << lastReference << " written to \"" << options.checkpointFile
+				 << "\"" << endl;
+		}
+		return 0;
+	}
+	// Intervals written to their own file are CSV unless the results are JSON, and are otherwise
+	// written with the results in their format
+	ofstream intervalOutput;
+	if(!options.intervalFile.empty()) {
+		intervalOutput.open(options.intervalFile);
+		if(!intervalOutput) {
+			cerr << "Error: Interval file: \"" << options.intervalFile << "\" cannot be written" << endl;
+			return 1;
+		}
+	}
+	bool separateIntervals = intervalOutput.is_open();
+	if(text && !options.quiet) simulator.printMemoryInfo();
+	SimulationStatistics statistics;
+	if(options.printSteps) {						// The full interactive style report
+		simulator.runSimulation(traceReader,options.optimal);
+		if(checkpointOutput.is_open() && !checkpointOutput.flush()) {
+			cerr << "Error: Checkpoint file: \"" << options.checkpointFile << "\" cannot be written" << endl;
+			return 1;
+		}
+		if(!options.quiet) simulator.printCache();
+		if(separateIntervals) simulator.printIntervals(intervalOutput,"csv");
+		return 0;
+	}
+	statistics = simulator.simulateParallel(traceReader,options.numThreads);
+	if(checkpointOutput.is_open() && !checkpointOutput.flush()) {
+		cerr << "Error: Checkpoint file: \"" << options.checkpointFile << "\" cannot be written" << endl;
+		return 1;
+	}
+	if(separateIntervals) simulator.printIntervals(intervalOutput,(options.format == "json") ? "json" : "csv");
+	// The OPT bound replays the whole trace again, so it is only found when asked for
+	int64_t optimalHits = options.optimal ? simulator.calculateOptimalHitCount(traceReader) : 0;
+	float boundRate = (float)statistics.compulsoryBoundHits/statistics.references*100;
+	float optimalRate = (float)optimalHits/statistics.references*100;
+	float hitRate = (float)statistics.hits/statistics.references*100;
+	string policy = policyName(options.policy);
+	string writeMode = string(WRITE_POLICY_NAMES[options.writePolicy]) + "/"
+					   + WRITE_ALLOCATION_NAMES[options.writeAllocation];
+	if(text) {
+		cout << "Compulsory-miss bound = " << statistics.compulsoryBoundHits << "/" << statistics.references
+			 << " = " << boundRate << "%" << endl;
+		if(options.optimal) {
+			cout << "Optimal (OPT) hit rate = " << optimalHits << "/" << statistics.references
+				 << " = " << optimalRate << "%" << endl;
+		}
+		cout << "Actual hit rate = " << statistics.hits << "/" << statistics.references
+			 << " = " << hitRate << "%" << endl;
+		simulator.printTraffic(statistics);
+		cout << endl;
+		simulator.printMissClassification(statistics);
+		if(!options.quiet && !separateIntervals) simulator.printIntervals(cout,"text");
+		if(!options.quiet) simulator.printCache();
+	}
+	else if(options.format == "csv") {
+		if(!options.quiet) cout << "memory,cache,block,ways,policy,references,hits,hit_rate,compulsory_bound_hits,"
+								   "compulsory_bound_hit_rate,"
+								   "optimal_hits,optimal_hit_rate,write_mode,dirty_evictions,bytes_read,"
+								   "bytes_written,amat,prefetcher,prefetches,useful_prefetches,late_prefetches,"
+								   "pollution_misses,prefetch_accuracy,prefetch_coverage,compulsory_misses,"
+								   "capacity_misses,conflict_misses,sampled_sets,sampled_references,"
+								   "hit_rate_error,index,victim_entries,victim_hits\n";
+		cout << options.memorySize << "," << options.cacheSize << "," << options.cacheBlockSize << ","
+			 << options.associativity << "," << policy << "," << statistics.references << ","
+			 << statistics.hits << "," << hitRate << "," << statistics.compulsoryBoundHits << "," << boundRate << ",";
+		// The OPT bound is left empty unless it was asked for
+		if(options.optimal) cout << optimalHits << "," << optimalRate;
+		else cout << ",";
+		cout << "," << writeMode << "," << statistics.dirtyEvictions << ","
+			 << simulator.getBytesRead(statistics) << "," << simulator.getBytesWritten(statistics) << ","
+			 << simulator.getAverageAccessTime(statistics) << "," << PREFETCHER_NAMES[options.prefetcher] << ","
+			 << statistics.prefetches << "," << statistics.usefulPrefetches << "," << statistics.latePrefetches << ","
+			 << statistics.pollutionMisses << "," << simulator.getPrefetchAccuracy(statistics) << ","
+			 << simulator.getPrefetchCoverage(statistics) << ",";
+		// The miss classes are left empty when misses are not classified
+		if(options.classifyTop > 0) {
+			cout << statistics.compulsoryMisses << "," << statistics.capacityMisses << ","
+				 << statistics.conflictMisses;
+		}
+		else cout << ",,";
+		cout << "," << simulator.getSampledSets() << "," << (statistics.sampledReferences ? statistics.sampledReferences
+			 : statistics.references) << "," << statistics.hitRateError << "," << INDEX_NAMES[options.index] << ","
+			 << options.victimEntries << "," << statistics.victimHits << endl;
+		// The intervals follow the results as a second table, after a blank line
+		if(!separateIntervals && options.intervalLength > 0) {
+			cout << endl;
+			simulator.printIntervals(cout,"csv");
+		}
+	}
+	else {
+		cout << "{\"memory\": " << options.memorySize << ", \"cache\": " << options.cacheSize
+			 << ", \"block\": " << options.cacheBlockSize << ", \"ways\": " << options.associativity
+			 << ", \"policy\": \"" << policy << "\", \"references\": " << statistics.references
+			 << ", \"hits\": " << statistics.hits << ", \"hit_rate\": " << hitRate
+			 << ", \"compulsory_bound_hits\": " << statistics.compulsoryBoundHits
+			 << ", \"compulsory_bound_hit_rate\": " << boundRate;
+		// The OPT bound is null unless it was asked for
+		if(options.optimal) cout << ", \"optimal_hits\": " << optimalHits << ", \"optimal_hit_rate\": " << optimalRate;
+		else cout << ", \"optimal_hits\": null, \"optimal_hit_rate\": null";
+		cout << ", \"write_mode\": \"" << writeMode << "\", \"dirty_evictions\": " << statistics.dirtyEvictions
+			 << ", \"bytes_read\": " << simulator.getBytesRead(statistics)
+			 << ", \"bytes_written\": " << simulator.getBytesWritten(statistics)
+			 << ", \"amat\": " << simulator.getAverageAccessTime(statistics)
+			 << ", \"prefetcher\": \"" << PREFETCHER_NAMES[options.prefetcher] << "\", \"prefetches\": "
+			 << statistics.prefetches << ", \"useful_prefetches\": " << statistics.usefulPrefetches
+			 << ", \"late_prefetches\": " << statistics.latePrefetches
+			 << ", \"pollution_misses\": " << statistics.pollutionMisses
+			 << ", \"prefetch_accuracy\": " << simulator.getPrefetchAccuracy(statistics)
+			 << ", \"prefetch_coverage\": " << simulator.getPrefetchCoverage(statistics);
+		// The miss classes are null when misses are not classified
+		if(options.classifyTop > 0) {
+			cout << ", \"compulsory_misses\": " << statistics.compulsoryMisses
+				 << ", \"capacity_misses\": " << statistics.capacityMisses
+				 << ", \"conflict_misses\": " << statistics.conflictMisses;
+		}
+		else cout << ", \"compulsory_misses\": null, \"capacity_misses\": null, \"conflict_misses\": null";
+		cout << ", \"sampled_sets\": " << simulator.getSampledSets() << ", \"sampled_references\": "
+			 << (statistics.sampledReferences ? statistics.sampledReferences : statistics.references)
+			 << ", \"hit_rate_error\": " << statistics.hitRateError << ", \"index\": \"" << INDEX_NAMES[options.index]
+			 << "\", \"victim_entries\": " << options.victimEntries << ", \"victim_hits\": " << statistics.victimHits;
+		if(options.intervalLength > 0) {			// The phases found, and the intervals themselves
+			cout << ", \"phases\": " << simulator.getNumPhases();
+			if(!separateIntervals) {
+				cout << ", \"intervals\": ";
+				simulator.printIntervals(cout,"json");
+			}
+		}
+		cout << "}" << endl;
+	}
+	return 0;
+}
+
+/*****************************************************************************
+Function name:    printUsage
+Purpose:          Prints the command line usage of the program
+Input parameters: program - string - the name the program was run as
+Return value:     none (Output directly printed to console)
+******************************************************************************/
+void printUsage(string program) {
+	cout << "Usage: " << program << "                 (interactive prompts)\n"
+		 << "       " << program << " --trace <file> [options]\n"
+		 << "Options (each may also be given as \"name = value\" in a --config file):\n"
+		 << "  --config <file>    read options from a file (later options override it)\n"
+		 << "  --trace <file>     text or binary memory reference trace\n"
+		 << "  --memory <bytes>   main memory size, up to 2^62 (default 32768)\n"
+		 << "  --cache <bytes>    cache size (default 1024)\n"
+		 << "  --block <bytes>    cache block size (default 16)\n"
+		 << "  --ways <n>         set-associativity (default 1)\n"
+		 << "  --policy <name>    replacement policy: L (LRU), F (FIFO), O (OPT), PLRU, BIT-PLRU,\n"
+		 << "                     SRRIP, BRRIP, DRRIP, RANDOM or LFU (default L)\n"
+		 << "  --seed <n>         seed of the RANDOM, BRRIP and DRRIP policies (default 1)\n"
+		 << "  --write <mode>     write-back (WB) or write-through (WT) (default write-back)\n"
+		 << "  --allocate <mode>  write-allocate (WA) or no-write-allocate (NWA) (default write-allocate)\n"
+		 << "  --hit-latency <n>  cycles taken by a cache hit (default 1)\n"
+		 << "  --miss-latency <n> cycles taken to detect a cache miss (default the hit latency)\n"
+		 << "  --memory-latency <n>  cycles taken to read a block from memory (default 100)\n"
+		 << "  --index <name>     set index: MODULO (low block number bits) or XOR (low bits XOR the bits\n"
+		 << "                     above them) (default MODULO)\n"
+		 << "  --victim <n>       blocks in a fully associative victim cache behind the cache, up to 64\n"
+		 << "                     (default 0, none)\n"
+		 << "  --prefetch <name>  prefetcher: NONE, NEXT-LINE, STRIDE (per 4 KB region) or STREAM\n"
+		 << "                     (default NONE)\n"
+		 << "  --prefetch-degree <n>    blocks prefetched per prediction, up to 16 (default 1)\n"
+		 << "  --prefetch-distance <n>  blocks (or strides) ahead of the access to prefetch (default 1)\n"
+		 << "  --classify <n>     classify misses as compulsory, capacity or conflict and list the n\n"
+		 << "                     blocks and sets with the most misses (default 0, off)\n"
+		 << "  --sample <rate>    simulate only this share of the sets, e.g. 0.01, and scale the results\n"
+		 << "                     up with a 95% confidence interval (default 1, every set)\n"
+		 << "  --interval <n>     record the hits, misses, dirty evictions, occupancy and working set of\n"
+		 << "                     every n references and detect phases (default 0, off)\n"
+		 << "  --interval-file <file>  write the intervals to a file (CSV, or JSON with --format json)\n"
+		 << "                     instead of with the results\n"
+		 << "  --fast-forward <n> warm the cache with the first n references of the trace without counting\n"
+		 << "                     them (default 0)\n"
+		 << "  --stop <n>         end the simulation after the first n references (default the whole trace)\n"
+		 << "  --checkpoint <file>  save the cache state, counts and trace position at the end, e.g. with\n"
+		 << "                     --fast-forward n --stop n to warm the cache up quickly\n"
+		 << "  --restore <file>   resume from a checkpoint of the same cache and trace\n"
+		 << "  --format <f>       text, csv or json (default text)\n"
+		 << "  --threads <n>      split the simulation by set over n threads (default 1)\n"
+		 << "  --steps            print the per-reference table (off by default)\n"
+		 << "  --quiet            print only the hit rates\n"
+		 << "  --optimal          also replay the trace under OPT for the best achievable hit rate on this\n"
+		 << "                     cache (off by default, as it reads the trace twice)\n"
+		 << "Tools: convert, sweep, batch, parallel, hierarchy, coherence, generate, bench\n"
+		 << "       (run with no further arguments for usage)"
+		 << endl;
+	return;
+}
+
+/*****************************************************************************
+Function name:    main
+Purpose:          Main program loop, get user input and outputs results
+Input parameters: argc - int - the number of command line arguments
+                  argv - char*[] - the command line arguments, used to select
+                                   a tool or run without prompts
+Return value:     int - returns 0 if program terminates with no errors
+******************************************************************************/
+int main(int argc, char* argv[]) {
+	// Options on the command line run a single simulation without any prompts
+	if(argc >= 2 && string(argv[1]).compare(0,2,"--") == 0) {
+		SimulationOptions options;
+		string error;
+		if(string(argv[1]) == "--help") {
+			printUsage(argv[0]);
+			return 0;
+		}
+		if(!parseCommandLine(argc,argv,options,error)) {
+			cerr << "Error: " << error << endl;
+			printUsage(argv[0]);
+			return 1;
+		}
+		return runWithOptions(options);
+	}
+	// 'convert <text trace> <binary trace> [raw]' converts a trace instead of simulating
+	if(argc >= 2 && string(argv[1]) == "convert") {
+		if(argc == 4 || (argc == 5 && string(argv[4]) == "raw")) {
+			return convertTrace(argv[2],argv[3],argc == 4);
+		}
+		cerr << "Usage: " << argv[0] << " convert <text trace> <binary trace> [raw]" << endl;
+		return 1;
+	}
+	// 'sweep <trace> <block size> <max cache size> [max associativity]' prints a miss ratio curve
+	if(argc >= 2 && string(argv[1]) == "sweep") {
+		if(argc >= 5 && argc <= 7) {
+			return sweepTrace(argv[2],atoi(argv[3]),atoi(argv[4]),argc >= 6 ? atoi(argv[5]) : 16,
+							  argc == 7 ? atof(argv[6]) : 1);
+		}
+		cerr << "Usage: " << argv[0] << " sweep <trace> <block size> <max cache size> "
+				"[max associativity (default 16)]\n                 [sampling rate, e.g. 0.01 for a SHARDS "
+				"estimate of the fully associative caches (default 1)]" << endl;
+		return 1;
+	}
+	// 'batch <trace> <configuration file> [threads]' simulates many configurations in parallel
+	if(argc >= 2 && string(argv[1]) == "batch") {
+		if(argc == 4 || argc == 5) {
+			int numThreads = (argc == 5) ? atoi(argv[4]) : (int)thread::hardware_concurrency();
+			return batchSimulate(argv[2],argv[3],numThreads);
+		}
+		cerr << "Usage: " << argv[0] << " batch <trace> <configuration file> [threads (default all cores)]\n"
+				"Each configuration line holds: memory size, cache size, block size, associativity, policy" << endl;
+		return 1;
+	}
+	// 'parallel <trace> <memory> <cache> <block> <ways> <policy> [threads]' splits one simulation by set
+	if(argc >= 2 && string(argv[1]) == "parallel") {
+		BatchConfiguration configuration = BatchConfiguration();
+		if(argc == 8 || argc == 9) {
+			configuration.memorySize = atoll(argv[3]);
+			configuration.cacheSize = atoi(argv[4]);
+			configuration.cacheBlockSize = atoi(argv[5]);
+			configuration.associativity = atoi(argv[6]);
+			int numThreads = (argc == 9) ? atoi(argv[8]) : (int)thread::hardware_concurrency();
+			if(isPowerOfTwo(configuration.memorySize,4,MAX_MEMORY_SIZE)
+			   && isPowerOfTwo(configuration.cacheSize,2,min(configuration.memorySize,(int64_t)MAX_CACHE_SIZE))
+			   && isPowerOfTwo(configuration.cacheBlockSize,2,configuration.cacheSize)
+			   && isPowerOfTwo(configuration.associativity,1,configuration.cacheSize/configuration.cacheBlockSize)
+			   && parsePolicy(argv[7],configuration.policy)) {
+				return parallelSimulate(argv[2],configuration,numThreads);
+			}
+		}
+		cerr << "Usage: " << argv[0] << " parallel <trace> <memory size> <cache size> <block size> "
+				"<associativity> <policy> [threads (default all cores)]" << endl;
+		return 1;
+	}
+	// 'hierarchy <trace> <level file>' simulates a multi-level cache hierarchy
+	if(argc >= 2 && string(argv[1]) == "hierarchy") {
+		if(argc == 4) return hierarchySimulate(argv[2],argv[3]);
+		cerr << "Usage: " << argv[0] << " hierarchy <trace> <level file>\n"
+				"Each level line, L1 first, holds: name (L1I for an instruction cache), cache size, "
+				"block size,\nassociativity, policy, then optionally INCLUSIVE, EXCLUSIVE or NINE (default), "
+				"WB (default) or WT,\nWA (default) or NWA, \"hit/miss\" latencies in cycles (default 1), an index "
+				"of MODULO (default),\nXOR, SKEWED or ZCACHE (the last two with LRU or FIFO), and a \"VICTIM=<n>\" "
+				"victim cache.\n\"MEMORY <cycles>\" sets the memory latency (default 100). \"TLB <name> <entries> "
+				"<ways> <policy>\n[hit/miss]\" lines, first level first, translate every address through TLBs and a "
+				"4-level page\ntable read through the data caches, with \"PAGE <4K, 2M or 1G>\" pages (default 4K)" << endl;
+		return 1;
+	}
+	// 'generate <pattern> <references> <footprint> <trace> [element size] [write %] [seed]' writes a
+	// synthetic trace
+	if(argc >= 2 && string(argv[1]) == "generate") {
+		TracePattern pattern;
+		if(argc >= 6 && argc <= 9 && parsePattern(argv[2],pattern)) {
+			int64_t numReferences = atoll(argv[3]);
+			int64_t footprint = atoll(argv[4]);
+			int elementSize = (argc >= 7) ? atoi(argv[6]) : 64;
+			int writePercent = (argc >= 8) ? atoi(argv[7]) : 25;
+			uint64_t seed = (argc == 9) ? strtoull(argv[8],NULL,10) : 1;
+			if(numReferences >= 0 && footprint >= elementSize && footprint <= MAX_MEMORY_SIZE && elementSize >= 1
+			   && writePercent >= 0 && writePercent <= 100) {
+				return generateTrace(pattern,numReferences,footprint,argv[5],elementSize,writePercent,seed);
+			}
+		}
+		cerr << "Usage: " << argv[0] << " generate <SEQUENTIAL, STRIDED, UNIFORM, ZIPFIAN or POINTER-CHASE> "
+				"<references>\n                 <footprint bytes> <binary trace> [element size or stride "
+				"(default 64)]\n                 [write percentage (default 25)] [seed (default 1)]\n"
+				"Sequential traces read consecutive words, the others whole elements" << endl;
+		return 1;
+	}
+	// 'bench <references> [filter]' times the simulator on synthetic traces
+	if(argc >= 2 && string(argv[1]) == "bench") {
+		if((argc == 3 || argc == 4) && atoll(argv[2]) >= 1) {
+			return benchmarkSimulator(atoll(argv[2]),(argc == 4) ? argv[3] : "");
+		}
+		cerr << "Usage: " << argv[0] << " bench <references per pass> [filter]\n"
+				"Times the cache set access, simulation step and trace replay over every policy, several\n"
+				"geometries and every synthetic trace pattern, running only benchmarks whose names contain "
+				"the filter" << endl;
+		return 1;
+	}
+	// 'coherence <trace> <protocol> <cache> <block> <ways> <policy> [hot lines]' simulates per-core caches
+	if(argc >= 2 && string(argv[1]) == "coherence") {
+		CoherenceProtocol protocol;
+		ReplacementPolicy policy;
+		if((argc == 8 || argc == 9) && parseProtocol(argv[3],protocol) && parsePolicy(argv[7],policy)) {
+			int cacheSize = atoi(argv[4]);
+			int cacheBlockSize = atoi(argv[5]);
+			int associativity = atoi(argv[6]);
+			int hotLines = (argc == 9) ? atoi(argv[8]) : 10;
+			if(isPowerOfTwo(cacheSize,2,MAX_CACHE_SIZE) && isPowerOfTwo(cacheBlockSize,2,cacheSize)
+			   && isPowerOfTwo(associativity,1,cacheSize/cacheBlockSize) && policy != OPT && hotLines >= 0) {
+				return coherenceSimulate(argv[2],protocol,cacheSize,cacheBlockSize,associativity,policy,hotLines);
+			}
+		}
+		cerr << "Usage: " << argv[0] << " coherence <trace> <MESI or MOESI> <cache size> <block size> "
+				"<associativity> <policy (not OPT)>\n                 [hot lines (default 10, 0 for all)]\n"
+				"Each trace line may start with the number of the core making the reference "
+				"(0 to 63, default 0)" << endl;
+		return 1;
+	}
+	UserInterface interface;						// Instantiate interface object
+	do {											// Repeat until user terminates
+		// Prompt user for integer size / associativity inputs
+		int64_t memorySize = interface.valuePrompt("Enter the size of main memory in bytes: ",4,MAX_MEMORY_SIZE);
+		int cacheSize = interface.valuePrompt("Enter the size of the cache in bytes: ",2,
+											  min(memorySize,(int64_t)MAX_CACHE_SIZE));
+		int cacheBlockSize = interface.valuePrompt("Enter the cache block/line size: ",2,cacheSize);
+		int cacheBlocks = cacheSize/cacheBlockSize;	// Number of cache blocks is size over block size 
+		cout << endl;								// Print blank line for spacing
+		int associativity = interface.valuePrompt("Enter the degree of set-associativity "
+									"(input n for an n-way set-associative mapping): ",1,cacheBlocks);
+		// Prompt user for replacement policy
+		ReplacementPolicy policy = interface.replacementPolicyPrompt();
+		// Prompt user for memory reference file and open it for streaming
+		TraceReader traceReader;
+		interface.memoryReferenceFilePrompt(memorySize,traceReader);
+		// Prompt user for whether to replay the trace under OPT for the best achievable hit rate
+		bool optimal = interface.optimalPrompt();
+		
+		cout << endl << "Simulator Output:" << endl;
+		// Create simulator with user provided cache and main memory sizes and layout
+		MemorySimulator simulator(memorySize,cacheSize,cacheBlockSize,associativity,policy);
+		simulator.printMemoryInfo();				// Print information about the memory devices buses
+		simulator.runSimulation(traceReader,optimal);	// Run simulation with memory references from file
+		simulator.printCache();						// Print the final state of the cache device
+	} while(interface.repeatPrompt());				// Prompt user and conditionally restart program
+	return 0;
+}
+#endif
@@ -0,0 +1,149 @@
+/*
+  Memory Simulator library interface
+  Lets other programs (binary instrumentation, a JIT's cost model...) simulate a cache on references
+  they generate themselves, many at a time, without the simulator printing anything. Only the types
+  below are exposed, so programs built against this header keep working as the simulator changes:
+  the library object defines no other external names.
+
+  Build:	g++ -std=c++11 -Wall -O2 -march=native -pthread -DMEM_SIMULATOR_LIBRARY -c mem_simulator.cpp
+  			(MEM_SIMULATOR_LIBRARY leaves out main and the command line tools and gives the rest of the
+  			simulator internal linkage, so the object links into another program)
+  Use:		CacheConfiguration configuration;
+  			configuration.cacheSize = 32768;
+  			CacheSimulator simulator;
+  			std::string error;
+  			if(!simulator.configure(configuration,error)) ...
+  			simulator.access(addresses,operations,count,results);
+  			CacheStatistics statistics = simulator.getStatistics();
+*/
+
+#ifndef MEM_SIMULATOR_H
+#define MEM_SIMULATOR_H
+
+#include <cstddef>									// Imported for sizes (size_t)
+#include <cstdint>									// Imported for fixed width integers (uint64_t)
+#include <string>									// Imported for error descriptions
+
+// The version of this interface, raised whenever a type below changes
+#define MEM_SIMULATOR_API_VERSION 2
+
+// The operation of each reference given to CacheSimulator::access, the same values as the
+// simulator's traces
+const uint8_t CACHE_READ = 0;
+const uint8_t CACHE_WRITE = 1;
+const uint8_t CACHE_FETCH = 2;						// An instruction fetch, simulated as a read
+
+/*****************************************************************************
+Struct name:      CacheConfiguration
+Purpose:          Describes the cache to simulate. Sizes are powers of two in
+                  bytes, and the names are those of the command line options
+******************************************************************************/
+struct CacheConfiguration {
+	int64_t memorySize = (int64_t)1 << 48;			// References to addresses at or above this size
+													// are rejected rather than simulated
+	int cacheSize = 32768;							// The size of the cache, up to 2^30
+	int cacheBlockSize = 64;						// The size of the cache blocks
+	int associativity = 8;							// The degree of set-associativity
+	const char* policy = "LRU";						// Replacement policy: any but OPT, which needs a
+													// whole trace
+	const char* writePolicy = "WB";					// WB (write-back) or WT (write-through)
+	const char* writeAllocation = "WA";				// WA (write-allocate) or NWA
+	const char* index = "MODULO";					// Set index function: MODULO or XOR
+	int victimEntries = 0;							// Blocks in a victim cache, up to 64 (0 for none)
+	const char* prefetcher = "NONE";				// NONE, NEXT-LINE, STRIDE or STREAM
+	int prefetchDegree = 1;							// The blocks requested by one prediction
+	int prefetchDistance = 1;						// How far ahead the first requested block is
+	int hitLatency = 1;								// Cycles taken by a cache hit
+	int missLatency = 1;							// Cycles taken to detect a cache miss
+	int memoryLatency = 100;						// Cycles taken to read a block from memory
+	uint64_t seed = 1;								// Seed of the random replacement policies
+};
+
+/*****************************************************************************
+Struct name:      CacheStatistics
+Purpose:          The counts of every reference simulated since the cache was
+                  configured or its statistics were last reset
+******************************************************************************/
+struct CacheStatistics {
+	int64_t references = 0;							// The number of references simulated
+	int64_t hits = 0;								// The number of those that hit
+	int64_t victimHits = 0;							// Hits found in the victim cache
+	int64_t blocksRead = 0;							// Blocks filled from main memory
+	int64_t dirtyEvictions = 0;						// Dirty blocks written back to main memory
+	int64_t wordsWritten = 0;						// Writes sent to main memory without a block
+	int64_t prefetches = 0;							// Blocks filled by the prefetcher
+	int64_t usefulPrefetches = 0;					// Prefetched blocks used before being replaced
+	int64_t rejected = 0;							// References not simulated, as their addresses
+													// were not below the memory size
+	int64_t bytesRead = 0;							// Bytes read from main memory
+	int64_t bytesWritten = 0;						// Bytes written to main memory
+	double hitRate = 0;								// The hit rate in percent
+	double averageAccessTime = 0;					// The average memory access time in cycles
+};
+
+/*****************************************************************************
+******************************************************************************
+Class name:       CacheSimulator
+Purpose:          Simulates one cache on batches of references. The cache is
+                  held behind a pointer, so its size never changes this class
+******************************************************************************/
+class CacheSimulator {
+	public:
+		CacheSimulator();
+		~CacheSimulator();
+
+/*****************************************************************************
+Function name:    configure
+Purpose:          Creates an empty cache, replacing any cache configured before
+Input parameters: configuration - const CacheConfiguration& - the cache
+                  error - std::string& - set to a description of any error
+Return value:     bool - true if the configuration is valid, false if not
+******************************************************************************/
+		bool configure(const CacheConfiguration& configuration, std::string& error);
+
+/*****************************************************************************
+Function name:    access
+Purpose:          Simulates a batch of references in order, with the policy
+                  and geometry chosen once for the whole batch. References to
+                  addresses not below the memory size are skipped and
+                  counted as rejected
+Input parameters: addresses - const uint64_t* - the byte address of each
+                                                reference
+                  operations - const uint8_t* - CACHE_READ, CACHE_WRITE or
+                                                CACHE_FETCH for each
+                                                reference, or NULL if every
+                                                reference is a read
+                  count - size_t - the number of references
+                  results - uint8_t* - set to 1 for each reference that hit
+                                       and 0 for each miss or rejected
+                                       reference, or NULL
+Return value:     size_t - the number of references in the batch that hit
+                           (0 if no cache is configured)
+******************************************************************************/
+		size_t access(const uint64_t* addresses, const uint8_t* operations, size_t count, uint8_t* results);
+
+/*****************************************************************************
+Function name:    getStatistics
+Purpose:          Gets the counts of the references simulated so far
+Input parameters: none
+Return value:     CacheStatistics - the counts, hit rate and access time
+******************************************************************************/
+		CacheStatistics getStatistics() const;
+
+/*****************************************************************************
+Function name:    resetStatistics
+Purpose:          Zeroes the counts, keeping the cache's contents, for example
+                  after warming it up
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void resetStatistics();
+	private:
+		class Implementation;						// The simulator and its statistics
+		Implementation* implementation;				// The configured cache, or NULL
+
+		CacheSimulator(const CacheSimulator&);		// Not copyable, as it owns the cache
+		CacheSimulator& operator=(const CacheSimulator&);
+};
+
+#endif
@@ -0,0 +1,439 @@
+/*
+  Memory Simulator trace capture
+  The rings, the flushing thread and the trace file behind trace_capture.h. Link this file into the
+  program being traced; it does not need the simulator itself.
+*/
+
+#include "trace_capture.h"
+
+#include <chrono>									// Imported for the flush interval (milliseconds)
+#include <cstring>									// Imported for raw memory operations (memcpy)
+#include <fstream>									// Imported for writing the trace (ofstream)
+#include <mutex>									// Imported for registering threads (mutex)
+#include <thread>									// Imported for the flushing thread (thread)
+#include <vector>									// Imported for the registered rings (vector)
+
+using namespace std;
+
+// The simulator's binary trace format (see TraceWriter in mem_simulator.cpp), which must match it:
+// a 16 byte header of the magic "MSTR", a 16-bit version, 16-bit flags and the 64-bit number of
+// references, then one record per reference
+const char TRACE_MAGIC[4] = {'M','S','T','R'};
+const uint16_t TRACE_VERSION = 1;
+const uint16_t TRACE_DELTA_ENCODED = 1;				// Flag bit for delta/varint encoded records
+const uint16_t TRACE_FETCH_OPERATIONS = 2;			// Flag bit for records with 2-bit operations
+const uint16_t TRACE_CORE_IDS = 4;					// Flag bit for records with a core byte
+const int TRACE_HEADER_SIZE = 16;
+const int MAX_RECORD_SIZE = 11;						// A core byte and a 64-bit varint
+const int64_t MAX_FETCH_TRACE_ADDRESS = (int64_t)1 << 61;	// Addresses of records with 2-bit
+															// operations stay below this (the
+															// simulator's limit of the same name)
+
+// Largest ring accepted, so a mistyped size cannot take all the memory (2^26 entries is 512 MB)
+const uint32_t MAX_RING_ENTRIES = 1 << 26;
+
+std::atomic<uint64_t> traceCaptureEpoch(0);
+__thread TraceCaptureRing* traceCaptureRing = NULL;
+
+/*****************************************************************************
+Function name:    releaseRing
+Purpose:          Lets go of a ring for its thread or for the capture, freeing
+                  it once neither holds it
+Input parameters: ring - TraceCaptureRing* - the ring
+Return value:     none
+******************************************************************************/
+static void releaseRing(TraceCaptureRing* ring) {
+	if(ring->owners.fetch_sub(1,memory_order_acq_rel) == 1) {
+		delete[] ring->entries;
+		delete ring;
+	}
+	return;
+}
+
+/*****************************************************************************
+Struct name:      RingOwner
+Purpose:          Holds the calling thread's ring, marking it finished and
+                  letting go of it when the thread exits
+******************************************************************************/
+struct RingOwner {
+	TraceCaptureRing* ring = NULL;					// The thread's ring, or NULL
+
+	~RingOwner() {
+		if(ring) {
+			ring->finished.store(true,memory_order_release);
+			releaseRing(ring);
+		}
+		traceCaptureRing = NULL;
+	}
+};
+
+static thread_local RingOwner ringOwner;
+
+/*****************************************************************************
+******************************************************************************
+Class name:       TraceCapture
+Purpose:          The running capture: the registered rings and the thread
+                  flushing them to the trace file. The flusher drains each
+                  ring in turn, so references of one thread keep their order
+                  but the threads' references are interleaved a flush at a
+                  time rather than in the exact order they happened
+******************************************************************************/
+class TraceCapture {
+	public:
+/*****************************************************************************
+Function name:    start
+Purpose:          Opens the trace file and starts the flushing thread
+Input parameters: captureOptions - const TraceCaptureOptions& - the settings
+                  epoch - uint64_t - the number of this capture
+                  error - string& - set to a description of any error
+Return value:     bool - true if the capture started, false if not
+******************************************************************************/
+		bool start(const TraceCaptureOptions& captureOptions, uint64_t epoch, string& error) {
+			if(!captureOptions.file || !*captureOptions.file) {
+				error = "no trace file given";
+				return false;
+			}
+			if(captureOptions.ringEntries < 2 || captureOptions.ringEntries > MAX_RING_ENTRIES
+			   || (captureOptions.ringEntries & (captureOptions.ringEntries - 1)) != 0) {
+				error = "the ring entries must be a power of two from 2 to " + to_string(MAX_RING_ENTRIES);
+				return false;
+			}
+			if(captureOptions.flushMilliseconds < 1) {
+				error = "the flush interval must be at least 1 millisecond";
+				return false;
+			}
+			outputFile.open(captureOptions.file,ios::out | ios::binary | ios::trunc);
+			if(!outputFile) {
+				error = string("cannot create ") + captureOptions.file;
+				return false;
+			}
+			options = captureOptions;
+			captureEpoch = epoch;
+			flags = (options.deltaEncoded ? TRACE_DELTA_ENCODED : 0) | (options.fetches ? TRACE_FETCH_OPERATIONS : 0)
+					| (options.threadIds ? TRACE_CORE_IDS : 0);
+			operationBits = options.fetches ? 2 : 1;
+			previousAddress = 0;
+			statistics = TraceCaptureStatistics();
+			stopping = false;
+			writeHeader();							// The reference count is filled in by stop
+			flusher = thread(&TraceCapture::flushLoop,this);
+			return true;
+		}
+
+/*****************************************************************************
+Function name:    stop
+Purpose:          Stops the flushing thread after a last flush of every ring,
+                  lets go of the rings and finishes the trace file
+Input parameters: finalStatistics - TraceCaptureStatistics* - set to the
+                                    counts of the capture, or NULL
+Return value:     bool - true if the whole trace was written successfully
+******************************************************************************/
+		bool stop(TraceCaptureStatistics* finalStatistics) {
+			{
+				lock_guard<mutex> lock(ringsMutex);
+				stopping = true;
+			}
+			flusher.join();
+			flush(true);
+			for(size_t i = 0; i < rings.size(); i++) retire(rings[i]);
+			rings.clear();
+			outputFile.seekp(0);					// Rewrite the header with the final count
+			writeHeader();
+			bool success = (bool)outputFile;
+			outputFile.close();
+			if(finalStatistics) *finalStatistics = statistics;
+			return success;
+		}
+
+/*****************************************************************************
+Function name:    registerThread
+Purpose:          Creates the calling thread's ring and hands it to the flusher
+Input parameters: none
+Return value:     TraceCaptureRing* - the ring, or NULL if the capture is
+                                      stopping
+******************************************************************************/
+		TraceCaptureRing* registerThread() {
+			TraceCaptureRing* ring = new TraceCaptureRing();
+			ring->entries = new uint64_t[options.ringEntries]();	// Zeroed, so its pages are mapped now
+			ring->mask = options.ringEntries - 1;
+			ring->epoch = captureEpoch;
+			ring->recording = true;
+			ring->dropWhenFull = options.dropWhenFull;
+			ring->sampleOn = options.sampleOn;
+			ring->sampleOff = options.sampleOff;
+			// Without sampling the burst never ends
+			ring->remaining = (options.sampleOn > 0 && options.sampleOff > 0) ? options.sampleOn : UINT64_MAX;
+			ring->cachedTail = 0;
+			ring->head.store(0,memory_order_relaxed);
+			ring->tail.store(0,memory_order_relaxed);
+			ring->dropped.store(0,memory_order_relaxed);
+			ring->finished.store(false,memory_order_relaxed);
+			ring->owners.store(2,memory_order_relaxed);	// The thread and the capture
+			lock_guard<mutex> lock(ringsMutex);
+			if(stopping) {
+				delete[] ring->entries;
+				delete ring;
+				return NULL;
+			}
+			ring->core = statistics.threads++ % TRACE_CAPTURE_MAX_CORES;
+			rings.push_back(ring);
+			return ring;
+		}
+	private:
+		TraceCaptureOptions options;				// The settings of the capture
+		uint64_t captureEpoch;						// The number of this capture
+		ofstream outputFile;						// The trace file being written
+		uint16_t flags;								// The header flags of the trace
+		int operationBits;							// Low record bits holding the operation
+		int64_t previousAddress;					// Last written address (for delta encoding)
+		TraceCaptureStatistics statistics;			// The counts so far
+		vector<TraceCaptureRing*> rings;			// Every registered ring not yet retired
+		mutex ringsMutex;							// Guards rings, stopping and the thread count
+		bool stopping;								// Whether new threads are turned away
+		thread flusher;								// The thread flushing the rings
+		vector<char> buffer;						// Records encoded but not yet written
+
+/*****************************************************************************
+Function name:    flushLoop
+Purpose:          Flushes the rings every interval until the capture stops
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void flushLoop() {
+			while(true) {
+				{
+					lock_guard<mutex> lock(ringsMutex);
+					if(stopping) return;
+				}
+				flush(false);
+				this_thread::sleep_for(chrono::milliseconds(options.flushMilliseconds));
+			}
+		}
+
+/*****************************************************************************
+Function name:    flush
+Purpose:          Writes the references waiting in every ring to the trace,
+                  retiring the rings of threads that have exited
+Input parameters: last - bool - whether this is the final flush, when no
+                                thread registers any more
+Return value:     none
+******************************************************************************/
+		void flush(bool last) {
+			vector<TraceCaptureRing*> current;		// The rings at the start of this flush
+			{
+				lock_guard<mutex> lock(ringsMutex);
+				current = rings;
+			}
+			vector<TraceCaptureRing*> exited;		// Emptied rings of exited threads
+			for(size_t i = 0; i < current.size(); i++) {
+				TraceCaptureRing* ring = current[i];
+				// Read before draining: a thread marked finished has already added its last reference
+				bool finished = ring->finished.load(memory_order_acquire);
+				drain(ring);
+				if(finished && !last) exited.push_back(ring);
+			}
+			if(!buffer.empty()) {
+				outputFile.write(buffer.data(),buffer.size());
+				buffer.clear();
+			}
+			if(exited.empty()) return;
+			lock_guard<mutex> lock(ringsMutex);
+			for(size_t i = 0; i < exited.size(); i++) {
+				for(size_t j = 0; j < rings.size(); j++) {
+					if(rings[j] == exited[i]) {
+						rings[j] = rings.back();
+						rings.pop_back();
+						break;
+					}
+				}
+				retire(exited[i]);
+			}
+			return;
+		}
+
+/*****************************************************************************
+Function name:    drain
+Purpose:          Encodes the references waiting in a ring and gives their
+                  entries back to its thread
+Input parameters: ring - TraceCaptureRing* - the ring
+Return value:     none
+******************************************************************************/
+		void drain(TraceCaptureRing* ring) {
+			uint64_t tail = ring->tail.load(memory_order_relaxed);
+			uint64_t head = ring->head.load(memory_order_acquire);
+			size_t used = buffer.size();
+			buffer.resize(used + (head - tail)*MAX_RECORD_SIZE);	// Room for the longest records
+			char* record = buffer.data() + used;
+			for(; tail != head; tail++) {
+				uint64_t entry = ring->entries[tail & ring->mask];
+				uint8_t operation = entry & 3;
+				if(!options.fetches && operation == TRACE_CAPTURE_FETCH) operation = TRACE_CAPTURE_READ;
+				int64_t address = (int64_t)(entry >> 2);	// The ring keeps the low 62 bits
+				if(options.fetches) address &= MAX_FETCH_TRACE_ADDRESS - 1;	// And fetch traces 61
+				record += encode(address,operation,ring->core,record);
+			}
+			ring->tail.store(tail,memory_order_release);
+			buffer.resize(record - buffer.data());
+			return;
+		}
+
+/*****************************************************************************
+Function name:    encode
+Purpose:          Encodes one reference's record, the same encoding as the
+                  simulator's TraceWriter::write
+Input parameters: memoryAddress - int64_t - the address being referenced
+                  operation - uint8_t - the operation of the reference
+                  core - int - the core making the reference
+                  record - char* - where to put the record, with room for
+                                   MAX_RECORD_SIZE bytes
+Return value:     int - the length of the record in bytes
+******************************************************************************/
+		int encode(int64_t memoryAddress, uint8_t operation, int core, char* record) {
+			int length = 0;
+			if(flags & TRACE_CORE_IDS) record[length++] = (char)core;
+			if(flags & TRACE_DELTA_ENCODED) {
+				int64_t delta = memoryAddress - previousAddress;
+				previousAddress = memoryAddress;
+				// Zigzag encode the delta so small negative steps are small numbers too
+				uint64_t value = (((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63)) << operationBits | operation;
+				while(value >= 0x80) {				// Emit 7 bits at a time, low bits first
+					record[length++] = (char)(value | 0x80);
+					value >>= 7;
+				}
+				record[length++] = (char)value;
+			}
+			else {
+				uint64_t value = (uint64_t)memoryAddress << operationBits | operation;
+				memcpy(record + length,&value,sizeof(value));
+				length += sizeof(value);
+			}
+			statistics.written++;
+			return length;
+		}
+
+/*****************************************************************************
+Function name:    retire
+Purpose:          Adds a drained ring's counts to the statistics and lets go
+                  of it for the capture. Only the references drained count
+                  as captured; any its thread added after the last drain, as
+                  the capture stopped, are counted as late instead
+Input parameters: ring - TraceCaptureRing* - the ring
+Return value:     none
+******************************************************************************/
+		void retire(TraceCaptureRing* ring) {
+			uint64_t tail = ring->tail.load(memory_order_relaxed);
+			statistics.captured += tail;
+			statistics.late += ring->head.load(memory_order_acquire) - tail;
+			statistics.dropped += ring->dropped.load(memory_order_relaxed);
+			releaseRing(ring);
+			return;
+		}
+
+/*****************************************************************************
+Function name:    writeHeader
+Purpose:          Writes the trace header at the current file position
+Input parameters: none
+Return value:     none
+******************************************************************************/
+		void writeHeader() {
+			char header[TRACE_HEADER_SIZE];
+			memcpy(header,TRACE_MAGIC,4);
+			memcpy(header + 4,&TRACE_VERSION,sizeof(TRACE_VERSION));
+			memcpy(header + 6,&flags,sizeof(flags));
+			memcpy(header + 8,&statistics.written,sizeof(statistics.written));
+			outputFile.write(header,TRACE_HEADER_SIZE);
+			return;
+		}
+};
+
+// The running capture, guarded by captureMutex for starting, stopping and registering threads
+static TraceCapture* capture = NULL;
+static mutex captureMutex;
+static uint64_t lastEpoch = 0;
+
+/*****************************************************************************
+Function name:    traceCaptureStart
+Purpose:          Starts capturing the references of every thread to a trace
+Input parameters: options - const TraceCaptureOptions& - the settings
+                  error - std::string& - set to a description of any error
+Return value:     bool - true if the capture started, false if it could not
+                         or a capture is already running
+******************************************************************************/
+bool traceCaptureStart(const TraceCaptureOptions& options, std::string& error) {
+	lock_guard<mutex> lock(captureMutex);
+	if(capture) {
+		error = "a capture is already running";
+		return false;
+	}
+	TraceCapture* newCapture = new TraceCapture();
+	if(!newCapture->start(options,lastEpoch + 1,error)) {
+		delete newCapture;
+		return false;
+	}
+	capture = newCapture;
+	traceCaptureEpoch.store(++lastEpoch,memory_order_release);
+	return true;
+}
+
+/*****************************************************************************
+Function name:    traceCaptureStop
+Purpose:          Stops the capture and finishes its trace. References made
+                  while it stops may be left out
+Input parameters: statistics - TraceCaptureStatistics* - set to the counts of
+                                                         the capture, or NULL
+Return value:     bool - true if the whole trace was written, false if not or
+                         no capture was running
+******************************************************************************/
+bool traceCaptureStop(TraceCaptureStatistics* statistics) {
+	lock_guard<mutex> lock(captureMutex);
+	if(!capture) return false;
+	traceCaptureEpoch.store(0,memory_order_release);
+	bool success = capture->stop(statistics);
+	delete capture;
+	capture = NULL;
+	return success;
+}
+
+/*****************************************************************************
+Function name:    traceCaptureRecordSlow
+Purpose:          Records a reference the inline path could not: registers the
+                  thread on its first reference of a capture, switches the
+                  sampling between recording and skipping, and waits for (or
+                  drops the reference when) the thread's ring is full
+Input parameters: address - uint64_t - the byte address referenced
+                  operation - uint8_t - TRACE_CAPTURE_READ, _WRITE or _FETCH
+Return value:     none
+******************************************************************************/
+void traceCaptureRecordSlow(uint64_t address, uint8_t operation) {
+	uint64_t epoch = traceCaptureEpoch.load(memory_order_acquire);
+	if(epoch == 0) return;							// No capture running
+	TraceCaptureRing* ring = traceCaptureRing;
+	if(!ring || ring->epoch != epoch) {				// First reference of this capture
+		lock_guard<mutex> lock(captureMutex);
+		if(!capture || traceCaptureEpoch.load(memory_order_relaxed) != epoch) return;
+		if(ringOwner.ring) {						// Left over from an earlier capture
+			ringOwner.ring->finished.store(true,memory_order_release);
+			releaseRing(ringOwner.ring);
+		}
+		ring = ringOwner.ring = traceCaptureRing = capture->registerThread();
+		if(!ring) return;
+	}
+	bool record = ring->recording;
+	if(--ring->remaining == 0) {					// End of the sampling burst or gap
+		ring->recording = !ring->recording;
+		ring->remaining = ring->recording ? ring->sampleOn : ring->sampleOff;
+	}
+	if(!record) return;
+	uint64_t head = ring->head.load(memory_order_relaxed);
+	while(head - (ring->cachedTail = ring->tail.load(memory_order_acquire)) > ring->mask) {
+		if(ring->dropWhenFull) {
+			ring->dropped.fetch_add(1,memory_order_relaxed);
+			return;
+		}
+		if(traceCaptureEpoch.load(memory_order_relaxed) != epoch) return;
+		this_thread::yield();						// Wait for the flusher to make room
+	}
+	ring->entries[head & ring->mask] = address << 2 | operation;
+	ring->head.store(head + 1,memory_order_release);
+	return;
+}
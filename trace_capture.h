@@ -0,0 +1,151 @@
+/*
+  Memory Simulator trace capture
+  Records the loads and stores of an instrumented program as a binary trace the simulator reads
+  directly. Each thread appends its references to its own ring buffer without locks, and a
+  background thread flushes the rings to the trace file, so a reference costs a few instructions.
+
+  Build:	g++ -std=c++11 -O2 -pthread program.cpp trace_capture.cpp -o program
+  			(define TRACE_CAPTURE_DISABLED to compile the macros out of the program)
+  Use:		TraceCaptureOptions options;
+  			options.file = "program.bin";
+  			std::string error;
+  			if(!traceCaptureStart(options,error)) ...
+  			TRACE_LOAD(&array[i]);  TRACE_STORE(&total);  ...
+  			traceCaptureStop(NULL);
+  Simulate:	./Lab7.out --trace program.bin --memory 281474976710656 ...
+  			(the addresses are virtual, so the memory size must cover the address space, 2^48 on x86-64)
+  			./Lab7.out coherence program.bin MESI 32768 64 8 L	(each thread is a core)
+  Check:	g++ -std=c++11 -O1 -g -pthread -fsanitize=thread -I. checks/trace_capture_check.cpp trace_capture.cpp
+  			(captures known references from many threads and checks the traces written)
+*/
+
+#ifndef TRACE_CAPTURE_H
+#define TRACE_CAPTURE_H
+
+#include <atomic>									// Imported for the ring positions (atomic)
+#include <cstddef>									// Imported for sizes (size_t)
+#include <cstdint>									// Imported for fixed width integers (uint64_t)
+#include <string>									// Imported for error descriptions
+
+// The operation of a captured reference, the same values as the simulator's traces
+const uint8_t TRACE_CAPTURE_READ = 0;
+const uint8_t TRACE_CAPTURE_WRITE = 1;
+const uint8_t TRACE_CAPTURE_FETCH = 2;				// Recorded as a read unless fetches are kept
+
+// The simulator tells at most this many cores apart, so later threads share their core numbers
+const int TRACE_CAPTURE_MAX_CORES = 64;
+
+/*****************************************************************************
+Struct name:      TraceCaptureOptions
+Purpose:          The settings of a capture
+******************************************************************************/
+struct TraceCaptureOptions {
+	const char* file = "trace.bin";					// The trace file to write
+	bool deltaEncoded = true;						// Delta/varint encoded records, typically 2-3
+													// bytes each, or raw 8 byte records
+	bool threadIds = true;							// Store each thread's number as its core, for
+													// the coherence tool
+	bool fetches = false;							// Keep instruction fetches apart from reads
+														// (addresses then keep their low 61 bits
+														// rather than 62, as the trace format needs)
+	uint32_t sampleOn = 0;							// Burst sampling: record this many references
+	uint32_t sampleOff = 0;							// of each thread, then skip this many (0 for
+													// every reference)
+	uint32_t ringEntries = 1 << 16;					// References buffered per thread, a power of two
+	int flushMilliseconds = 1;						// How often the rings are flushed
+	bool dropWhenFull = false;						// Drop references while a thread's ring is full
+													// rather than wait for the flush
+};
+
+/*****************************************************************************
+Struct name:      TraceCaptureStatistics
+Purpose:          The counts of a finished capture
+******************************************************************************/
+struct TraceCaptureStatistics {
+	uint64_t captured = 0;							// References taken from the rings
+	uint64_t written = 0;							// References written to the trace
+	uint64_t dropped = 0;							// References dropped while a ring was full
+	uint64_t late = 0;								// References added to a ring after its last
+													// flush, as the capture stopped, so left out
+													// (a thread may still be adding more)
+	int threads = 0;								// Threads that recorded references
+};
+
+/*****************************************************************************
+Struct name:      TraceCaptureRing
+Purpose:          One thread's buffer of references, which only that thread
+                  appends to and only the flushing thread removes from. The
+                  positions count every reference ever added and removed, and
+                  each is written by one thread, so no lock is needed
+******************************************************************************/
+struct TraceCaptureRing {
+	uint64_t* entries;								// (address << 2) | operation of each reference
+	uint64_t mask;									// Selects an entry from a position
+	uint64_t epoch;									// The capture the ring belongs to
+	int core;										// The core number stored with its references
+	bool recording;									// Whether the sampling is recording references
+	bool dropWhenFull;								// Drop references while the ring is full
+	uint64_t remaining;								// References left in the sampling burst or gap
+	uint64_t sampleOn;								// References in a sampling burst
+	uint64_t sampleOff;								// References in a sampling gap
+	uint64_t cachedTail;							// The last tail read, to avoid reading it often
+	std::atomic<uint64_t> head;						// References added, written by the thread
+	char separation[64];							// Keeps the flusher's writes below off the
+													// cache line of the thread's fields above
+	std::atomic<uint64_t> tail;						// References flushed, written by the flusher
+	std::atomic<uint64_t> dropped;					// References dropped while the ring was full
+	std::atomic<bool> finished;						// Whether the thread has exited
+	std::atomic<int> owners;						// The thread and the capture, whichever lets
+													// go last frees the ring
+};
+
+// The running capture's number, or 0 if none is running, and the calling thread's ring. The ring
+// is __thread rather than thread_local, which would check on every reference whether another file
+// initializes it
+extern std::atomic<uint64_t> traceCaptureEpoch;
+extern __thread TraceCaptureRing* traceCaptureRing;
+
+bool traceCaptureStart(const TraceCaptureOptions& options, std::string& error);
+bool traceCaptureStop(TraceCaptureStatistics* statistics);
+void traceCaptureRecordSlow(uint64_t address, uint8_t operation);
+
+/*****************************************************************************
+Function name:    traceCaptureRecord
+Purpose:          Records one reference of the calling thread. The common case
+                  (the thread's ring has room and sampling is not changing
+                  between recording and skipping) is handled here, inline;
+                  everything else, including the thread's first reference,
+                  goes to traceCaptureRecordSlow
+Input parameters: address - uint64_t - the byte address referenced
+                  operation - uint8_t - TRACE_CAPTURE_READ, _WRITE or _FETCH
+Return value:     none
+******************************************************************************/
+inline void traceCaptureRecord(uint64_t address, uint8_t operation) {
+	TraceCaptureRing* ring = traceCaptureRing;
+	if(ring && ring->remaining > 1 && ring->epoch == traceCaptureEpoch.load(std::memory_order_relaxed)) {
+		if(!ring->recording) {						// Skipped by the sampling
+			ring->remaining--;
+			return;
+		}
+		uint64_t head = ring->head.load(std::memory_order_relaxed);
+		if(head - ring->cachedTail <= ring->mask) {	// Room without reading the flusher's position
+			ring->remaining--;
+			ring->entries[head & ring->mask] = address << 2 | operation;
+			ring->head.store(head + 1,std::memory_order_release);
+			return;
+		}
+	}
+	traceCaptureRecordSlow(address,operation);
+}
+
+#ifdef TRACE_CAPTURE_DISABLED
+#define TRACE_LOAD(address) ((void)0)
+#define TRACE_STORE(address) ((void)0)
+#define TRACE_FETCH(address) ((void)0)
+#else
+#define TRACE_LOAD(address) traceCaptureRecord((uint64_t)(uintptr_t)(address),TRACE_CAPTURE_READ)
+#define TRACE_STORE(address) traceCaptureRecord((uint64_t)(uintptr_t)(address),TRACE_CAPTURE_WRITE)
+#define TRACE_FETCH(address) traceCaptureRecord((uint64_t)(uintptr_t)(address),TRACE_CAPTURE_FETCH)
+#endif
+
+#endif